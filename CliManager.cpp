@@ -8,14 +8,20 @@
 
 #include "include/save/GameSave.h"
 #include "include/save/Savestate.h"
+#include "include/save/Rewind.h"
+#include "include/debugger/Profiler.h"
+#include "include/debugger/GuestProfiler.h"
+#include "include/debugger/Tracer.h"
 
 #include <vector>
+#include <fstream>
 #include <fmt/format.h>
 
 using EmulatorState = GameboyEmu::State::EmulatorState;
 using Cpu = GameboyEmu::CPU::Cpu;
 using PPU = GameboyEmu::Graphics::PPU;
 using Memory = GameboyEmu::Mem::Memory;
+using Profiler = GameboyEmu::Debugger::Profiler;
 using GameboyEmu::CPU::Disassemble;
 
 std::vector<word> parseHexadecimal(
@@ -170,6 +176,104 @@ void CliManager::init_commands() {
 
     pointerToRoot->Insert(std::move(breakpoints));
 
+    auto watchpoints = std::make_unique<cli::Menu>("wp");
+
+    watchpoints->Insert("disable", std::move([this](std::ostream& out) {
+        this->debugger->DisableWatchpoints();
+    }));
+
+    watchpoints->Insert("enable", std::move([this](std::ostream& out) {
+        this->debugger->EnableWatchpoints();
+    }));
+
+    //The emulation thread reads the watchpoints on every
+    //access, they only change while it is stopped
+    watchpoints->Insert("clear", std::move([this](std::ostream& out) {
+        if (!this->debugger->IsDebugging()) {
+            out << "Not in debug mode\n";
+            return;
+        }
+
+        this->debugger->ClearWatchpointList();
+    }));
+
+    watchpoints->Insert("list", std::move([this](std::ostream& out) {
+        this->wplist(out);
+    }));
+
+    watchpoints->Insert("disableall", std::move([this](std::ostream& out) {
+        if (!this->debugger->IsDebugging()) {
+            out << "Not in debug mode\n";
+            return;
+        }
+
+        this->debugger->WatchpointsDisableAll();
+    }));
+
+    watchpoints->Insert("enableall", std::move([this](std::ostream& out) {
+        if (!this->debugger->IsDebugging()) {
+            out << "Not in debug mode\n";
+            return;
+        }
+
+        this->debugger->WatchpointsEnableAll();
+    }));
+
+    watchpoints->Insert("set", std::move([this](std::ostream& out, std::string address_str,
+        std::string type_str) {
+            this->wpadd(out, address_str, type_str, "", false);
+        }));
+
+    watchpoints->Insert("set", std::move([this](std::ostream& out, std::string address_str,
+        std::string type_str, std::string value_str) {
+            this->wpadd(out, address_str, type_str, value_str, false);
+        }));
+
+    watchpoints->Insert("change", std::move([this](std::ostream& out, std::string address_str,
+        std::string type_str) {
+            this->wpadd(out, address_str, type_str, "", true);
+        }));
+
+    watchpoints->Insert("change", std::move([this](std::ostream& out, std::string address_str,
+        std::string type_str, std::string value_str) {
+            this->wpadd(out, address_str, type_str, value_str, true);
+        }));
+
+    watchpoints->Insert("delete", std::move([this](std::ostream& out, std::string address_str) {
+        if (!this->debugger->IsDebugging()) {
+            out << "Not in debug mode\n";
+            return;
+        }
+
+        auto params = parseHexadecimal(address_str, 1);
+
+        if (params.size() == 0) {
+            out << "Invalid input on argument 0" << std::endl;
+            return;
+        }
+
+        this->debugger->WatchpointDelete(params[0], out, true);
+    }));
+
+    watchpoints->Insert("toggle", std::move([this](std::ostream& out, std::string address_str,
+        bool value) {
+            if (!this->debugger->IsDebugging()) {
+                out << "Not in debug mode\n";
+                return;
+            }
+
+            auto params = parseHexadecimal(address_str, 1);
+
+            if (params.size() == 0) {
+                out << "Invalid input on argument 0" << std::endl;
+                return;
+            }
+
+            this->debugger->WatchpointToggle(params[0], value, out, true);
+        }));
+
+    pointerToRoot->Insert(std::move(watchpoints));
+
 
 
     auto disassemble = std::make_unique<cli::Menu>("d");
@@ -292,6 +396,210 @@ void CliManager::init_commands() {
 
     pointerToRoot->Insert(std::move(savestate));
 
+    auto rewind = std::make_unique<cli::Menu>("rewind");
+
+    rewind->Insert("enable", [this](std::ostream& out) {
+        this->state->EnableRewind(true);
+    });
+
+    rewind->Insert("disable", [this](std::ostream& out) {
+        this->state->EnableRewind(false);
+    });
+
+    rewind->Insert("back", [this](std::ostream& out, unsigned count) {
+        if (!this->state->RewindEnabled()) {
+            out << "Rewind is not enabled" << std::endl;
+            return;
+        }
+
+        this->state->Rewind(count);
+    });
+
+    rewind->Insert("budget", [this](std::ostream& out, unsigned kb) {
+        this->state->GetRewind()->SetBudget((std::size_t)kb * 1024);
+    });
+
+    rewind->Insert("interval", [this](std::ostream& out, unsigned frames) {
+        this->state->GetRewind()->SetInterval(frames);
+    });
+
+    rewind->Insert("status", [this](std::ostream& out) {
+        auto rewind = this->state->GetRewind();
+
+        out << fmt::format(
+            "Rewind enabled : {0}\n"
+            "Snapshots : {1} (one every {2} frames)\n"
+            "Memory used : {3} KiB of {4} KiB\n",
+            this->state->RewindEnabled(),
+            rewind->GetCount(), rewind->GetInterval(),
+            rewind->GetUsedMemory() / 1024,
+            rewind->GetBudget() / 1024
+        );
+    });
+
+    pointerToRoot->Insert(std::move(rewind));
+
+    auto idleskip = std::make_unique<cli::Menu>("idleskip");
+
+    idleskip->Insert("enable", [this](std::ostream& out) {
+        this->state->SetIdleSkip(true);
+    });
+
+    idleskip->Insert("disable", [this](std::ostream& out) {
+        this->state->SetIdleSkip(false);
+    });
+
+    idleskip->Insert("status", [this](std::ostream& out) {
+        out << "HALT and idle loop skipping : "
+            << this->state->IdleSkipEnabled()
+            << "\n";
+    });
+
+    pointerToRoot->Insert(std::move(idleskip));
+
+    auto profile = std::make_unique<cli::Menu>("profile");
+
+    profile->Insert("enable", [this](std::ostream& out) {
+        if (this->profiler_available(out)) {
+            this->state->GetProfiler()->Enable(true);
+        }
+    });
+
+    profile->Insert("disable", [this](std::ostream& out) {
+        if (this->profiler_available(out)) {
+            this->state->GetProfiler()->Enable(false);
+        }
+    });
+
+    profile->Insert("reset", [this](std::ostream& out) {
+        if (this->profiler_available(out)) {
+            this->state->GetProfiler()->Reset();
+        }
+    });
+
+    profile->Insert("show", [this](std::ostream& out) {
+        this->profile_show(out, 20);
+    });
+
+    profile->Insert("opcodes", [this](std::ostream& out, unsigned count) {
+        this->profile_show(out, count);
+    });
+
+    profile->Insert("json", [this](std::ostream& out, std::string path) {
+        this->profile_json(out, path);
+    });
+
+    pointerToRoot->Insert(std::move(profile));
+
+    auto guest = std::make_unique<cli::Menu>("guestprof");
+
+    guest->Insert("start", [this](std::ostream& out) {
+        this->state->ProfileGuest(true);
+    });
+
+    guest->Insert("stop", [this](std::ostream& out) {
+        this->state->ProfileGuest(false);
+    });
+
+    guest->Insert("reset", [this](std::ostream& out) {
+        this->state->GetGuestProfiler()->Reset();
+    });
+
+    guest->Insert("period", [this](std::ostream& out, unsigned cycles) {
+        this->state->GetGuestProfiler()->SetPeriod(cycles);
+    });
+
+    guest->Insert("symbols", [this](std::ostream& out, std::string path) {
+        auto res = this->state->GetGuestProfiler()->LoadSymbols(path);
+
+        if (!res.first) {
+            out << res.second << std::endl;
+        }
+    });
+
+    guest->Insert("top", [this](std::ostream& out, unsigned count) {
+        out << fmt::format("Sampling : {}\n",
+            this->state->GuestProfiling());
+
+        this->state->GetGuestProfiler()->PrintTop(out, count);
+    });
+
+    guest->Insert("folded", [this](std::ostream& out, std::string path) {
+        auto res = this->state->GetGuestProfiler()->WriteFolded(path);
+
+        if (!res.first) {
+            out << res.second << std::endl;
+        }
+    });
+
+    pointerToRoot->Insert(std::move(guest));
+
+    auto trace = std::make_unique<cli::Menu>("trace");
+
+    trace->Insert("start", [this](std::ostream& out) {
+        this->state->GetTracer()->Enable(true);
+    });
+
+    trace->Insert("stop", [this](std::ostream& out) {
+        this->state->GetTracer()->Enable(false);
+    });
+
+    trace->Insert("clear", [this](std::ostream& out) {
+        this->state->GetTracer()->Clear();
+    });
+
+    //The ring is freed, the emulation thread
+    //may still be writing the last record
+    trace->Insert("capacity", [this](std::ostream& out, std::size_t records) {
+        if (!this->debugger->IsDebugging()) {
+            out << "Not in debug mode\n";
+            return;
+        }
+
+        auto res = this->state->GetTracer()->SetCapacity(records);
+
+        if (!res.first) {
+            out << res.second << std::endl;
+        }
+    });
+
+    trace->Insert("status", [this](std::ostream& out) {
+        auto tracer = this->state->GetTracer();
+
+        out << fmt::format("Tracing : {}\nCapacity : {}\nRecorded : {}\n"
+            "Streaming : {}\nDropped : {}\n",
+            tracer->Enabled(), tracer->GetCapacity(), tracer->Count(),
+            tracer->Streaming(), tracer->Dropped());
+    });
+
+    trace->Insert("last", [this](std::ostream& out, std::size_t count) {
+        for (auto const& record : this->state->GetTracer()->Last(count)) {
+            out << GameboyEmu::Debugger::Tracer::Format(record) << "\n";
+        }
+    });
+
+    trace->Insert("dump", [this](std::ostream& out, std::string path) {
+        auto res = this->state->GetTracer()->Dump(path);
+
+        if (!res.first) {
+            out << res.second << std::endl;
+        }
+    });
+
+    trace->Insert("stream", [this](std::ostream& out, std::string path) {
+        auto res = this->state->GetTracer()->StartStream(path);
+
+        if (!res.first) {
+            out << res.second << std::endl;
+        }
+    });
+
+    trace->Insert("endstream", [this](std::ostream& out) {
+        this->state->GetTracer()->StopStream();
+    });
+
+    pointerToRoot->Insert(std::move(trace));
+
     auto genie = std::make_unique<cli::Menu>("genie");
 
     genie->Insert("add", [this](std::ostream& out, std::string cheat) {
@@ -538,6 +846,80 @@ void CliManager::brtoggle(
     this->debugger->BreakpointToggle(page, address, val, out, true);
 }
 
+void CliManager::wplist(std::ostream& out) {
+    static constexpr const char* types[] = { "r", "w", "rw" };
+
+    auto const& watchpoints = debugger->GetWatchpoints();
+
+    out << "Enabled/disabled : " << debugger->WatchpointsEnabled() << "\n";
+
+    out << "Number of watchpoints : " << watchpoints
+        .size() << "\n";
+
+    for (auto const& [address, watch] : watchpoints) {
+        out << fmt::format(
+            "0x{0:x} : {{"
+            " type = {1}"
+            " value = {2}"
+            " enable = {3}"
+            " }}"
+        , address, types[(unsigned)watch.type],
+            watch.conditional ? fmt::format("0x{:x}", watch.value) : "any",
+            watch.enabled) << std::endl;
+    }
+}
+
+void CliManager::wpadd(
+    std::ostream& out,
+    std::string const& address_str,
+    std::string const& type_str,
+    std::string const& value_str,
+    bool change
+) {
+    if (!debugger->IsDebugging()) {
+        out << "Not in debug mode\n";
+        return;
+    }
+
+    auto params = parseHexadecimal(address_str + " " + value_str,
+        value_str.empty() ? 1 : 2);
+
+    if (params.size() < (value_str.empty() ? 1u : 2u)) {
+        out << "Invalid input on argument " <<
+            (params.empty() ? 0 : 2) << std::endl;
+        return;
+    }
+
+    byte type = 0;
+
+    if (type_str == "r") {
+        type = (byte)GameboyEmu::Debugger::WatchType::read;
+    }
+    else if (type_str == "w") {
+        type = (byte)GameboyEmu::Debugger::WatchType::write;
+    }
+    else if (type_str == "rw") {
+        type = (byte)GameboyEmu::Debugger::WatchType::readwrite;
+    }
+    else {
+        out << "Watch type is r, w or rw" << std::endl;
+        return;
+    }
+
+    std::optional<byte> value{};
+
+    if (!value_str.empty()) {
+        value = (byte)params[1];
+    }
+
+    if (change) {
+        this->debugger->WatchpointChange(params[0], type, value, out, true);
+    }
+    else {
+        this->debugger->WatchpointSet(params[0], type, value, {}, out, true);
+    }
+}
+
 void CliManager::next_(std::ostream& out) {
     this->debugger->Next(out, true);
 }
@@ -571,9 +953,9 @@ void CliManager::disassemble_rng(std::ostream& out, word address, word end) {
 }
 
 void CliManager::game_save(std::ostream& out, std::string const& path) {
-    auto res = GameboyEmu::Saves::SaveGame(
-        state->GetCard(), path
-    );
+    //Written in background, errors
+    //are reported by the logger
+    auto res = state->SaveGameAsync(path);
 
     if (!res.first) {
         out << res.second << std::endl;
@@ -591,13 +973,7 @@ void CliManager::load_save(std::ostream& out, std::string const& path) {
 }
 
 void CliManager::savestate_save(std::ostream& out, std::string const& path) {
-    auto res = GameboyEmu::Saves::SaveState(
-        path, state
-    );
-
-    if (!res.first) {
-        out << res.second << std::endl;
-    }
+    state->SaveStateAsync(path);
 }
 
 void CliManager::savestate_load(std::ostream& out, std::string const& path) {
@@ -610,6 +986,43 @@ void CliManager::savestate_load(std::ostream& out, std::string const& path) {
     }
 }
 
+bool CliManager::profiler_available(std::ostream& out) {
+    if (!Profiler::Available()) {
+        out << "The profiler is not built, "
+            "configure with -DLEARNBOY_PROFILER=ON" << std::endl;
+    }
+
+    return Profiler::Available();
+}
+
+void CliManager::profile_show(std::ostream& out, unsigned opcodes) {
+    if (!profiler_available(out)) {
+        return;
+    }
+
+    auto profiler = state->GetProfiler();
+
+    out << fmt::format("Profiler enabled : {}\n",
+        profiler->Enabled());
+
+    profiler->PrintTable(out, opcodes);
+}
+
+void CliManager::profile_json(std::ostream& out, std::string const& path) {
+    if (!profiler_available(out)) {
+        return;
+    }
+
+    std::ofstream file{ path };
+
+    if (!file) {
+        out << fmt::format("Cannot open {}", path) << std::endl;
+        return;
+    }
+
+    state->GetProfiler()->DumpJson(file);
+}
+
 GameboyEmu::Debugger::DebuggerClass* CliManager::GetDebugger() {
     return debugger;
 }
\ No newline at end of file
@@ -69,6 +69,16 @@ private :
 		bool val
 	);
 
+	void wplist(std::ostream& out);
+
+	void wpadd(
+		std::ostream& out,
+		std::string const& address_str,
+		std::string const& type_str,
+		std::string const& value_str,
+		bool change
+	);
+
 	void disassemble_1(std::ostream& out, word address);
 	void disassemble_rng(std::ostream& out, word address, word end);
 
@@ -77,6 +87,10 @@ private :
 
 	void savestate_save(std::ostream& out, std::string const& path);
 	void savestate_load(std::ostream& out, std::string const& path);
+
+	bool profiler_available(std::ostream& out);
+	void profile_show(std::ostream& out, unsigned opcodes);
+	void profile_json(std::ostream& out, std::string const& path);
 	/*
 	* Inits all the command handlers
 	*/
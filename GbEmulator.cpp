@@ -1,9 +1,13 @@
 #include <iostream>
+#include <filesystem>
 
 //#include <SDL2/SDL.h>
 
 #include "include/logging/Logger.h"
 #include "include/state/EmulatorState.h"
+#include "include/frontend/SdlFrontend.h"
+#include "include/cartridge/MemoryCard.h"
+#include "include/save/Savestate.h"
 
 #include "./options/OptionsParser.h"
 #include "include/debugger/Debugger.h"
@@ -31,9 +35,28 @@ int main(int argc, char* argv[])
 
     auto const& options = ParseOptions(argv, argc);
 
-    GameboyEmu::State::EmulatorState emulator(rom_path, log);
+    auto log_file = options.find("--log-file");
+
+    if (log_file != options.end()) {
+        if (log_file->second.empty()) {
+            std::cout << "--log-file Requires a corresponding path" << std::endl;
+            std::exit(0);
+        }
+
+        auto res = log.set_file(log_file->second);
+
+        if (!res.first) {
+            std::cout << res.second << std::endl;
+        }
+    }
+
+    GameboyEmu::Frontend::SdlFrontend frontend;
+
+    GameboyEmu::State::EmulatorState emulator(rom_path, log, &frontend);
 
     if (!emulator.Ok()) {
+        log.flush();
+
         std::cout << emulator.GetMessage() << std::endl;
         std::cin.get();
         std::exit(0);
@@ -46,6 +69,27 @@ int main(int argc, char* argv[])
     bool start_debug = options.find("--debug") != options.end()
         || options.find("--start-debug") != options.end();
 
+    auto record_movie = options.find("--record-movie");
+    auto play_movie = options.find("--play-movie");
+    auto movie_state = options.find("--movie-state");
+
+    bool use_movie = record_movie != options.end() || play_movie != options.end();
+
+    if ((record_movie != options.end() && record_movie->second.empty()) ||
+        (play_movie != options.end() && play_movie->second.empty()) ||
+        (movie_state != options.end() && movie_state->second.empty())) {
+        std::cout << "--record-movie, --play-movie and --movie-state Require a corresponding path" << std::endl;
+        log.flush();
+        std::exit(0);
+    }
+
+    //Movies start at power on without the boot
+    //ROM, or from a state, with no battery save
+    if (use_movie && use_bootrom) {
+        std::cout << "The boot ROM is not used with movies" << std::endl;
+        use_bootrom = false;
+    }
+
     if (use_bootrom) {
         std::string bootrom_pos = "DMG_ROM.bin";
 
@@ -54,6 +98,7 @@ int main(int argc, char* argv[])
         if (boot_option != options.end()) {
             if (boot_option->second.empty()) {
                 std::cout << "--boot Requires a corresponding path" << std::endl;
+                log.flush();
                 std::exit(0);
             }
 
@@ -63,12 +108,69 @@ int main(int argc, char* argv[])
         emulator.UseBootrom(bootrom_pos);
     }
 
+    auto mapped_save = options.find("--mapped-save");
+
+    if (use_movie && mapped_save != options.end()) {
+        std::cout << "The mapped save is not used with movies" << std::endl;
+        mapped_save = options.end();
+    }
+
+    if (mapped_save != options.end()) {
+        std::string save_path = mapped_save->second;
+
+        if (save_path.empty()) {
+            save_path = std::filesystem::path(rom_path)
+                .replace_extension(".sav").string();
+        }
+
+        auto res = emulator.GetCard()->MapRamSave(save_path);
+
+        std::cout << res.second << std::endl;
+    }
+
+    if (record_movie != options.end()) {
+        bool from_state = movie_state != options.end();
+
+        if (from_state) {
+            auto res = GameboyEmu::Saves::LoadState(movie_state->second, &emulator);
+
+            if (!res.first) {
+                std::cout << "Could not load the movie state : " << res.second << std::endl;
+                log.flush();
+                std::exit(0);
+            }
+        }
+
+        auto res = emulator.RecordMovie(from_state);
+
+        if (!res.first) {
+            std::cout << res.second << std::endl;
+            log.flush();
+            std::exit(0);
+        }
+    }
+    else if (play_movie != options.end()) {
+        auto res = emulator.PlayMovie(play_movie->second);
+
+        if (!res.first) {
+            std::cout << "Could not play the movie : " << res.second << std::endl;
+            log.flush();
+            std::exit(0);
+        }
+    }
+
     if (!start_debug) {
         cli.GetDebugger()->Detach();
     }
 
     cli.Run();
 
+    if (record_movie != options.end()) {
+        auto res = emulator.SaveMovie(record_movie->second);
+
+        std::cout << (res.first ? "Movie saved" : res.second) << std::endl;
+    }
+
     std::cin.get();
 
     return 0;
@@ -0,0 +1,243 @@
+#include "Bench.h"
+#include "../include/logging/Logger.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace GameboyEmu::Bench {
+	//Upper bound for the iteration count
+	static constexpr uint64_t max_iterations = 1ull << 32;
+
+	static std::string json_escape(std::string_view str) {
+		std::string res{};
+
+		for (char c : str) {
+			switch (c) {
+			case '"': res += "\\\""; break;
+			case '\\': res += "\\\\"; break;
+			case '\n': res += "\\n"; break;
+			default: res += c; break;
+			}
+		}
+
+		return res;
+	}
+
+	Runner::Runner() :
+		m_benchmarks{}, m_results{}, m_options{},
+		m_filter{}, m_out{}, m_log_file{}, m_min_time_ms(250.0)
+	{}
+
+	bool Runner::ParseArgs(int argc, char** argv, std::string& msg,
+		std::vector<std::string_view> const& extra) {
+		for (int i = 1; i < argc; i++) {
+			std::string_view arg = argv[i];
+
+			auto is_extra = std::find_if(extra.begin(), extra.end(),
+				[arg](std::string_view name) {
+					return arg.size() > name.size() + 3 &&
+						arg.starts_with("--") &&
+						arg.substr(2, name.size()) == name &&
+						arg[name.size() + 2] == '=';
+				});
+
+			if (is_extra != extra.end()) {
+				m_options.emplace_back(*is_extra,
+					arg.substr(is_extra->size() + 3));
+			}
+			else if (arg.starts_with("--filter=")) {
+				m_filter = arg.substr(9);
+			}
+			else if (arg.starts_with("--min-time=")) {
+				try {
+					m_min_time_ms = std::stod(std::string(arg.substr(11)));
+				}
+				catch (std::exception const&) {
+					msg = fmt::format("Invalid minimum time : {}", arg.substr(11));
+					return false;
+				}
+			}
+			else if (arg.starts_with("--out=")) {
+				m_out = arg.substr(6);
+			}
+			else if (arg.starts_with("--log-file=")) {
+				m_log_file = arg.substr(11);
+			}
+			else {
+				std::string usage = fmt::format("Usage : {} [--filter=substring] "
+					"[--min-time=ms] [--out=file.json] [--log-file=path]", argv[0]);
+
+				for (auto name : extra) {
+					usage += fmt::format(" [--{}=value]", name);
+				}
+
+				msg = fmt::format("Unknown option : {}\n{}", arg, usage);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::string Runner::GetOption(std::string_view name, std::string_view def) const {
+		for (auto const& [key, value] : m_options) {
+			if (key == name) {
+				return value;
+			}
+		}
+
+		return std::string(def);
+	}
+
+	bool Runner::Matches(std::string_view name) const {
+		return m_filter.empty() ||
+			name.find(m_filter) != std::string_view::npos;
+	}
+
+	void Runner::AddResult(Result result) {
+		m_results.push_back(std::move(result));
+	}
+
+	void Runner::Add(std::string_view name, bench_function fun) {
+		m_benchmarks.push_back(Entry{ std::string(name), std::move(fun) });
+	}
+
+	void Runner::Run() {
+		using clock = std::chrono::steady_clock;
+
+		for (auto const& bench : m_benchmarks) {
+			if (!Matches(bench.name)) {
+				continue;
+			}
+
+			uint64_t iterations = 1;
+			double elapsed_ns = 0.0;
+			uint64_t items = 0;
+
+			while (true) {
+				auto start = clock::now();
+
+				items = bench.fun(iterations);
+
+				elapsed_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+					clock::now() - start
+				).count();
+
+				if (elapsed_ns >= m_min_time_ms * 1e6 ||
+					iterations >= max_iterations) {
+					break;
+				}
+
+				//Aim a bit past the minimum time, but
+				//never grow more than 10x in one step
+				double factor = elapsed_ns > 0.0 ?
+					(m_min_time_ms * 1e6 * 1.4) / elapsed_ns : 10.0;
+
+				factor = std::clamp(factor, 2.0, 10.0);
+
+				iterations = std::min(max_iterations,
+					(uint64_t)((double)iterations * factor));
+			}
+
+			Result res{};
+
+			res.name = bench.name;
+			res.iterations = iterations;
+			res.real_time_ns = elapsed_ns / (double)iterations;
+			res.items_per_second = items > 0 ?
+				(double)items / (elapsed_ns / 1e9) : 0.0;
+
+			std::cerr << fmt::format("{:<48} {:>14.2f} ns {:>12} it\n",
+				res.name, res.real_time_ns, res.iterations);
+
+			m_results.push_back(res);
+		}
+	}
+
+	std::vector<Result> const& Runner::GetResults() const {
+		return m_results;
+	}
+
+	bool Runner::Report(std::string_view executable) {
+		if (m_out.empty()) {
+			WriteJson(std::cout, executable);
+			std::cout.flush();
+
+			return true;
+		}
+
+		std::ofstream file{ m_out };
+
+		if (!file) {
+			std::cerr << fmt::format("Cannot open {}\n", m_out);
+			return false;
+		}
+
+		WriteJson(file, executable);
+
+		return (bool)file;
+	}
+
+	void Runner::WriteJson(std::ostream& out, std::string_view executable) const {
+		char date[64]{};
+		std::time_t now = std::time(nullptr);
+
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+		out << "{\n  \"context\": {\n";
+		out << fmt::format("    \"date\": \"{}\",\n", date);
+		out << fmt::format("    \"executable\": \"{}\",\n", json_escape(executable));
+		out << fmt::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+		out << "    \"library_build_type\": \"release\"\n";
+#else
+		out << "    \"library_build_type\": \"debug\"\n";
+#endif
+		out << "  },\n  \"benchmarks\": [";
+
+		for (std::size_t i = 0; i < m_results.size(); i++) {
+			auto const& res = m_results[i];
+
+			out << (i == 0 ? "\n" : ",\n");
+			out << "    {\n";
+			out << fmt::format("      \"name\": \"{}\",\n", json_escape(res.name));
+			out << fmt::format("      \"run_name\": \"{}\",\n", json_escape(res.name));
+			out << "      \"run_type\": \"iteration\",\n";
+			out << fmt::format("      \"iterations\": {},\n", res.iterations);
+			out << fmt::format("      \"real_time\": {:.4f},\n", res.real_time_ns);
+			out << fmt::format("      \"cpu_time\": {:.4f},\n", res.real_time_ns);
+
+			if (res.items_per_second > 0.0) {
+				out << fmt::format("      \"items_per_second\": {:.4f},\n",
+					res.items_per_second);
+			}
+
+			for (auto const& [name, value] : res.counters) {
+				out << fmt::format("      \"{}\": {:.4f},\n", json_escape(name), value);
+			}
+
+			out << "      \"time_unit\": \"ns\"\n";
+			out << "    }";
+		}
+
+		out << "\n  ]\n}\n";
+	}
+
+	std::pair<bool, std::string> Runner::RedirectLog(Logger& log) const {
+		if (!m_log_file.empty()) {
+			return log.set_file(m_log_file);
+		}
+
+#ifdef _WIN32
+		return log.set_file("NUL");
+#else
+		return log.set_file("/dev/null");
+#endif
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <iosfwd>
+
+class Logger;
+
+namespace GameboyEmu::Bench {
+	/*
+	* Keeps the compiler from removing a computation
+	* whose result is otherwise unused
+	*/
+	template <typename T>
+	inline void DoNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	//Result of a single benchmark
+	struct Result {
+		std::string name;
+		uint64_t iterations;
+		double real_time_ns; // per iteration
+		double items_per_second; // 0 when not reported
+
+		//User counters, written as extra fields
+		std::vector<std::pair<std::string, double>> counters;
+	};
+
+	/*
+	* Body of a benchmark : runs the measured
+	* operation "iterations" times and returns the
+	* number of items processed (or 0)
+	*/
+	using bench_function = std::function<uint64_t(uint64_t iterations)>;
+
+	/*
+	* Minimal in-tree harness, the iteration count
+	* is doubled until a run lasts at least the
+	* minimum time, the last run is the result.
+	* Output is the same layout as Google Benchmark's
+	* --benchmark_format=json, so the same tools
+	* (compare.py...) can read it
+	*/
+	class Runner {
+	public :
+		Runner();
+
+		//Parses --filter=, --min-time= (ms), --out=,
+		//--log-file= and the --name= options listed in extra,
+		//returns false and fills the message
+		//on unknown options
+		bool ParseArgs(int argc, char** argv, std::string& msg,
+			std::vector<std::string_view> const& extra = {});
+
+		//Value of an extra option, or the default
+		std::string GetOption(std::string_view name, std::string_view def) const;
+
+		bool Matches(std::string_view name) const;
+
+		void Add(std::string_view name, bench_function fun);
+
+		//Adds a result measured by the caller
+		void AddResult(Result result);
+
+		//Runs every benchmark matching the filter
+		void Run();
+
+		std::vector<Result> const& GetResults() const;
+
+		//Writes the JSON report to the --out file, or stdout
+		bool Report(std::string_view executable);
+
+		/*
+		* The Logger prints to stdout, where the report
+		* goes : its messages are sent to the --log-file
+		* file, or to the null device
+		*/
+		std::pair<bool, std::string> RedirectLog(Logger& log) const;
+
+	private :
+		void WriteJson(std::ostream& out, std::string_view executable) const;
+
+	private :
+		struct Entry {
+			std::string name;
+			bench_function fun;
+		};
+
+		std::vector<Entry> m_benchmarks;
+		std::vector<Result> m_results;
+
+		std::vector<std::pair<std::string, std::string>> m_options;
+
+		std::string m_filter;
+		std::string m_out;
+		std::string m_log_file;
+		double m_min_time_ms;
+	};
+}
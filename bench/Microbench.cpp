@@ -0,0 +1,443 @@
+#include "Bench.h"
+#include "RomBuilder.h"
+
+#include "../include/state/EmulatorState.h"
+#include "../include/cpu/Cpu.h"
+#include "../include/memory/Memory.h"
+#include "../include/graphics/ppu/PPU.h"
+#include "../include/graphics/ppu/PixelQueue.h"
+#include "../include/graphics/ppu/OamEntry.h"
+#include "../include/sound/apu/APU.h"
+#include "../include/save/Snapshot.h"
+#include "../include/save/Savestate.h"
+#include "../include/logging/Logger.h"
+
+#ifdef LEARNBOY_BENCH_DISPLAY
+#define SDL_MAIN_HANDLED
+#include "../include/graphics/display/Display.h"
+#endif
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+/*
+* Microbenchmarks of the emulator hot paths :
+* cpu dispatch, memory regions, ppu, apu, display
+* conversion and savestates. Run with --filter=
+* to select some of them, the report is JSON
+* in the Google Benchmark layout
+*/
+
+using namespace GameboyEmu;
+
+namespace {
+	/*
+	* MBC1 + RAM cartridge whose code walks WRAM :
+	*
+	* start: LD HL, 0xC000
+	* loop:  LD A, (HL)
+	*        INC A
+	*        LD (HL+), A
+	*        LD A, H
+	*        CP 0xDF
+	*        JR NZ, loop
+	*        JP start
+	*/
+	std::pair<bool, std::string> build_rom(std::string const& path) {
+		Bench::RomBuilder rom{ "MICROBENCH", 0x02, 4, 0x02 };
+
+		auto start = rom.Here();
+
+		rom.Emit({ 0x21, 0x00, 0xC0 });
+
+		auto loop = rom.Here();
+
+		rom.Emit({ 0x7E, 0x3C, 0x22, 0x7C, 0xFE, 0xDF });
+		rom.Jr(0x20, loop);
+		rom.Jp(0xC3, (word)start);
+
+		return rom.Save(path);
+	}
+
+	//Tiles, a tilemap and 10 sprites, LCD and objects on
+	void setup_video(Mem::Memory* mem) {
+		for (word addr = 0x8000; addr < 0x9800; addr++) {
+			mem->Write(addr, (byte)(addr * 37));
+		}
+
+		for (word addr = 0x9800; addr < 0x9C00; addr++) {
+			mem->Write(addr, (byte)addr);
+		}
+
+		for (word sprite = 0; sprite < 10; sprite++) {
+			word base = 0xFE00 + sprite * 4;
+
+			mem->Write(base, (byte)(16 + sprite * 8));
+			mem->Write(base + 1, (byte)(8 + sprite * 12));
+			mem->Write(base + 2, (byte)sprite);
+			mem->Write(base + 3, (byte)((sprite & 1) << 5));
+		}
+
+		mem->Write(0xFF47, 0xE4);
+		mem->Write(0xFF48, 0xE4);
+		mem->Write(0xFF40, 0x93);
+	}
+
+	//Sound on, every channel triggered
+	void setup_audio(Mem::Memory* mem) {
+		mem->Write(0xFF26, 0x80);
+		mem->Write(0xFF24, 0x77);
+		mem->Write(0xFF25, 0xFF);
+
+		mem->Write(0xFF11, 0x80);
+		mem->Write(0xFF12, 0xF0);
+		mem->Write(0xFF13, 0x00);
+		mem->Write(0xFF14, 0x87);
+
+		mem->Write(0xFF16, 0x40);
+		mem->Write(0xFF17, 0xF0);
+		mem->Write(0xFF18, 0x80);
+		mem->Write(0xFF19, 0x87);
+
+		for (word addr = 0xFF30; addr < 0xFF40; addr++) {
+			mem->Write(addr, (byte)(addr * 17));
+		}
+
+		mem->Write(0xFF1A, 0x80);
+		mem->Write(0xFF1C, 0x20);
+		mem->Write(0xFF1E, 0x87);
+
+		mem->Write(0xFF21, 0xF0);
+		mem->Write(0xFF22, 0x21);
+		mem->Write(0xFF23, 0x80);
+	}
+
+	struct Region {
+		const char* name;
+		word base;
+	};
+
+	void add_memory(Bench::Runner& runner, Mem::Memory* mem) {
+		static constexpr std::array read_regions = {
+			Region{ "rom0", 0x0150 },
+			Region{ "romx", 0x4000 },
+			Region{ "vram", 0x8000 },
+			Region{ "sram", 0xA000 },
+			Region{ "wram", 0xC000 },
+			Region{ "echo", 0xE000 },
+			Region{ "oam", 0xFE00 },
+			Region{ "io", 0xFF00 },
+			Region{ "hram", 0xFF80 }
+		};
+
+		//ROM writes are MBC registers, io
+		//writes are limited to plain registers
+		static constexpr std::array write_regions = {
+			Region{ "vram", 0x8000 },
+			Region{ "sram", 0xA000 },
+			Region{ "wram", 0xC000 },
+			Region{ "oam", 0xFE00 },
+			Region{ "io", 0xFF42 },
+			Region{ "hram", 0xFF80 }
+		};
+
+		for (auto const& region : read_regions) {
+			word base = region.base;
+			word mask = base >= 0xFF00 ? 0x3F : 0x7F;
+
+			runner.Add(fmt::format("Memory::Read/{}", region.name),
+				[mem, base, mask](uint64_t n) {
+					byte acc = 0;
+
+					for (uint64_t i = 0; i < n; i++) {
+						acc += mem->Read(base + (word)(i & mask));
+					}
+
+					Bench::DoNotOptimize(acc);
+
+					return n;
+				});
+		}
+
+		for (auto const& region : write_regions) {
+			word base = region.base;
+			word mask = base == 0xFF42 ? 0x01 : 0x3F;
+
+			runner.Add(fmt::format("Memory::Write/{}", region.name),
+				[mem, base, mask](uint64_t n) {
+					for (uint64_t i = 0; i < n; i++) {
+						mem->Write(base + (word)(i & mask), (byte)i);
+					}
+
+					return n;
+				});
+		}
+	}
+
+	void add_ppu(Bench::Runner& runner, Graphics::PPU* ppu) {
+		runner.Add("PPU::Tick/scanline", [ppu](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				for (unsigned cycle = 0; cycle < 114; cycle++) {
+					ppu->Tick(1);
+				}
+			}
+
+			return n;
+		});
+
+		runner.Add("PPU::Tick/frame", [ppu](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				for (unsigned cycle = 0; cycle < 17556; cycle++) {
+					ppu->Tick(1);
+				}
+			}
+
+			return n;
+		});
+	}
+
+	void add_pixel_queue(Bench::Runner& runner) {
+		runner.Add("PixelQueue::push_sprite_pixels", [](uint64_t n) {
+			Graphics::PixelQueue<Graphics::SpritePixel, 320> queue{};
+
+			Graphics::oam_object obj{};
+
+			obj.x_pos = 24;
+			obj.palette_num = 1;
+			obj.oam_index = 3;
+
+			for (uint64_t i = 0; i < n; i++) {
+				//8 blank pixels, then the object
+				//is mixed over them
+				queue.reset();
+
+				for (unsigned px = 0; px < 8; px++) {
+					Graphics::SpritePixel blank{};
+
+					blank.blank = true;
+					blank.x = obj.x_pos;
+
+					queue.push(blank);
+				}
+
+				Bench::DoNotOptimize(queue.push_sprite_pixels(
+					(byte)i, (byte)(i >> 8), obj, 0
+				));
+			}
+
+			return n;
+		});
+	}
+
+	void add_apu(Bench::Runner& runner, Sound::APU* apu) {
+		runner.Add("APU::Tick", [apu](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				apu->Tick(1);
+			}
+
+			return n;
+		});
+
+		runner.Add("APU::mix_samples", [apu](uint64_t n) {
+			std::array<short, 4> samples{ 3, 7, 11, 15 };
+
+			for (uint64_t i = 0; i < n; i++) {
+				samples[i & 3] = (short)(i & 0xF);
+
+				apu->mix_samples(samples);
+			}
+
+			return n;
+		});
+
+		//Writes of a music driver : duty, volume and
+		//frequency of each channel, and the wave RAM,
+		//without the triggers
+		static constexpr std::array<word, 16> driver_writes = {
+			0xFF11, 0xFF12, 0xFF13, 0xFF16, 0xFF17, 0xFF18,
+			0xFF1C, 0xFF1D, 0xFF21, 0xFF22, 0xFF24, 0xFF25,
+			0xFF30, 0xFF34, 0xFF38, 0xFF3C
+		};
+
+		runner.Add("APU::WriteReg", [apu](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				apu->WriteReg(driver_writes[i & 15], (byte)(0xF0 | (i & 0x0F)));
+			}
+
+			return n;
+		});
+
+		runner.Add("APU::ReadReg", [apu](uint64_t n) {
+			byte sum = 0;
+
+			for (uint64_t i = 0; i < n; i++) {
+				sum += apu->ReadReg((word)(0xFF10 + (i % 0x30)));
+			}
+
+			Bench::DoNotOptimize(sum);
+
+			return n;
+		});
+	}
+
+	void add_savestate(Bench::Runner& runner, State::EmulatorState* emu,
+		std::string const& state_path) {
+		auto snap = std::make_shared<Saves::Snapshot>();
+
+		emu->Capture(*snap);
+
+		runner.Add("EmulatorState::Capture", [emu, snap](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				emu->Capture(*snap);
+			}
+
+			return (uint64_t)snap->Size() * n;
+		});
+
+		runner.Add("EmulatorState::Restore", [emu, snap](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				Bench::DoNotOptimize(emu->Restore(*snap).first);
+			}
+
+			return (uint64_t)snap->Size() * n;
+		});
+
+		runner.Add("Saves::SaveState", [emu, state_path](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				Bench::DoNotOptimize(Saves::SaveState(state_path, emu).first);
+			}
+
+			return n;
+		});
+
+		runner.Add("Saves::LoadState", [emu, state_path](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) {
+				Bench::DoNotOptimize(Saves::LoadState(state_path, emu).first);
+			}
+
+			return n;
+		});
+	}
+
+#ifdef LEARNBOY_BENCH_DISPLAY
+	/*
+	* The display needs a window, SDL's dummy
+	* video driver gives one without a screen
+	*/
+	void add_display(Bench::Runner& runner, Logger& log) {
+#ifdef _WIN32
+		_putenv_s("SDL_VIDEODRIVER", "dummy");
+#else
+		setenv("SDL_VIDEODRIVER", "dummy", 0);
+#endif
+
+		auto display = std::make_shared<Graphics::Display>(log, []() {});
+
+		display->Init(160, 144, 1);
+
+		runner.Add("Display::SetFrame", [display](uint64_t n) {
+			std::array<byte, 160 * 144> frame{};
+
+			for (uint64_t i = 0; i < n; i++) {
+				frame[i % frame.size()] = (byte)i;
+
+				display->SetFrame(frame.data());
+			}
+
+			return n;
+		});
+
+		runner.Add("Display::SetPixels", [display](uint64_t n) {
+			std::vector<unsigned> pixels(160 * 144);
+
+			for (uint64_t i = 0; i < n; i++) {
+				display->SetPixels(pixels.data());
+
+				Bench::DoNotOptimize(pixels[i % pixels.size()]);
+			}
+
+			return n;
+		});
+	}
+#endif
+}
+
+int main(int argc, char** argv) {
+	Bench::Runner runner{};
+	std::string msg{};
+
+	if (!runner.ParseArgs(argc, argv, msg)) {
+		std::cerr << msg << "\n";
+		return 1;
+	}
+
+	auto rom_path = Bench::TempPath("learnboy_microbench.gb");
+	auto state_path = Bench::TempPath("learnboy_microbench.state");
+
+	if (auto [ok, err] = build_rom(rom_path); !ok) {
+		std::cerr << err << "\n";
+		return 1;
+	}
+
+	Logger log{};
+
+	if (auto [ok, err] = runner.RedirectLog(log); !ok) {
+		std::cerr << "Cannot open the log file : " << err << "\n";
+		return 1;
+	}
+
+	{
+		State::EmulatorState emu{ rom_path, log };
+
+		if (!emu.Ok()) {
+			std::cerr << "Cannot load the benchmark ROM\n";
+			return 1;
+		}
+
+		auto mem = emu.GetMemory();
+
+		//Enable cartridge RAM, warm up a few frames
+		mem->Write(0x0000, 0x0A);
+
+		setup_video(mem);
+		setup_audio(mem);
+
+		for (unsigned frame = 0; frame < 10; frame++) {
+			emu.RunFrame();
+		}
+
+		auto cpu = emu.GetCPU();
+
+		runner.Add("Cpu::Step", [cpu](uint64_t n) {
+			uint64_t cycles = 0;
+
+			for (uint64_t i = 0; i < n; i++) {
+				cycles += cpu->Step();
+			}
+
+			Bench::DoNotOptimize(cycles);
+
+			return n;
+		});
+
+		add_memory(runner, mem);
+		add_ppu(runner, emu.GetPPU());
+		add_pixel_queue(runner);
+		add_apu(runner, emu.GetAPU());
+		add_savestate(runner, &emu, state_path);
+
+#ifdef LEARNBOY_BENCH_DISPLAY
+		add_display(runner, log);
+#endif
+
+		runner.Run();
+	}
+
+	std::remove(rom_path.c_str());
+	std::remove(state_path.c_str());
+
+	return runner.Report(argv[0]) ? 0 : 1;
+}
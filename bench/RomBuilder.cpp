@@ -0,0 +1,122 @@
+#include "RomBuilder.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+
+namespace GameboyEmu::Bench {
+	static constexpr std::size_t bank_size = 0x4000;
+
+	RomBuilder::RomBuilder(std::string_view title, byte cart_type,
+		unsigned rom_banks, byte ram_size_code) :
+		m_rom(), m_pos(0x150) {
+		//Power of two, at least 32 KiB
+		rom_banks = std::bit_ceil(std::max(rom_banks, 2u));
+
+		m_rom.resize(rom_banks * bank_size, 0x00);
+
+		//NOP, JP 0x150
+		m_rom[0x100] = 0x00;
+		m_rom[0x101] = 0xC3;
+		m_rom[0x102] = 0x50;
+		m_rom[0x103] = 0x01;
+
+		for (std::size_t i = 0; i < title.size() && i < 15; i++) {
+			m_rom[0x134 + i] = (byte)title[i];
+		}
+
+		m_rom[0x147] = cart_type;
+		m_rom[0x148] = (byte)(std::countr_zero(rom_banks) - 1);
+		m_rom[0x149] = ram_size_code;
+	}
+
+	void RomBuilder::Org(std::size_t offset) {
+		m_pos = offset;
+	}
+
+	std::size_t RomBuilder::Here() const {
+		return m_pos;
+	}
+
+	void RomBuilder::Emit(std::initializer_list<byte> bytes) {
+		for (byte b : bytes) {
+			if (m_pos < m_rom.size()) {
+				m_rom[m_pos] = b;
+			}
+
+			m_pos++;
+		}
+	}
+
+	void RomBuilder::EmitWord(word value) {
+		Emit({ (byte)(value & 0xFF), (byte)(value >> 8) });
+	}
+
+	void RomBuilder::Jr(byte opcode, std::size_t target) {
+		auto offset = (long long)target - (long long)(m_pos + 2);
+
+		Emit({ opcode, (byte)(signed char)offset });
+	}
+
+	void RomBuilder::Jp(byte opcode, word target) {
+		Emit({ opcode });
+		EmitWord(target);
+	}
+
+	std::vector<byte> const& RomBuilder::Build() {
+		byte header = 0;
+
+		for (std::size_t i = 0x134; i <= 0x14C; i++) {
+			header = header - m_rom[i] - 1;
+		}
+
+		m_rom[0x14D] = header;
+
+		word global = 0;
+
+		m_rom[0x14E] = 0;
+		m_rom[0x14F] = 0;
+
+		for (byte b : m_rom) {
+			global += b;
+		}
+
+		m_rom[0x14E] = (byte)(global >> 8);
+		m_rom[0x14F] = (byte)(global & 0xFF);
+
+		return m_rom;
+	}
+
+	std::pair<bool, std::string> RomBuilder::Save(std::string const& path) {
+		auto const& rom = Build();
+
+		std::ofstream file{ path, std::ios::binary };
+
+		if (!file) {
+			return { false, fmt::format("Cannot create {}", path) };
+		}
+
+		file.write((const char*)rom.data(), rom.size());
+
+		if (!file) {
+			return { false, fmt::format("Cannot write {}", path) };
+		}
+
+		return { true, "" };
+	}
+
+	std::string TempPath(std::string_view name) {
+		std::error_code ec{};
+
+		auto dir = std::filesystem::temp_directory_path(ec);
+
+		if (ec) {
+			dir = ".";
+		}
+
+		return (dir / name).string();
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../include/common/Common.h"
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace GameboyEmu::Bench {
+	/*
+	* Assembles small test cartridges for the
+	* benchmarks, so they don't depend on
+	* commercial ROMs being around.
+	*
+	* The entry point (0x100) jumps to 0x150,
+	* code is emitted with raw opcodes at
+	* the current position
+	*/
+	class RomBuilder {
+	public :
+		//Cartridge type and RAM size code as in
+		//the header (0x147, 0x149), banks of 16 KiB
+		RomBuilder(std::string_view title, byte cart_type = 0x00,
+			unsigned rom_banks = 2, byte ram_size_code = 0x00);
+
+		//Moves to an absolute offset in the ROM file
+		void Org(std::size_t offset);
+		std::size_t Here() const;
+
+		void Emit(std::initializer_list<byte> bytes);
+		void EmitWord(word value);
+
+		//JR/JR cc (opcode) to an absolute address
+		//in the same bank
+		void Jr(byte opcode, std::size_t target);
+
+		//JP/CALL (opcode) to a CPU address
+		void Jp(byte opcode, word target);
+
+		//Fills the header checksums
+		std::vector<byte> const& Build();
+
+		std::pair<bool, std::string> Save(std::string const& path);
+
+	private :
+		std::vector<byte> m_rom;
+		std::size_t m_pos;
+	};
+
+	//Path in the system temporary directory
+	std::string TempPath(std::string_view name);
+}
@@ -0,0 +1,706 @@
+#include "Bench.h"
+#include "RomBuilder.h"
+
+#include "../include/state/EmulatorState.h"
+#include "../include/cpu/Cpu.h"
+#include "../include/memory/Memory.h"
+#include "../include/debugger/Profiler.h"
+#include "../include/logging/Logger.h"
+#include "../include/save/Snapshot.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+/*
+* Whole system benchmark : each generated ROM runs
+* headless for a fixed number of frames, the report
+* has emulated frames and instructions per second and,
+* in LEARNBOY_PROFILER builds, the time split between
+* the cpu and the components ticked by EmulatorState::Sync
+*/
+
+using namespace GameboyEmu;
+
+namespace {
+	static constexpr unsigned frame_cycles = 70224;
+	static constexpr double gb_fps = 59.7275;
+
+	static constexpr unsigned warmup_frames = 60;
+
+	//Frames run after restoring a state in a new emulator
+	static constexpr unsigned check_frames = 10;
+
+	/*
+	* Common start : stack, LCD off, the whole VRAM
+	* filled with a pattern (tiles and tile maps),
+	* palettes
+	*/
+	void emit_prologue(Bench::RomBuilder& rom) {
+		rom.Emit({
+			0xF3,             // DI
+			0x31, 0xFE, 0xFF, // LD SP, 0xFFFE
+			0xAF,             // XOR A
+			0xE0, 0x40,       // LDH (LCDC), A
+			0x21, 0x00, 0x80  // LD HL, 0x8000
+		});
+
+		auto fill = rom.Here();
+
+		rom.Emit({
+			0x7D,             // LD A, L
+			0xAC,             // XOR H
+			0x22,             // LD (HL+), A
+			0x7C,             // LD A, H
+			0xFE, 0xA0        // CP 0xA0
+		});
+		rom.Jr(0x20, fill);   // JR NZ, fill
+
+		rom.Emit({
+			0x3E, 0xE4,       // LD A, 0xE4
+			0xE0, 0x47,       // LDH (BGP), A
+			0xE0, 0x48,       // LDH (OBP0), A
+			0xE0, 0x49        // LDH (OBP1), A
+		});
+	}
+
+	//Enables the interrupts in ie, turns the LCD on,
+	//then halts forever
+	void emit_halt_loop(Bench::RomBuilder& rom, byte ie, byte lcdc) {
+		rom.Emit({
+			0x3E, ie,         // LD A, ie
+			0xE0, 0xFF,       // LDH (IE), A
+			0xAF,             // XOR A
+			0xE0, 0x0F,       // LDH (IF), A
+			0x3E, lcdc,       // LD A, lcdc
+			0xE0, 0x40,       // LDH (LCDC), A
+			0xFB              // EI
+		});
+
+		auto loop = rom.Here();
+
+		rom.Emit({
+			0x76,             // HALT
+			0x00              // NOP
+		});
+		rom.Jr(0x18, loop);   // JR loop
+	}
+
+	//Register juggling and stack traffic, no interrupts
+	Bench::RomBuilder cpu_loop_rom() {
+		Bench::RomBuilder rom{ "BENCH CPU" };
+
+		emit_prologue(rom);
+
+		rom.Emit({ 0x3E, 0x91, 0xE0, 0x40 }); // LCD on
+
+		auto loop = rom.Here();
+
+		rom.Emit({
+			0x78,             // LD A, B
+			0x81,             // ADD A, C
+			0x4F,             // LD C, A
+			0xAA,             // XOR D
+			0x57,             // LD D, A
+			0x07,             // RLCA
+			0x5F,             // LD E, A
+			0x04,             // INC B
+			0xCB, 0x11,       // RL C
+			0xC5,             // PUSH BC
+			0xD1,             // POP DE
+			0x19,             // ADD HL, DE
+			0x2B              // DEC HL
+		});
+		rom.Jr(0x18, loop);   // JR loop
+
+		return rom;
+	}
+
+	/*
+	* STAT interrupt on every HBlank : SCX follows LY
+	* and BGP is inverted, with the window on
+	*/
+	Bench::RomBuilder raster_rom() {
+		Bench::RomBuilder rom{ "BENCH RASTER" };
+
+		rom.Org(0x48);
+		rom.Emit({
+			0xF5,             // PUSH AF
+			0xF0, 0x44,       // LDH A, (LY)
+			0xE0, 0x43,       // LDH (SCX), A
+			0xF0, 0x47,       // LDH A, (BGP)
+			0x2F,             // CPL
+			0xE0, 0x47,       // LDH (BGP), A
+			0xF1,             // POP AF
+			0xD9              // RETI
+		});
+
+		rom.Org(0x150);
+
+		emit_prologue(rom);
+
+		rom.Emit({
+			0x3E, 0x50,       // LD A, 0x50
+			0xE0, 0x4B,       // LDH (WX), A
+			0x3E, 0x40,       // LD A, 0x40
+			0xE0, 0x4A,       // LDH (WY), A
+			0x3E, 0x08,       // LD A, 0x08
+			0xE0, 0x41        // LDH (STAT), A : HBlank interrupt
+		});
+
+		emit_halt_loop(rom, 0x02, 0xB1);
+
+		return rom;
+	}
+
+	/*
+	* 40 8x16 objects, one line apart so most lines
+	* hit the 10 objects limit, moved every VBlank
+	*/
+	Bench::RomBuilder sprites_rom() {
+		Bench::RomBuilder rom{ "BENCH SPRITES" };
+
+		rom.Org(0x40);
+		rom.Jp(0xC3, 0x0200); // JP vblank
+
+		rom.Org(0x150);
+
+		emit_prologue(rom);
+
+		rom.Emit({
+			0x21, 0x00, 0xFE, // LD HL, 0xFE00
+			0x0E, 0x10,       // LD C, 16
+			0x16, 0x08,       // LD D, 8
+			0x06, 0x28        // LD B, 40
+		});
+
+		auto setup = rom.Here();
+
+		rom.Emit({
+			0x79,             // LD A, C
+			0x22,             // LD (HL+), A : y
+			0x7A,             // LD A, D
+			0x22,             // LD (HL+), A : x
+			0x78,             // LD A, B
+			0x22,             // LD (HL+), A : tile
+			0xE6, 0x30,       // AND 0x30
+			0x22,             // LD (HL+), A : palette, x flip
+			0x0C,             // INC C
+			0x14, 0x14,       // INC D (x4)
+			0x14, 0x14,
+			0x05              // DEC B
+		});
+		rom.Jr(0x20, setup);  // JR NZ, setup
+
+		emit_halt_loop(rom, 0x01, 0x97);
+
+		rom.Org(0x200);
+		rom.Emit({
+			0xF5,             // PUSH AF
+			0xC5,             // PUSH BC
+			0xE5,             // PUSH HL
+			0x21, 0x00, 0xFE, // LD HL, 0xFE00
+			0x06, 0x28        // LD B, 40
+		});
+
+		auto move = rom.Here();
+
+		rom.Emit({
+			0x34,             // INC (HL) : y
+			0x23,             // INC HL
+			0x34,             // INC (HL) : x
+			0x23, 0x23, 0x23, // INC HL (x3)
+			0x05              // DEC B
+		});
+		rom.Jr(0x20, move);   // JR NZ, move
+
+		rom.Emit({
+			0xE1,             // POP HL
+			0xC1,             // POP BC
+			0xF1,             // POP AF
+			0xD9              // RETI
+		});
+
+		return rom;
+	}
+
+	/*
+	* The sprites above, written to a WRAM table and
+	* copied by OAM DMA every VBlank from a routine
+	* in HRAM, like most games do
+	*/
+	Bench::RomBuilder oam_dma_rom() {
+		static constexpr byte routine_size = 10;
+
+		Bench::RomBuilder rom{ "BENCH OAM DMA" };
+
+		rom.Org(0x40);
+		rom.Jp(0xC3, 0x0200); // JP vblank
+
+		rom.Org(0x150);
+
+		emit_prologue(rom);
+
+		rom.Emit({
+			0x21, 0x00, 0x03, // LD HL, routine
+			0x0E, 0x80,       // LD C, 0x80
+			0x06, routine_size // LD B, size
+		});
+
+		auto copy = rom.Here();
+
+		rom.Emit({
+			0x2A,             // LD A, (HL+)
+			0xE2,             // LD (C), A
+			0x0C,             // INC C
+			0x05              // DEC B
+		});
+		rom.Jr(0x20, copy);   // JR NZ, copy
+
+		rom.Emit({
+			0x21, 0x00, 0xC1, // LD HL, 0xC100
+			0x0E, 0x10,       // LD C, 16
+			0x16, 0x08,       // LD D, 8
+			0x06, 0x28        // LD B, 40
+		});
+
+		auto setup = rom.Here();
+
+		rom.Emit({
+			0x79,             // LD A, C
+			0x22,             // LD (HL+), A : y
+			0x7A,             // LD A, D
+			0x22,             // LD (HL+), A : x
+			0x78,             // LD A, B
+			0x22,             // LD (HL+), A : tile
+			0xE6, 0x30,       // AND 0x30
+			0x22,             // LD (HL+), A : palette, x flip
+			0x0C,             // INC C
+			0x14, 0x14,       // INC D (x4)
+			0x14, 0x14,
+			0x05              // DEC B
+		});
+		rom.Jr(0x20, setup);  // JR NZ, setup
+
+		emit_halt_loop(rom, 0x01, 0x97);
+
+		rom.Org(0x200);
+		rom.Emit({
+			0xF5,             // PUSH AF
+			0xC5,             // PUSH BC
+			0xE5,             // PUSH HL
+			0x21, 0x00, 0xC1, // LD HL, 0xC100
+			0x06, 0x28        // LD B, 40
+		});
+
+		auto move = rom.Here();
+
+		rom.Emit({
+			0x34,             // INC (HL) : y
+			0x23,             // INC HL
+			0x34,             // INC (HL) : x
+			0x23, 0x23, 0x23, // INC HL (x3)
+			0x05              // DEC B
+		});
+		rom.Jr(0x20, move);   // JR NZ, move
+
+		rom.Jp(0xCD, 0xFF80); // CALL dma
+		rom.Emit({
+			0xE1,             // POP HL
+			0xC1,             // POP BC
+			0xF1,             // POP AF
+			0xD9              // RETI
+		});
+
+		//Copied to 0xFF80, waits the 160 M-cycles
+		//of the transfer away from the bus
+		rom.Org(0x300);
+		rom.Emit({
+			0x3E, 0xC1,       // LD A, 0xC1
+			0xE0, 0x46,       // LDH (DMA), A
+			0x3E, 0x28,       // LD A, 40
+			0x3D,             // DEC A
+			0x20, 0xFD,       // JR NZ, -3
+			0xC9              // RET
+		});
+
+		return rom;
+	}
+
+	/*
+	* All 4 channels playing, with sweep and envelopes,
+	* retriggered every VBlank on a new frequency
+	*/
+	Bench::RomBuilder audio_rom() {
+		Bench::RomBuilder rom{ "BENCH AUDIO" };
+
+		rom.Org(0x40);
+		rom.Jp(0xC3, 0x0200); // JP vblank
+
+		rom.Org(0x150);
+
+		emit_prologue(rom);
+
+		//NR52 first, the other registers
+		//are ignored while sound is off
+		static constexpr std::pair<byte, byte> regs[] = {
+			{ 0x26, 0x80 }, { 0x24, 0x77 }, { 0x25, 0xFF },
+			{ 0x10, 0x17 }, { 0x11, 0x80 }, { 0x12, 0xF3 },
+			{ 0x16, 0x40 }, { 0x17, 0xF3 },
+			{ 0x1A, 0x80 }, { 0x1C, 0x20 },
+			{ 0x21, 0xF1 }, { 0x22, 0x35 }
+		};
+
+		for (auto [reg, value] : regs) {
+			rom.Emit({ 0x3E, value, 0xE0, reg }); // LD A, value ; LDH (reg), A
+		}
+
+		rom.Emit({ 0x21, 0x30, 0xFF }); // LD HL, wave ram
+
+		auto wave = rom.Here();
+
+		rom.Emit({
+			0x7D,             // LD A, L
+			0x22,             // LD (HL+), A
+			0x7D,             // LD A, L
+			0xFE, 0x40        // CP 0x40
+		});
+		rom.Jr(0x20, wave);   // JR NZ, wave
+
+		emit_halt_loop(rom, 0x01, 0x91);
+
+		rom.Org(0x200);
+		rom.Emit({
+			0xF5,             // PUSH AF
+			0xF0, 0x80,       // LDH A, (0xFF80)
+			0x3C,             // INC A
+			0xE0, 0x80,       // LDH (0xFF80), A
+			0xE0, 0x13,       // LDH (NR13), A
+			0xE0, 0x18,       // LDH (NR23), A
+			0xE0, 0x1D,       // LDH (NR33), A
+			0xE0, 0x22,       // LDH (NR43), A
+			0x3E, 0x87,       // LD A, 0x87
+			0xE0, 0x14,       // LDH (NR14), A
+			0xE0, 0x19,       // LDH (NR24), A
+			0xE0, 0x1E,       // LDH (NR34), A
+			0x3E, 0x80,       // LD A, 0x80
+			0xE0, 0x23,       // LDH (NR44), A
+			0xF1,             // POP AF
+			0xD9              // RETI
+		});
+
+		return rom;
+	}
+
+	/*
+	* MBC1 with 8 ROM banks, the main loop selects
+	* every bank and calls a routine in it, which
+	* reads the bank and writes cartridge RAM
+	*/
+	Bench::RomBuilder mbc_rom() {
+		static constexpr unsigned banks = 8;
+
+		Bench::RomBuilder rom{ "BENCH MBC", 0x02, banks, 0x02 };
+
+		for (unsigned bank = 1; bank < banks; bank++) {
+			std::size_t base = bank * 0x4000;
+
+			rom.Org(base);
+			rom.Emit({
+				0xFA, 0x00, 0x41, // LD A, (0x4100)
+				0x80,             // ADD A, B
+				0xEA, 0x00, 0xA0, // LD (0xA000), A
+				0xC9              // RET
+			});
+
+			rom.Org(base + 0x100);
+			rom.Emit({ (byte)bank });
+		}
+
+		rom.Org(0x150);
+
+		emit_prologue(rom);
+
+		rom.Emit({
+			0x3E, 0x0A,       // LD A, 0x0A
+			0xEA, 0x00, 0x00, // LD (0x0000), A : RAM enable
+			0x3E, 0x91,       // LD A, 0x91
+			0xE0, 0x40        // LDH (LCDC), A
+		});
+
+		auto start = rom.Here();
+
+		rom.Emit({ 0x06, 0x01 }); // LD B, 1
+
+		auto loop = rom.Here();
+
+		rom.Emit({
+			0x78,             // LD A, B
+			0xEA, 0x00, 0x20  // LD (0x2000), A : ROM bank
+		});
+		rom.Jp(0xCD, 0x4000); // CALL 0x4000
+		rom.Emit({
+			0x04,             // INC B
+			0x78,             // LD A, B
+			0xFE, (byte)banks // CP banks
+		});
+		rom.Jr(0x20, loop);   // JR NZ, loop
+		rom.Jr(0x18, start);  // JR start
+
+		return rom;
+	}
+
+	struct Workload {
+		const char* name;
+		Bench::RomBuilder(*build)();
+	};
+
+	static constexpr Workload workloads[] = {
+		{ "cpu_loop", cpu_loop_rom },
+		{ "raster", raster_rom },
+		{ "sprites", sprites_rom },
+		{ "oam_dma", oam_dma_rom },
+		{ "audio", audio_rom },
+		{ "mbc", mbc_rom }
+	};
+
+	bool same_state(Saves::Snapshot const& a, Saves::Snapshot const& b) {
+		if (a.Size() != b.Size()) {
+			return false;
+		}
+
+		for (std::size_t i = 0; i < Saves::section_count; i++) {
+			auto section = (Saves::Section)i;
+
+			//The state of the channels is not saved,
+			//only the samples being mixed
+			if (section == Saves::Section::apu) {
+				continue;
+			}
+
+			const byte* data = a.Data() + a.SectionOffset(section);
+
+			if (!std::equal(data, data + a.SectionSize(section),
+				b.Data() + a.SectionOffset(section))) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/*
+	* Takes a state, in the middle of an OAM DMA if
+	* the ROM does one, and loads it in a new emulator
+	* whose clock is at 0, like a movie does with its
+	* start state. Both must then run the same frames
+	*/
+	std::pair<bool, std::string> check_restore(State::EmulatorState& emu,
+		Workload const& work, std::string const& path, Logger& log) {
+		auto const& dma = emu.GetMemory()->GetDma();
+
+		for (unsigned cycles = 0; !dma.running && cycles < frame_cycles; ) {
+			cycles += emu.Step();
+		}
+
+		//Halfway through, the start of the transfer
+		//is then before the clock of the new emulator
+		while (dma.running && (int64_t)emu.GetCycleCount() < dma.start + 0x50 * 4) {
+			emu.Step();
+		}
+
+		Saves::Snapshot snap{};
+
+		emu.Capture(snap);
+
+		State::EmulatorState copy{ path, log };
+
+		if (!copy.Ok()) {
+			return { false, fmt::format("Cannot load the {} ROM", work.name) };
+		}
+
+		if (auto [ok, err] = copy.Restore(snap); !ok) {
+			return { false, err };
+		}
+
+		Saves::Snapshot expected{};
+		Saves::Snapshot restored{};
+
+		//Every frame, the next transfer would
+		//hide a wrong end of the first one
+		for (unsigned frame = 0; frame < check_frames; frame++) {
+			emu.RunFrame();
+			copy.RunFrame();
+
+			emu.Capture(expected);
+			copy.Capture(restored);
+
+			if (!same_state(expected, restored)) {
+				return { false, fmt::format("The {} state does not restore at cycle 0, "
+					"frame {} differs", work.name, frame) };
+			}
+		}
+
+		return { true, "" };
+	}
+
+	//Runs the frames on a fresh emulator and fills the result
+	std::pair<bool, std::string> run_workload(Workload const& work,
+		unsigned frames, Logger& log, Bench::Result& res) {
+		auto path = Bench::TempPath(fmt::format("learnboy_{}.gb", work.name));
+
+		auto rom = work.build();
+
+		if (auto [ok, err] = rom.Save(path); !ok) {
+			return { false, err };
+		}
+
+		State::EmulatorState emu{ path, log };
+
+		if (!emu.Ok()) {
+			std::remove(path.c_str());
+			return { false, fmt::format("Cannot load the {} ROM", work.name) };
+		}
+
+		auto const& ctx = emu.GetCPU()->GetContext();
+		auto profiler = emu.GetProfiler();
+
+		for (unsigned frame = 0; frame < warmup_frames; frame++) {
+			emu.RunFrame();
+		}
+
+		auto check = check_restore(emu, work, path, log);
+
+		std::remove(path.c_str());
+
+		if (!check.first) {
+			return check;
+		}
+
+		profiler->Reset();
+		profiler->Enable(true);
+
+		uint64_t instructions = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		//Same as RunFrame, counting the instructions
+		for (unsigned frame = 0; frame < frames; frame++) {
+			uint64_t count = emu.GetFrameCount();
+			unsigned cycles = 0;
+
+			while (emu.GetFrameCount() == count && cycles < frame_cycles) {
+				instructions += ctx.halted ? 0 : 1;
+				cycles += emu.Step();
+			}
+		}
+
+		double elapsed_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start
+		).count();
+
+		profiler->Enable(false);
+
+		double seconds = elapsed_ns / 1e9;
+
+		res.name = fmt::format("Throughput/{}", work.name);
+		res.iterations = frames;
+		res.real_time_ns = elapsed_ns / frames;
+		res.items_per_second = frames / seconds;
+
+		res.counters.emplace_back("frames_per_second", frames / seconds);
+		res.counters.emplace_back("instructions_per_second", instructions / seconds);
+		res.counters.emplace_back("realtime_factor", frames / seconds / gb_fps);
+
+		if (Debugger::Profiler::Available()) {
+			double components_ns = 0.0;
+			double probes_ns = 0.0;
+
+			for (std::size_t i = 0; i < Debugger::component_count; i++) {
+				auto comp = (Debugger::Component)i;
+				auto stats = profiler->Get(comp);
+				double ns = (double)stats.nanoseconds;
+
+				components_ns += ns;
+				probes_ns += stats.calls * profiler->ProbeOverheadNanoseconds();
+
+				res.counters.emplace_back(fmt::format("{}_percent",
+					Debugger::ComponentName(comp)), ns * 100.0 / elapsed_ns);
+			}
+
+			//Subtracted from the components
+			res.counters.emplace_back("probe_percent", probes_ns * 100.0 / elapsed_ns);
+
+			//Frame tasks and the loop itself
+			res.counters.emplace_back("other_percent",
+				std::max(0.0, elapsed_ns - components_ns - probes_ns) * 100.0 / elapsed_ns);
+		}
+
+		return { true, "" };
+	}
+}
+
+int main(int argc, char** argv) {
+	Bench::Runner runner{};
+	std::string msg{};
+
+	if (!runner.ParseArgs(argc, argv, msg, { "frames" })) {
+		std::cerr << msg << "\n";
+		return 1;
+	}
+
+	unsigned frames = 0;
+
+	try {
+		frames = (unsigned)std::stoul(runner.GetOption("frames", "600"));
+	}
+	catch (std::exception const&) {
+		frames = 0;
+	}
+
+	if (frames == 0) {
+		std::cerr << "Invalid frame count\n";
+		return 1;
+	}
+
+	if (!Debugger::Profiler::Available()) {
+		std::cerr << "Component split not available, "
+			"configure with -DLEARNBOY_PROFILER=ON\n";
+	}
+
+	Logger log{};
+
+	if (auto [ok, err] = runner.RedirectLog(log); !ok) {
+		std::cerr << "Cannot open the log file : " << err << "\n";
+		return 1;
+	}
+
+	for (auto const& work : workloads) {
+		if (!runner.Matches(fmt::format("Throughput/{}", work.name))) {
+			continue;
+		}
+
+		Bench::Result res{};
+
+		if (auto [ok, err] = run_workload(work, frames, log, res); !ok) {
+			std::cerr << err << "\n";
+			return 1;
+		}
+
+		std::cerr << fmt::format("{:<24} {:>10.1f} fps {:>8.2f}x {:>12.0f} instr/s\n",
+			res.name, res.counters[0].second, res.counters[2].second,
+			res.counters[1].second);
+
+		for (std::size_t i = 3; i < res.counters.size(); i++) {
+			std::cerr << fmt::format("    {:<28} {:>6.1f} %\n",
+				res.counters[i].first, res.counters[i].second);
+		}
+
+		runner.AddResult(std::move(res));
+	}
+
+	return runner.Report(argv[0]) ? 0 : 1;
+}
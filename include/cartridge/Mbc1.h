@@ -6,11 +6,19 @@ namespace GameboyEmu::State {
 	class EmulatorState;
 }
 
+namespace GameboyEmu::Mem {
+	class RomImage;
+}
+
+namespace GameboyEmu::Saves {
+	class MappedSram;
+}
+
 namespace GameboyEmu::Cartridge {
 
 	class Mbc1 : public MemoryCard {
 	public:
-		Mbc1(State::EmulatorState* state, byte* data, unsigned numb);
+		Mbc1(State::EmulatorState* state, Mem::RomImage* rom);
 
 		byte Read(word address) override;
 		void Write(word address, byte value) override;
@@ -20,11 +28,12 @@ namespace GameboyEmu::Cartridge {
 		bool SupportsSaves() const override;
 		const byte* GetRamBuffer() const override;
 		void LoadRamSave(byte* buf) override;
+		std::pair<bool, std::string> MapRamSave(std::string const& path) override;
 
 		~Mbc1();
 
 		std::size_t DumpState(byte* buffer, std::size_t offset) override;
-		std::size_t LoadState(byte* buffer, std::size_t offset) override;
+		std::size_t LoadState(const byte* buffer, std::size_t offset) override;
 
 		std::vector<replace_type> ApplyPatch(byte replace, word address, short compare) override;
 		void RemovePatch(std::vector<replace_type> const& replaces, word address) override;
@@ -33,7 +42,8 @@ namespace GameboyEmu::Cartridge {
 
 	private:
 		State::EmulatorState* m_state;
-		byte* m_therom;     //rom memory
+		Mem::RomImage* m_image;
+		const byte* m_therom;     //rom memory
 		unsigned m_numbytes; //len of rom
 		byte m_second_bank_num;     //current rom bank
 		byte m_bank_num_hi;   //high bits of rom bank number
@@ -45,6 +55,9 @@ namespace GameboyEmu::Cartridge {
 		byte m_numrambanks; //number of ram banks
 
 		byte* m_sram;
+
+		//Not null when m_sram points to a mapped file
+		Saves::MappedSram* m_mapped;
 	};
 
 }
\ No newline at end of file
@@ -9,11 +9,19 @@ namespace GameboyEmu {
 	}
 }
 
+namespace GameboyEmu::Mem {
+	class RomImage;
+}
+
+namespace GameboyEmu::Saves {
+	class MappedSram;
+}
+
 namespace GameboyEmu::Cartridge {
 
 	class Mbc3 : public MemoryCard {
 	public :
-		Mbc3(State::EmulatorState* state, byte* data, unsigned numb);
+		Mbc3(State::EmulatorState* state, Mem::RomImage* rom);
 
 		byte Read(word address) override;
 		void Write(word address, byte value) override;
@@ -23,9 +31,10 @@ namespace GameboyEmu::Cartridge {
 		bool SupportsSaves() const override;
 		const byte* GetRamBuffer() const override;
 		void LoadRamSave(byte* buf) override;
+		std::pair<bool, std::string> MapRamSave(std::string const& path) override;
 
 		std::size_t DumpState(byte* buffer, std::size_t offset) override;
-		std::size_t LoadState(byte* buffer, std::size_t offset) override;
+		std::size_t LoadState(const byte* buffer, std::size_t offset) override;
 
 		std::vector<replace_type> ApplyPatch(byte replace, word address, short compare) override;
 		void RemovePatch(std::vector<replace_type> const& replaces, word address) override;
@@ -36,11 +45,15 @@ namespace GameboyEmu::Cartridge {
 
 	private :
 		State::EmulatorState* m_state;
-		byte* m_rom;
+		Mem::RomImage* m_image;
+		const byte* m_rom;
 
 		byte m_bank_number;
 
 		byte* m_sram;
+
+		//Not null when m_sram points to a mapped file
+		Saves::MappedSram* m_mapped;
 		byte m_ram_bank_number;
 
 		bool m_enable_rtc_ram;
@@ -93,8 +93,15 @@ namespace GameboyEmu {
 			virtual const byte* GetRamBuffer() const = 0;
 			virtual void LoadRamSave(byte* buf) = 0;
 
+			/*
+			* Replaces the RAM buffer with a memory
+			* mapped .sav file, only for cartridges
+			* with battery backed RAM
+			*/
+			virtual std::pair<bool, std::string> MapRamSave(std::string const& path);
+
 			virtual std::size_t DumpState(byte* buffer, std::size_t offset) = 0;
-			virtual std::size_t LoadState(byte* buffer, std::size_t offset) = 0;
+			virtual std::size_t LoadState(const byte* buffer, std::size_t offset) = 0;
 
 			using replace_type = std::pair<word, byte>;
 
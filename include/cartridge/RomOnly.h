@@ -13,16 +13,21 @@ namespace GameboyEmu {
 		class EmulatorState;
 	}
 
+	namespace Mem {
+		class RomImage;
+	}
+
 	namespace Cartridge {
 
 		class RomOnly : public MemoryCard {
 		private:
 			State::EmulatorState* m_state;
-			byte* m_rom;
+			Mem::RomImage* m_image;
+			const byte* m_rom;
 			unsigned m_bytes;
 
 		public:
-			RomOnly(State::EmulatorState* state, byte* theRom, unsigned numbytes);
+			RomOnly(State::EmulatorState* state, Mem::RomImage* rom);
 
 			//Read and write generic cartridge
 			byte Read(word address) override;
@@ -40,7 +45,7 @@ namespace GameboyEmu {
 			void LoadRamSave(byte* buf) override;
 
 			std::size_t DumpState(byte* buffer, std::size_t offset) override;
-			std::size_t LoadState(byte* buffer, std::size_t offset) override;
+			std::size_t LoadState(const byte* buffer, std::size_t offset) override;
 
 			std::vector<replace_type> ApplyPatch(byte replace, word address, short compare) override;
 			void RemovePatch(std::vector<replace_type> const& replaces, word address) override;
@@ -59,7 +59,7 @@ inline void WriteWord(byte* buffer, std::size_t offset, word value) {
 	buffer[offset] = ((value >> 8) & 0xFF);
 }
 
-inline word ReadWord(byte* buffer, std::size_t offset) {
+inline word ReadWord(const byte* buffer, std::size_t offset) {
 	word ret = 0;
 
 	ret = buffer[offset++];
@@ -73,5 +73,11 @@ namespace StaticData {
 	static constexpr uint32_t hram_size = 0xFFFF - 0xFF80;
 	static constexpr uint32_t vram_size = 8 * 1024;
 	static constexpr uint32_t oam_size = 0xFE9F - 0xFE00 + 1;
-	static constexpr uint32_t dmg_bootrom_size = 0xFF;
+	static constexpr uint32_t dmg_bootrom_size = 0x100;
+
+	//Bytes of the boot rom kept in the states,
+	//the layout has always stored 0xFF of them
+	static constexpr uint32_t bootrom_state_size = 0xFF;
+	//Upper bound for the serialized emulator state
+	static constexpr uint32_t max_state_size = 256 * 1024;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "../logging/Logger.h"
 #include "../memory/Memory.h"
 #include "./CpuContext.h"
+#include "./IdleDetector.h"
 
 namespace GameboyEmu {
 	namespace State {
@@ -13,6 +14,11 @@ namespace GameboyEmu {
 		class Memory;
 	}
 
+	namespace Debugger {
+		class Profiler;
+		class Tracer;
+	}
+
 	namespace CPU {
 
 		using jmp_type = byte(*)(CPU::CpuContext&, Mem::Memory*, State::EmulatorState*);
@@ -28,9 +34,11 @@ namespace GameboyEmu {
 
 			/*
 			* Executes exactly one instruction,
-			* and returns the number of cycles
+			* and returns the number of cycles.
+			* A halted cpu, or an idle loop, runs up
+			* to the next event in one step
 			*/
-			byte Step();
+			unsigned Step();
 
 			word GetIP() const;
 			void ResetIP();
@@ -42,7 +50,7 @@ namespace GameboyEmu {
 			~Cpu();
 
 			std::size_t DumpState(byte* buffer, std::size_t offset);
-			std::size_t LoadState(byte* buffer, std::size_t offset);
+			std::size_t LoadState(const byte* buffer, std::size_t offset);
 
 		private:
 			//Registers
@@ -55,6 +63,14 @@ namespace GameboyEmu {
 			//Instructions
 			jmp_type* m_jumpTable;
 
+			Debugger::Profiler* m_profiler;
+			Debugger::Tracer* m_tracer;
+
+			//IE and IF of the memory
+			Mem::InterruptController* m_interrupts;
+
+			IdleDetector m_idle;
+
 			//Init jump table
 			void fillTable();
 
@@ -66,13 +82,19 @@ namespace GameboyEmu {
 			/*
 			* Serves one specific interrupt
 			*/
-			byte serve_interrupt(byte type);
+			byte serve_interrupt(Mem::Interrupt type);
 
 			/*
 			* Saves the Instruction Pointer
 			* and jumps to the interrupt handler
 			*/
 			void interrupt_routine(word address);
+
+			//Records the fetched instruction in the tracer
+			void trace(byte instruction);
+
+			//Runs the halted cpu up to the next event
+			unsigned halted_step();
 		};
 
 	}
@@ -182,5 +182,11 @@ namespace GameboyEmu {
 		* of that instruction
 		*/
 		std::pair< std::string, byte > Disassemble(word address, Mem::Memory* mem);
+
+		/*
+		* Same, from the bytes of the instruction,
+		* missing parameters are not printed
+		*/
+		std::pair< std::string, byte > Disassemble(const byte* code, std::size_t size);
 	}
 }
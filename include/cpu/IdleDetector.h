@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "./CpuContext.h"
+
+#include <cstdint>
+
+namespace GameboyEmu {
+	namespace State {
+		class EmulatorState;
+	}
+
+	namespace Mem {
+		class Memory;
+	}
+
+	namespace CPU {
+
+		/*
+		* Detects the busy-wait loops of the games, like
+		*
+		*	wait:	LDH A, (0x44)
+		*		CP 0x90
+		*		JR NZ, wait
+		*
+		* A loop is idle when its body only reads memory
+		* that changes with the PPU (or not at all), and
+		* when the registers are the same at two arrivals
+		* at its head : every iteration is then the same
+		* until the next event (see EmulatorState::CyclesToEvent),
+		* and the iterations before it are skipped at once
+		*/
+		class IdleDetector {
+		public:
+			//Longest body, from the head to the jump
+			static constexpr word max_length = 16;
+
+			IdleDetector();
+
+			//Forgets the arrivals, after code
+			//outside of the loop has run
+			inline void Reset() {
+				m_armed = false;
+			}
+
+			/*
+			* Called when the jump at end went back to head.
+			* Skips the iterations that would be the same
+			* and returns their clock cycles
+			*/
+			uint64_t Closed(word head, word end, CpuContext const& ctx,
+				Mem::Memory* mem, State::EmulatorState* state);
+
+		private:
+			//Registers that an instruction of the body
+			//can write or use as a pointer
+			enum Register : byte {
+				reg_b = 0x01,
+				reg_c = 0x02,
+				reg_d = 0x04,
+				reg_e = 0x08,
+				reg_h = 0x10,
+				reg_l = 0x20,
+				reg_a = 0x40
+			};
+
+			//Only reads of memory and register operations
+			bool analyse(word head, word end, Mem::Memory* mem);
+
+			//Adds one instruction of the body, false
+			//if it cannot be part of an idle loop
+			bool add_instruction(byte opcode, byte low, byte high);
+
+			//Memory that only the cpu and the PPU modify
+			static bool safe_read(word address);
+
+			//The pointers of the body point to safe memory
+			bool safe_pointers(CpuContext const& ctx) const;
+
+			bool same_registers(CpuContext const& ctx) const;
+
+			void arrive(CpuContext const& ctx, State::EmulatorState* state);
+
+		private:
+			//Loop being observed
+			word m_head;
+			word m_end;
+			byte m_bank;
+
+			bool m_idle;
+
+			byte m_written;
+			byte m_pointers;
+
+			//Last arrival at the head
+			bool m_armed;
+			CpuContext m_arrival;
+			uint64_t m_time;
+
+			//No event before this clock cycle
+			//since the last arrival
+			uint64_t m_deadline;
+		};
+	}
+}
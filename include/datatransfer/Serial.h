@@ -29,6 +29,11 @@ namespace GameboyEmu::DataTransfer {
 
 		void Clock(byte cycles);
 
+		//A transfer is in progress
+		inline bool Transferring() const {
+			return m_flag.load(std::memory_order_relaxed);
+		}
+
 		void SetMemory(Mem::Memory* mmu);
 
 		void Listen(std::string const& on);
@@ -40,7 +45,7 @@ namespace GameboyEmu::DataTransfer {
 		void RequestInterrupt(byte data);
 
 		std::size_t DumpState(byte* buffer, std::size_t offset);
-		std::size_t LoadState(byte* buffer, std::size_t offset);
+		std::size_t LoadState(const byte* buffer, std::size_t offset);
 
 		static constexpr unsigned clock_rate = 512;
 
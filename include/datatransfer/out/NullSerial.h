@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../SerialDevice.h"
+
+namespace GameboyEmu::DataTransfer {
+	/*
+	* Serial device with nothing connected,
+	* used by headless instances so that
+	* no socket is opened for each of them
+	*/
+	class NullSerial : public SerialDevice {
+	public :
+		NullSerial() = default;
+
+		bool Send(byte& in) override;
+		void SetOut(byte out) override;
+
+		void Listen(std::string const& on) override;
+		void Connect(std::string const& to) override;
+		void CloseConnection() override;
+
+		void SetClockType(byte type) override;
+
+		bool Connected() const override;
+
+		~NullSerial() override = default;
+	};
+}
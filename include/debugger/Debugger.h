@@ -4,6 +4,8 @@
 #include "Breakpoint.h"
 #include "StacktraceEntry.h"
 
+#include <array>
+#include <cstdint>
 #include <ostream>
 #include <map>
 #include <optional>
@@ -54,8 +56,10 @@ namespace GameboyEmu::Debugger {
 		void WatchpointsDisableAll();
 		void WatchpointsEnableAll();
 
-		void WatchpointSet(word address, byte type, Callbak&& callback, std::ostream& out, bool useout);
-		void WatchpointChange(word address, byte type, std::ostream& out, bool useout);
+		//type is a WatchType, value restricts the watchpoint
+		//to the accesses reading or writing it
+		void WatchpointSet(word address, byte type, std::optional<byte> value, Callbak&& callback, std::ostream& out, bool useout);
+		void WatchpointChange(word address, byte type, std::optional<byte> value, std::ostream& out, bool useout);
 		void WatchpointDelete(word address, std::ostream& out, bool useout);
 		void WatchpointToggle(word address, bool enable, std::ostream& out, bool useout);
 
@@ -85,6 +89,12 @@ namespace GameboyEmu::Debugger {
 		bool check_breakpoint(bool existsok, byte page, word address, std::ostream& out, bool useout);
 		bool breakpoint_triggered(word address);
 
+		bool check_watchpoint(bool existsok, word address, std::ostream& out, bool useout);
+		bool check_watch_type(byte type, std::ostream& out, bool useout);
+
+		//Called every time the breakpoints change
+		void rebuild_bitmap();
+
 	private :
 		State::EmulatorState* m_state;
 
@@ -94,6 +104,14 @@ namespace GameboyEmu::Debugger {
 		
 		std::multimap<word, Breakpoint> m_breakpoints;
 
+		/*
+		* One bit per address, set when an enabled
+		* breakpoint is there in any bank, so most
+		* instructions are checked with one bit test.
+		* The bank is checked on the multimap after
+		*/
+		std::array<uint64_t, 0x10000 / 64> m_break_bits;
+
 		std::thread m_emu_thread;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "StacktraceEntry.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GameboyEmu::Debugger {
+	/*
+	* Sampling profiler of the game code : every period
+	* cycles the program counter is recorded with its ROM
+	* bank, along with the call stack tracked by the
+	* emulator (see EmulatorState::add_stacktrace_entry).
+	*
+	* Symbols come from RGBDS .sym files, the call stacks
+	* are written in the folded format read by flamegraph.pl,
+	* inferno and speedscope.
+	*
+	* Samples are taken on the emulation thread, the
+	* reports can be made from any thread
+	*/
+	class GuestProfiler {
+	public :
+		static constexpr unsigned default_period = 4096;
+
+		//Innermost calls kept for each sample
+		static constexpr std::size_t max_depth = 64;
+
+		GuestProfiler();
+
+		//Period in clock cycles (4 per M-cycle)
+		void SetPeriod(unsigned cycles);
+		unsigned GetPeriod() const;
+
+		void Reset();
+
+		//Counts down the cycles of an instruction,
+		//true when a sample is due
+		inline bool Advance(unsigned cycles) {
+			m_countdown -= (int)cycles;
+
+			if (m_countdown > 0) {
+				return false;
+			}
+
+			m_countdown += (int)m_period.load(std::memory_order_relaxed);
+
+			return true;
+		}
+
+		void Sample(byte bank, word pc, std::vector<StacktraceEntry> const& stack);
+
+		uint64_t SampleCount() const;
+
+		//Adds the symbols of an RGBDS .sym file
+		std::pair<bool, std::string> LoadSymbols(std::string const& path);
+
+		//"name+offset", or "bank:address" without symbols
+		std::string Symbolize(byte bank, word address) const;
+
+		//Most sampled bank:address pairs
+		void PrintTop(std::ostream& out, unsigned count) const;
+
+		//One "outer;inner;leaf count" line per call stack
+		std::pair<bool, std::string> WriteFolded(std::string const& path) const;
+
+	private :
+		static inline uint32_t make_key(byte bank, word address) {
+			return ((uint32_t)bank << 16) | address;
+		}
+
+		//Symbol containing the address, nullptr if none
+		std::pair<uint32_t, std::string> const* find_symbol(uint32_t key) const;
+
+		//inside : the name of the function containing
+		//the address, else the exact symbol
+		std::string frame_name(uint32_t key, bool inside) const;
+
+	private :
+		mutable std::mutex m_mutex;
+
+		std::atomic<unsigned> m_period;
+		int m_countdown;
+
+		uint64_t m_samples;
+
+		std::unordered_map<uint32_t, uint64_t> m_hits;
+		std::map<std::vector<uint32_t>, uint64_t> m_stacks;
+
+		//Sorted by bank, then address
+		std::vector<std::pair<uint32_t, std::string>> m_symbols;
+	};
+}
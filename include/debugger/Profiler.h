@@ -0,0 +1,251 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define LEARNBOY_HAS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LEARNBOY_HAS_RDTSC
+#endif
+
+/*
+* Instrumentation of Cpu::Step and of the components
+* ticked by EmulatorState::Sync. It is compiled only with
+* LEARNBOY_PROFILER defined (cmake -DLEARNBOY_PROFILER=ON),
+* otherwise the macros are the bare call or nothing
+*/
+
+#ifdef LEARNBOY_PROFILER
+//Profiles the rest of the enclosing block
+#define PROFILE_SCOPE(profiler, component) \
+	GameboyEmu::Debugger::ProfileScope profile_block_{ profiler, component }
+
+#define PROFILED(profiler, component, call) \
+	do { \
+		GameboyEmu::Debugger::ProfileScope profile_scope_{ \
+			profiler, component \
+		}; \
+		call; \
+	} while(0)
+
+//Same, the time is also added to the opcode
+#define PROFILED_OPCODE(profiler, opcode, call) \
+	do { \
+		GameboyEmu::Debugger::ProfileScope profile_scope_{ \
+			profiler, GameboyEmu::Debugger::Component::cpu_execute, (int)(opcode) \
+		}; \
+		call; \
+	} while(0)
+#else
+#define PROFILE_SCOPE(profiler, component)
+#define PROFILED(profiler, component, call) call
+#define PROFILED_OPCODE(profiler, opcode, call) call
+#endif
+
+namespace GameboyEmu::Debugger {
+	//The ppu modes are in the order of the STAT mode bits
+	enum class Component : unsigned {
+		cpu_decode,
+		cpu_execute,
+		ppu_hblank,
+		ppu_vblank,
+		ppu_oam,
+		ppu_transfer,
+		apu,
+		timer,
+		dma,
+		serial,
+		count
+	};
+
+	static constexpr std::size_t component_count = (std::size_t)Component::count;
+
+	//0x00 - 0xFF normal opcodes, 0x100 - 0x1FF CB prefixed
+	static constexpr std::size_t opcode_count = 512;
+
+	const char* ComponentName(Component component);
+
+	//Mnemonic of an opcode id (see opcode_count)
+	const char* OpcodeName(unsigned id);
+
+	inline Component PpuComponent(byte mode) {
+		return (Component)((unsigned)Component::ppu_hblank + (mode & 0x03));
+	}
+
+	struct ComponentStats {
+		uint64_t nanoseconds;
+		uint64_t calls;
+	};
+
+	/*
+	* Times are exclusive : a scope opened inside another
+	* one (the Sync calls made by an instruction) is
+	* subtracted from the outer one.
+	*
+	* The cost of the probes themselves, measured once
+	* when the profiler is created, is subtracted too :
+	* otherwise a component doing nothing, like the idle
+	* serial port, shows the time of its probe.
+	*
+	* Counters are written by the emulation thread only,
+	* they can be read and reset from the cli thread
+	*/
+	class Profiler {
+	public :
+		Profiler();
+
+		//Collection starts disabled, even when compiled in
+		void Enable(bool enable);
+
+		inline bool Enabled() const {
+			return m_enabled.load(std::memory_order_relaxed);
+		}
+
+		void Reset();
+
+		//Host ticks : rdtsc where available, else nanoseconds
+		static inline uint64_t Now() {
+#ifdef LEARNBOY_HAS_RDTSC
+			return __rdtsc();
+#else
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()
+			).count();
+#endif
+		}
+
+		inline void Add(Component component, uint64_t ticks) {
+			add(m_components[(std::size_t)component], ticks);
+		}
+
+		inline void AddOpcode(unsigned id, uint64_t ticks) {
+			add(m_opcodes[id], ticks);
+		}
+
+		//Ticks of the scopes closed so far, see ProfileScope
+		inline uint64_t& Nested() {
+			return m_nested;
+		}
+
+		//Ticks measured by a scope around nothing
+		inline uint64_t ProbeTicks() const {
+			return m_probe_ticks;
+		}
+
+		//Ticks a scope costs to the enclosing one
+		//besides the time it measures itself
+		inline uint64_t ChildTicks() const {
+			return m_child_ticks;
+		}
+
+		//Probe cost subtracted from every call
+		double ProbeOverheadNanoseconds() const;
+
+		ComponentStats Get(Component component) const;
+		ComponentStats GetOpcode(unsigned id) const;
+
+		//Host time since the last Reset, while enabled
+		uint64_t ElapsedNanoseconds() const;
+
+		//Components sorted by time, then the
+		//max_opcodes most expensive opcodes
+		void PrintTable(std::ostream& out, unsigned max_opcodes) const;
+
+		void DumpJson(std::ostream& out) const;
+
+		//True if the core was built with LEARNBOY_PROFILER
+		static constexpr bool Available() {
+#ifdef LEARNBOY_PROFILER
+			return true;
+#else
+			return false;
+#endif
+		}
+
+	private :
+		struct Counter {
+			std::atomic<uint64_t> ticks;
+			std::atomic<uint64_t> calls;
+		};
+
+		//Single writer, no locked instructions needed
+		static inline void add(Counter& counter, uint64_t ticks) {
+			counter.ticks.store(counter.ticks.load(std::memory_order_relaxed) + ticks,
+				std::memory_order_relaxed);
+			counter.calls.store(counter.calls.load(std::memory_order_relaxed) + 1,
+				std::memory_order_relaxed);
+		}
+
+		double ticks_per_ns() const;
+		ComponentStats to_stats(Counter const& counter) const;
+
+		//Measures m_probe_ticks and m_child_ticks
+		void calibrate();
+
+	private :
+		std::array<Counter, component_count> m_components;
+		std::array<Counter, opcode_count> m_opcodes;
+
+		uint64_t m_nested;
+
+		uint64_t m_probe_ticks;
+		uint64_t m_child_ticks;
+
+		std::atomic<bool> m_enabled;
+
+		//Used to convert ticks to nanoseconds
+		std::atomic<uint64_t> m_start_ticks;
+		std::atomic<int64_t> m_start_time;
+
+		//Time spent enabled
+		std::atomic<int64_t> m_segment_start;
+		std::atomic<uint64_t> m_enabled_ns;
+	};
+
+	//Adds the exclusive lifetime of the object to a component
+	class ProfileScope {
+	public :
+		inline ProfileScope(Profiler* profiler, Component component, int opcode = -1) :
+			m_profiler(profiler->Enabled() ? profiler : nullptr),
+			m_component(component), m_opcode(opcode),
+			m_start(), m_nested_start() {
+			if (m_profiler) {
+				m_nested_start = m_profiler->Nested();
+				m_start = Profiler::Now();
+			}
+		}
+
+		inline ~ProfileScope() {
+			if (m_profiler) {
+				uint64_t total = Profiler::Now() - m_start;
+				uint64_t& nested = m_profiler->Nested();
+
+				uint64_t cost = (nested - m_nested_start) + m_profiler->ProbeTicks();
+				uint64_t self = total > cost ? total - cost : 0;
+
+				m_profiler->Add(m_component, self);
+
+				if (m_opcode >= 0) {
+					m_profiler->AddOpcode((unsigned)m_opcode, self);
+				}
+
+				nested = m_nested_start + total + m_profiler->ChildTicks();
+			}
+		}
+
+	private :
+		Profiler* m_profiler;
+		Component m_component;
+		int m_opcode;
+		uint64_t m_start;
+		uint64_t m_nested_start;
+	};
+}
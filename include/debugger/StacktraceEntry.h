@@ -8,5 +8,6 @@ namespace GameboyEmu::Debugger {
 		word dest_address;
 		word ret_address;
 		byte page;
+		byte dest_page; // bank of dest_address when called
 	};
 }
\ No newline at end of file
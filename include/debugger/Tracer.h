@@ -0,0 +1,140 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace GameboyEmu::Debugger {
+	//One executed instruction, registers are
+	//the values before its execution
+	struct TraceRecord {
+		uint64_t cycle;
+
+		word pc;
+		word af;
+		word bc;
+		word de;
+		word hl;
+		word sp;
+
+		//ROM bank of pc, 0 outside of the ROM
+		byte bank;
+
+		//Opcode and the next two bytes
+		byte code[3];
+	};
+
+	static_assert(sizeof(TraceRecord) == 24, "Trace records are written as is");
+
+	/*
+	* Execution tracer : the cpu writes a record per
+	* instruction in a ring buffer keeping the last
+	* capacity instructions.
+	*
+	* The ring has a single writer, the emulation thread.
+	* Readers copy the records then check they have not
+	* been overwritten meanwhile, nothing is locked.
+	*
+	* The records can also be streamed to a file by a
+	* background thread, see StartStream. Files start
+	* with a header (magic "LBTRACE", version, record
+	* size) followed by the records, in host byte order
+	*/
+	class Tracer {
+	public :
+		static constexpr std::size_t default_capacity = 1 << 20;
+
+		Tracer();
+		~Tracer();
+
+		inline bool Enabled() const {
+			return m_enabled.load(std::memory_order_acquire);
+		}
+
+		//Allocates the ring the first time
+		void Enable(bool enable);
+
+		//Rounded up to a power of two, the tracer must be
+		//disabled and the cpu stopped, the ring is freed
+		std::pair<bool, std::string> SetCapacity(std::size_t records);
+		std::size_t GetCapacity() const;
+
+		//Only the records written after are kept
+		void Clear();
+
+		inline void Record(TraceRecord const& record) {
+			uint64_t head = m_head.load(std::memory_order_relaxed);
+
+			m_ring[head & m_mask] = record;
+
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		//Records written since the last Clear
+		uint64_t Count() const;
+
+		//Last count records still in the ring, oldest first
+		std::vector<TraceRecord> Last(std::size_t count) const;
+
+		//Writes the content of the ring
+		std::pair<bool, std::string> Dump(std::string const& path) const;
+
+		//Appends every new record to path until StopStream
+		std::pair<bool, std::string> StartStream(std::string const& path);
+		void StopStream();
+
+		bool Streaming() const;
+
+		//Records overwritten before the stream wrote them
+		uint64_t Dropped() const;
+
+		static std::pair<bool, std::string> ReadFile(std::string const& path,
+			std::vector<TraceRecord>& records);
+
+		//"cycle bank:pc instruction registers"
+		static std::string Format(TraceRecord const& record);
+
+	private :
+		//Index of the oldest record of the ring that can
+		//be read, given the head read after copying
+		uint64_t first_valid(uint64_t head) const;
+
+		//Copies the records [from, to) to out, returns
+		//the index of the first one that is still valid
+		uint64_t copy(uint64_t from, uint64_t to, TraceRecord* out) const;
+
+		static void write_header(std::ostream& out);
+
+		void stream_loop();
+		bool stream_drain();
+
+	private :
+		//Null until the first Enable or SetCapacity
+		TraceRecord* m_ring;
+		std::size_t m_mask;
+
+		//Total records written, the next one goes
+		//at m_head & m_mask
+		std::atomic<uint64_t> m_head;
+
+		//Index of the first record after the last Clear
+		std::atomic<uint64_t> m_start;
+
+		std::atomic<bool> m_enabled;
+
+		std::ofstream m_stream_file;
+		std::thread m_stream_thread;
+		std::atomic<bool> m_streaming;
+
+		//Next record to write, used by the stream thread
+		uint64_t m_stream_pos;
+		std::vector<TraceRecord> m_stream_buffer;
+		std::atomic<uint64_t> m_dropped;
+	};
+}
@@ -20,6 +20,16 @@ namespace GameboyEmu::Debugger {
 		word address;
 		bool enabled;
 		WatchType type; 
+		//Only triggers when value is read or written
+		bool conditional;
+		byte value;
 		Callbak callback;
 	};
-}
\ No newline at end of file
+
+	//Access that triggered the last watchpoint
+	struct WatchHit {
+		word address;
+		byte value;
+		bool write;
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../state/Frontend.h"
+
+namespace GameboyEmu::Frontend {
+	/*
+	* Desktop frontend: SDL window and audio,
+	* serial link through UDP sockets
+	*/
+	class SdlFrontend : public State::Frontend {
+	public :
+		SdlFrontend() = default;
+
+		Graphics::Screen* CreateScreen(Logger& log, std::function<void()> on_stop) override;
+		Sound::OutputDevice* CreateAudio(Logger& log) override;
+		DataTransfer::SerialDevice* CreateSerial() override;
+
+		~SdlFrontend() override = default;
+	};
+}
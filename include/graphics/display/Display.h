@@ -9,13 +9,14 @@
 
 #include "../../logging/Logger.h"
 #include "../../input/Joypad.h"
+#include "Screen.h"
 
 #include <functional>
 
 namespace GameboyEmu {
 	namespace Graphics {
 
-		class Display {
+		class Display : public Screen {
 		private:
 			unsigned m_width;
 			unsigned m_height;
@@ -43,11 +44,12 @@ namespace GameboyEmu {
 
 			bool m_ctrl_status;
 
+			std::atomic<bool> m_rewind_held;
+
 			static constexpr unsigned buffer_size = 160 * 144 * 4;
 
 		private:
 			void ScaleAndSetPixel(unsigned i, unsigned j, unsigned* dest);
-			void SetPixels(unsigned* dest);
 
 			void KeyboardDown(SDL_KeyboardEvent* ev);
 			void KeyboardUp(SDL_KeyboardEvent* ev);
@@ -55,25 +57,33 @@ namespace GameboyEmu {
 		public:
 			Display(Logger& logger, std::function<void()> ctrl_c);
 
-			bool Init(unsigned w, unsigned h, unsigned scale);
+			bool Init(unsigned w, unsigned h, unsigned scale) override;
 
 			void Loop();
 
 			void Render();
 
-			void SetFrame(byte* buffer);
+			void SetFrame(byte* buffer) override;
+
+			//Scales the current frame into ARGB pixels,
+			//dest holds (w * scale) * (h * scale) values
+			void SetPixels(unsigned* dest);
 
 			void ProcessEvent(SDL_Event* ev);
 
-			bool IsStop();
+			bool IsStop() override;
+
+			void Stop() override;
 
-			void Stop();
+			void FramePresent() override;
 
-			void FramePresent();
+			void SetJoypad(Input::Joypad* joypad) override;
 
-			void SetJoypad(Input::Joypad* joypad);
+			//True while the rewind key (backspace)
+			//is held down
+			bool RewindHeld() const override;
 
-			~Display();
+			~Display() override;
 		};
 	}
 }
\ No newline at end of file
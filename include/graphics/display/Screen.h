@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../common/Common.h"
+
+namespace GameboyEmu {
+	namespace Input {
+		class Joypad;
+	}
+
+	namespace Graphics {
+		/*
+		* What the emulator needs from a window:
+		* showing frames, the joypad input and
+		* the request to stop. Display implements
+		* it with SDL, the core only knows this
+		* interface
+		*/
+		class Screen {
+		public :
+			virtual bool Init(unsigned w, unsigned h, unsigned scale) = 0;
+
+			virtual void SetFrame(byte* buffer) = 0;
+			virtual void FramePresent() = 0;
+
+			virtual bool IsStop() = 0;
+			virtual void Stop() = 0;
+
+			virtual void SetJoypad(Input::Joypad* joypad) = 0;
+
+			//True while the rewind key is held down
+			virtual bool RewindHeld() const = 0;
+
+			virtual ~Screen() {}
+		};
+	}
+}
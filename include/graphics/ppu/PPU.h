@@ -3,6 +3,8 @@
 #include "../../common/Common.h"
 #include "OamEntry.h"
 
+#include <array>
+
 #define VISIBLE_HEIGHT 144
 #define VISIBLE_WIDHT 160
 
@@ -92,11 +94,8 @@ namespace GameboyEmu {
 
 			ppu_context m_ctx;
 
-			oam_object* m_objects;
-			byte m_current_object_fetch[4];
-			byte m_fetch_count;
+			std::array<oam_object, 10> m_objects;
 			byte m_encountered_objs;
-			byte m_oam_index;
 
 			byte m_wy_trigger;
 			byte m_window_line;
@@ -105,7 +104,7 @@ namespace GameboyEmu {
 
 			PixelPipeline* m_pipeline;
 
-			byte* m_frame;
+			std::array<byte, 160 * 144> m_frame;
 			unsigned m_pixel_index;
 
 		private:
@@ -115,8 +114,17 @@ namespace GameboyEmu {
 
 			void checkWyTrigger();
 
+			//Cycles of HBLANK or VBLANK that can be
+			//run at once, up to the end of the line
+			word idle_cycles(word tstates) const;
+
 			void mode_hblank();
 			void mode_vblank();
+
+			//Objects of the line, from the index
+			//of the memory, at the end of mode 2
+			void select_objects();
+
 			void mode_oam();
 			void mode_transfer();
 
@@ -195,6 +203,10 @@ namespace GameboyEmu {
 			//for mcycles
 			void Tick(byte mcycles);
 
+			//Clock cycles before the next change of mode
+			//or line (a lower bound during pixel output)
+			unsigned CyclesToEvent();
+
 			byte GetWindowMap() const;
 			byte GetBGMap() const;
 
@@ -204,7 +216,7 @@ namespace GameboyEmu {
 			byte bgColorTranslation(byte id, byte palette) const;
 
 			std::size_t DumpState(byte* buffer, std::size_t offset);
-			std::size_t LoadState(byte* buffer, std::size_t offset);
+			std::size_t LoadState(const byte* buffer, std::size_t offset);
 		};
 	}
 }
\ No newline at end of file
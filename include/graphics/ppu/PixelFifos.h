@@ -106,7 +106,7 @@ namespace GameboyEmu::Graphics {
 		void SetSpritePtr(oam_object* ptr);
 
 		std::size_t DumpState(byte* buffer, std::size_t offset);
-		std::size_t LoadState(byte* buffer, std::size_t offset);
+		std::size_t LoadState(const byte* buffer, std::size_t offset);
 
 	private:
 		void sprite_fetch();
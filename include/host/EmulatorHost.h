@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "../logging/Logger.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+
+namespace GameboyEmu::State {
+	class EmulatorState;
+}
+
+namespace GameboyEmu::Host {
+	/*
+	* Runs many independent headless emulators on a
+	* fixed pool of worker threads, instead of
+	* one thread per instance.
+	* 
+	* The instances are time sliced in quanta of one
+	* frame: a worker runs a frame of an instance,
+	* then puts it back at the end of its own queue.
+	* A worker with an empty queue steals from the
+	* others, so the load stays balanced even when
+	* some games are much slower than others.
+	* 
+	* Instances must be added, removed or accessed
+	* only when RunFrames is not running, or from the
+	* frame callback for the instance being run
+	*/
+	class EmulatorHost {
+	public :
+		using instance_id = std::size_t;
+		using frame_callback = std::function<void(instance_id, State::EmulatorState*)>;
+
+		//Returned by AddInstance when the game cannot be loaded
+		static constexpr instance_id invalid_instance = std::numeric_limits<instance_id>::max();
+
+		//0 threads uses all the cores
+		EmulatorHost(Logger& log, unsigned threads = 0);
+
+		//The id, or invalid_instance and the error
+		std::pair<instance_id, std::string> AddInstance(std::string const& rom);
+		void RemoveInstance(instance_id id);
+
+		State::EmulatorState* GetInstance(instance_id id);
+
+		std::size_t InstanceCount() const;
+		unsigned ThreadCount() const;
+
+		/*
+		* Runs every instance for the given number of
+		* frames and returns when all of them are done.
+		* The callback is called on the worker thread
+		* after every frame of an instance
+		*/
+		void RunFrames(unsigned frames, frame_callback callback = nullptr);
+
+		~EmulatorHost();
+
+	private :
+		struct Task {
+			instance_id id;
+			unsigned frames_left;
+		};
+
+		struct Worker {
+			std::deque<Task> tasks;
+			std::mutex mutex;
+			std::thread thread;
+		};
+
+		void worker_loop(unsigned index);
+		void run_tasks(unsigned index);
+
+		bool pop_task(unsigned index, Task& task);
+		bool steal_task(unsigned index, Task& task);
+		void push_task(unsigned index, Task const& task);
+
+		//Wakes the workers waiting in wait_task
+		void signal_task();
+
+		//Sleeps until a task is queued or finished
+		//after the events counter was seen
+		void wait_task(uint64_t seen);
+
+		Logger& m_logger;
+
+		std::vector<State::EmulatorState*> m_instances;
+		std::size_t m_instance_count;
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+
+		std::mutex m_run_mutex;
+		std::condition_variable m_start_cv;
+		std::condition_variable m_done_cv;
+
+		uint64_t m_generation;
+		bool m_stop;
+
+		std::atomic<std::size_t> m_remaining;
+		unsigned m_active_workers;
+
+		//Workers without a task sleep until the others
+		//queue or finish one, instead of spinning
+		std::mutex m_task_mutex;
+		std::condition_variable m_task_cv;
+		std::atomic<uint64_t> m_task_events;
+		std::atomic<unsigned> m_waiting;
+
+		frame_callback m_callback;
+	};
+}
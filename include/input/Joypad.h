@@ -2,18 +2,69 @@
 
 #include "../common/Common.h"
 
-#include <mutex>
+#include <atomic>
 
 namespace GameboyEmu::Mem {
 	class Memory;
 }
 
 namespace GameboyEmu::Input {
+	/*
+	* The buttons are a single atomic byte, low when
+	* pressed like the lines of the register : the
+	* frontend thread presses and releases them without
+	* a lock and the cpu reads them wait free.
+	* The presses are kept as edges, the interrupt is
+	* requested by the emulation thread (see Update)
+	*/
 	class Joypad {
 	public :
+		//Bits of the buttons, the actions in the low
+		//nibble and the directions in the high one
+		enum Button : byte {
+			a = 0x01,
+			b = 0x02,
+			select = 0x04,
+			start = 0x08,
+			right = 0x10,
+			left = 0x20,
+			up = 0x40,
+			down = 0x80
+		};
+
 		Joypad();
 
-		
+		//Any thread
+		inline void Press(byte buttons) {
+			m_host.fetch_and((byte)~buttons, std::memory_order_relaxed);
+
+			if (m_latched.load(std::memory_order_relaxed)) {
+				return;
+			}
+
+			byte was = m_buttons.fetch_and((byte)~buttons, std::memory_order_relaxed);
+
+			//Released before, high to low
+			if (was & buttons) {
+				m_edges.fetch_or(was & buttons, std::memory_order_release);
+			}
+		}
+
+		inline void Release(byte buttons) {
+			m_host.fetch_or(buttons, std::memory_order_relaxed);
+
+			if (m_latched.load(std::memory_order_relaxed)) {
+				return;
+			}
+
+			m_buttons.fetch_or(buttons, std::memory_order_relaxed);
+		}
+
+		//Pressed buttons, bit set when pressed
+		inline byte Pressed() const {
+			return (byte)~m_buttons.load(std::memory_order_relaxed);
+		}
+
 		/// ////
 		
 		void SetStart();
@@ -47,22 +98,47 @@ namespace GameboyEmu::Input {
 		void Write(byte val);
 		byte Read();
 
+		/*
+		* While latched, the presses of the frontend are
+		* only kept aside (HostPressed) and the cpu sees
+		* the buttons given to Latch, at frame boundaries.
+		* Used by the movies
+		*/
+		void SetLatched(bool latched);
+
+		//Buttons held on the frontend, bit set when pressed
+		inline byte HostPressed() const {
+			return (byte)~m_host.load(std::memory_order_relaxed);
+		}
+
+		//Emulation thread, sets the buttons seen by the cpu
+		void Latch(byte pressed);
+
+		//A button was pressed since the last Update
+		inline bool EdgesPending() const {
+			return m_edges.load(std::memory_order_relaxed) != 0;
+		}
+
+		//Emulation thread, requests the interrupt
+		//of the buttons pressed since the last call
+		void Update();
+
 		void RequestInterrupt();
 
 		void SetMemory(Mem::Memory* mem);
 
 	private :
-		std::mutex m_mutex;
+		std::atomic<byte> m_buttons;
+		std::atomic<byte> m_edges;
 
-		struct joypad_ctx {
-			byte m_select_actions;
-			byte m_select_direction;
+		//Buttons of the frontend
+		std::atomic<byte> m_host;
+		std::atomic<bool> m_latched;
 
-			byte m_status[2][4];
-		};
-		
-		joypad_ctx m_ctx;
+		//P15 and P14, only written by the cpu
+		byte m_select_actions;
+		byte m_select_direction;
 
 		Mem::Memory* m_mem;
 	};
-}
\ No newline at end of file
+}
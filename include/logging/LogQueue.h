@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class LogLevel : uint8_t {
+	info = 0,
+	warn = 1,
+	err = 2,
+	off = 3
+};
+
+/*
+* One formatted message, written in place by the
+* thread that logs, so no allocation is needed
+*/
+struct LogRecord {
+	static constexpr std::size_t max_text = 240;
+
+	LogLevel level;
+	bool truncated;
+	uint16_t size;
+
+	//Messages of the same site refused before this one
+	uint32_t dropped;
+
+	char text[max_text];
+};
+
+/*
+* Bounded queue of records, any number of producers and
+* a single consumer (D. Vyukov's bounded queue).
+* Each cell has a sequence number telling whether it is
+* free for the position of a producer or published for
+* the consumer, a producer never waits : when the queue
+* is full the record is simply not claimed
+*/
+class LogQueue {
+public :
+	static constexpr std::size_t capacity = 1024;
+
+	struct Slot {
+		LogRecord* record;
+		std::size_t position;
+	};
+
+	LogQueue();
+	~LogQueue();
+
+	LogQueue(LogQueue const&) = delete;
+	LogQueue& operator=(LogQueue const&) = delete;
+
+	//A free record for the producer, nullptr when full
+	inline Slot Claim() {
+		std::size_t pos = m_enqueue.load(std::memory_order_relaxed);
+
+		while (true) {
+			Cell& cell = m_cells[pos & mask];
+
+			std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+			if (diff == 0) {
+				if (m_enqueue.compare_exchange_weak(pos, pos + 1,
+					std::memory_order_relaxed)) {
+					return Slot{ &cell.record, pos };
+				}
+			}
+			else if (diff < 0) {
+				return Slot{ nullptr, pos };
+			}
+			else {
+				pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//Hands a claimed record to the consumer
+	inline void Publish(Slot const& slot) {
+		m_cells[slot.position & mask].sequence.store(
+			slot.position + 1, std::memory_order_release
+		);
+	}
+
+	//Next published record, or nullptr. Consumer only
+	inline const LogRecord* Front() const {
+		Cell const& cell = m_cells[m_dequeue & mask];
+
+		if (cell.sequence.load(std::memory_order_acquire) != m_dequeue + 1) {
+			return nullptr;
+		}
+
+		return &cell.record;
+	}
+
+	//Frees the record returned by Front. Consumer only
+	inline void Pop() {
+		m_cells[m_dequeue & mask].sequence.store(
+			m_dequeue + capacity, std::memory_order_release
+		);
+
+		m_dequeue++;
+	}
+
+	//Records claimed so far
+	inline std::size_t Claimed() const {
+		return m_enqueue.load(std::memory_order_acquire);
+	}
+
+private :
+	static constexpr std::size_t mask = capacity - 1;
+
+	static_assert((capacity & mask) == 0, "The capacity must be a power of 2");
+
+	struct Cell {
+		std::atomic<std::size_t> sequence;
+		LogRecord record;
+	};
+
+	Cell* m_cells;
+
+	alignas(64) std::atomic<std::size_t> m_enqueue;
+	alignas(64) std::size_t m_dequeue;
+};
@@ -1,65 +1,196 @@
 #pragma once
 
+#include "LogQueue.h"
+
 #include <fmt/format.h>
-#include <string_view>
 #include <iostream>
+#include <string_view>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <utility>
+#include <mutex>
+#include <algorithm>
+
+/*
+* Lowest level compiled in : 0 info, 1 warnings,
+* 2 errors, 3 nothing. The macros of the levels
+* below it expand to nothing
+*/
+#ifndef LEARNBOY_LOG_LEVEL
+#define LEARNBOY_LOG_LEVEL 0
+#endif
 
 /*
-The macros log the file and the line
+The macros log the file and the line, each
+site is rate limited (see LogRateLimiter)
 */
 
+#define LOG_AT(logger, level, fmt, ...) \
+    do { \
+        static LogRateLimiter lb_log_site; \
+        if (lb_log_site.Allow()) { \
+            (logger).log(level, lb_log_site.TakeDropped(), \
+                fmt, __FILE__, __LINE__, ## __VA_ARGS__); \
+        } \
+    } while (0)
+
+#if LEARNBOY_LOG_LEVEL <= 0
 #define LOG_INFO(logger, fmt, ...) \
-    logger.log_info("I {0}:{1} " fmt, __FILE__, __LINE__, ## __VA_ARGS__)
+    LOG_AT(logger, LogLevel::info, "I {0}:{1} " fmt, ## __VA_ARGS__)
+#else
+#define LOG_INFO(logger, fmt, ...) ((void)0)
+#endif
 
+#if LEARNBOY_LOG_LEVEL <= 1
 #define LOG_WARN(logger, fmt, ...) \
-    logger.log_warn("W {0}:{1} " fmt, __FILE__, __LINE__, ## __VA_ARGS__)
+    LOG_AT(logger, LogLevel::warn, "W {0}:{1} " fmt, ## __VA_ARGS__)
+#else
+#define LOG_WARN(logger, fmt, ...) ((void)0)
+#endif
 
+#if LEARNBOY_LOG_LEVEL <= 2
 #define LOG_ERR(logger, fmt, ...) \
-    logger.log_err("E {0}:{1} " fmt, __FILE__, __LINE__, ## __VA_ARGS__)
+    LOG_AT(logger, LogLevel::err, "E {0}:{1} " fmt, ## __VA_ARGS__)
+#else
+#define LOG_ERR(logger, fmt, ...) ((void)0)
+#endif
+
+/*
+* Lets a site log max_burst messages, then
+* at most max_burst per window, the others are
+* counted and reported with the next one.
+* Lock free, a site may be shared by threads
+*/
+class LogRateLimiter {
+public :
+	static constexpr uint32_t max_burst = 16;
+	static constexpr int64_t window_ns = 1000000000;
 
+	constexpr LogRateLimiter() :
+		m_window(0), m_count(0), m_dropped(0) {}
+
+	bool Allow();
+
+	//Messages refused since the last call
+	inline uint32_t TakeDropped() {
+		return m_dropped.exchange(0, std::memory_order_relaxed);
+	}
+
+private :
+	std::atomic<int64_t> m_window;
+	std::atomic<uint32_t> m_count;
+	std::atomic<uint32_t> m_dropped;
+};
+
+/*
+* The messages are formatted by the caller into a
+* record of a lock free queue, a background thread
+* writes them to the console or to a file.
+* Logging never waits : when the queue is full the
+* message is lost and counted
+*/
 class Logger {
 public :
-	//to implement
-	//simply prints directly to console, no buffering
-	/*
-	* Maybe add :
-	* - Colored output
-	* - Redirect to file
-	* - Add timestamp
-	* - Add more options to the logging
-	* ...
-	*/
+	static constexpr LogLevel compiled_level = (LogLevel)LEARNBOY_LOG_LEVEL;
+
+	Logger();
+
+	//Writes the messages still queued
+	~Logger();
+
+	Logger(Logger const&) = delete;
+	Logger& operator=(Logger const&) = delete;
+
+	//Writes to a file instead of the console
+	std::pair<bool, std::string> set_file(std::string const& path);
+
+	template <typename... Args>
+	void log(LogLevel level, uint32_t dropped,
+		std::string_view fmt, Args&&... args) {
+		if (level < compiled_level) {
+			return;
+		}
+
+		LogQueue::Slot slot = m_queue.Claim();
+
+		if (slot.record == nullptr) {
+			m_lost.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		LogRecord* record = slot.record;
+
+		record->level = level;
+		record->dropped = dropped;
+
+		try {
+			auto res = fmt::vformat_to_n(
+				record->text, LogRecord::max_text, fmt,
+				fmt::make_format_args(args...)
+			);
+
+			record->truncated = res.size > LogRecord::max_text;
+			record->size = (uint16_t)std::min(res.size, LogRecord::max_text);
+		}
+		catch (fmt::format_error const&) {
+			auto res = fmt::format_to_n(record->text,
+				LogRecord::max_text, "Invalid log format : {}\n", fmt);
+
+			record->truncated = false;
+			record->size = (uint16_t)std::min(res.size, LogRecord::max_text);
+		}
+
+		m_queue.Publish(slot);
+	}
+
 	template <typename... Args>
 	void log_info(std::string_view fmt,
 		Args&&... args) {
-		std::cout << fmt::vformat(
-			fmt, fmt::make_format_args(
-				std::forward<Args>(args)...
-			)
-		);
+		log(LogLevel::info, 0, fmt, std::forward<Args>(args)...);
 	}
 
 	template <typename... Args>
 	void log_warn(std::string_view fmt,
 		Args&&... args) {
-		std::cout << fmt::vformat(
-			fmt, fmt::make_format_args(
-				std::forward<Args>(args)...
-			)
-		);
+		log(LogLevel::warn, 0, fmt, std::forward<Args>(args)...);
 	}
 
 	template <typename... Args>
 	void log_err(std::string_view fmt,
 		Args&&... args) {
-		std::cout << fmt::vformat(
-			fmt, fmt::make_format_args(
-				std::forward<Args>(args)...
-			)
-		);
+		log(LogLevel::err, 0, fmt, std::forward<Args>(args)...);
 	}
 
-	void flush() {
-		std::cout.flush();
-	}
-};
\ No newline at end of file
+	//Waits until the messages logged
+	//before the call are written
+	void flush();
+
+	//Messages lost because the queue was full
+	uint64_t lost() const;
+
+private :
+	void run();
+
+	void write(LogRecord const& record);
+
+	//Writes every published record
+	void drain();
+
+private :
+	LogQueue m_queue;
+
+	std::atomic<uint64_t> m_lost;
+	uint64_t m_reported_lost;
+
+	//Records written by the thread
+	std::atomic<std::size_t> m_written;
+
+	//Only the thread and set_file use the output
+	std::mutex m_output_mutex;
+	std::ofstream m_file;
+
+	std::atomic<bool> m_running;
+	std::thread m_thread;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <atomic>
+#include <bit>
+
+namespace GameboyEmu {
+	namespace Mem {
+		//Bits of IF and IE, in priority order
+		enum class Interrupt : byte {
+			vblank = 0,
+			lcdstat = 1,
+			timer = 2,
+			serial = 3,
+			joypad = 4
+		};
+
+		/*
+		* IF (0xFF0F) and IE (0xFFFF) registers.
+		*
+		* Interrupts are raised with an atomic or, from
+		* the emulation thread or from the serial thread,
+		* without going through the memory map.
+		* IE is only written by the emulation thread
+		*/
+		class InterruptController {
+		public:
+			InterruptController();
+
+			inline void Raise(Interrupt source) {
+				m_flag.fetch_or((byte)(1 << (byte)source),
+					std::memory_order_acq_rel);
+			}
+
+			inline void Acknowledge(Interrupt source) {
+				m_flag.fetch_and((byte)~(1 << (byte)source),
+					std::memory_order_acq_rel);
+			}
+
+			//Requested and enabled interrupts
+			inline byte Pending() const {
+				return m_flag.load(std::memory_order_acquire) & m_enable & 0x1F;
+			}
+
+			//Highest priority interrupt of a non zero Pending()
+			static inline Interrupt First(byte pending) {
+				return (Interrupt)std::countr_zero(pending);
+			}
+
+			static inline word Handler(Interrupt source) {
+				return 0x40 + (byte)source * 8;
+			}
+
+			byte GetIF() const;
+			void SetIF(byte value);
+
+			byte GetIE() const;
+			void SetIE(byte value);
+
+		private:
+			/*
+			*	Bit 0: VBlank   Interrupt Enable  (INT $40)  (1=Enable)
+				Bit 1: LCD STAT Interrupt Enable  (INT $48)  (1=Enable)
+				Bit 2: Timer    Interrupt Enable  (INT $50)  (1=Enable)
+				Bit 3: Serial   Interrupt Enable  (INT $58)  (1=Enable)
+				Bit 4: Joypad   Interrupt Enable  (INT $60)  (1=Enable)
+			*/
+			byte m_enable;
+
+			std::atomic<byte> m_flag;
+		};
+	}
+}
@@ -4,8 +4,14 @@
 #include "../cartridge/MemoryCard.h"
 
 #include "../cheats/GameShark.h"
+#include "../debugger/Watchpoint.h"
+#include "InterruptController.h"
+#include "OamIndex.h"
 
+#include <array>
 #include <atomic>
+#include <cstdint>
+#include <map>
 
 /*
 * 0x0000 - 0x3FFF First ROM bank
@@ -48,15 +54,31 @@ namespace GameboyEmu {
 	}
 
 	namespace Mem {
+		class RomImage;
 
 		struct dma_status {
 			bool running;
 			word source_base;
+
+			//Bytes already visible in OAM
 			byte current_index;
 
 			byte current_oam_index;
 
+			//M-cycles since the write to 0xFF46
+			//(only up to date in the savestates)
 			byte cycle_count;
+
+			//Clock cycle of the first byte, and of the end
+			//(the maximum when no transfer runs). The start
+			//is negative when a state taken mid-transfer is
+			//loaded near the start of the clock
+			int64_t start;
+			uint64_t end;
+
+			//The source is copied at once : the cpu cannot
+			//write to its bus during the transfer
+			std::array<byte, 0xA0> data;
 		};
 
 		/*
@@ -72,6 +94,10 @@ namespace GameboyEmu {
 			//Read byte from memory
 			byte Read(word address) const;
 
+			//Read byte without triggering the watchpoints,
+			//for the debugger and the tracer
+			byte Peek(word address) const;
+
 			//Write byte to memory
 			void Write(word address, byte value);
 
@@ -81,22 +107,48 @@ namespace GameboyEmu {
 			byte GetIE() const;
 			byte GetIR() const;
 
+			inline InterruptController& GetInterrupts() {
+				return m_interrupts;
+			}
+
 			byte ppu_read_vram(word address) const;
 			byte ppu_read_oam(word address) const;
 
+			//Objects on each line, for the OAM scan,
+			//with the bytes the DMA has copied so far
+			OamIndex const& GetOamIndex();
+
 			~Memory();
 
-			void DmaAdvance(byte cycles);
+			//Clock cycle at which DmaFinish must be called
+			inline uint64_t DmaEnd() const {
+				return m_dma.end;
+			}
+
+			//Ends the transfer once the clock reaches DmaEnd
+			void DmaFinish();
 
 			dma_status const& GetDma() const;
 
 			std::size_t DumpState(byte* buffer, std::size_t offset);
-			std::size_t LoadState(byte* buffer, std::size_t offset);
+			std::size_t LoadState(const byte* buffer, std::size_t offset);
 
 			byte ApplyShark(Cheats::GameShark const& shark);
 
 			void ReadBootrom(std::string const& path);
 
+			//Rebuilds the watched pages, called every
+			//time the watchpoints change
+			void UpdateWatchpoints(std::map<word, Debugger::Watchpoint> const& watchpoints,
+				bool enabled);
+
+			Debugger::WatchHit const& LastWatchHit() const;
+
+			//At least one watchpoint is enabled
+			inline bool Watching() const {
+				return m_watching;
+			}
+
 		private:
 			State::EmulatorState* m_state;
 			Cartridge::MemoryCard* m_cartridge;
@@ -107,28 +159,65 @@ namespace GameboyEmu {
 			DataTransfer::Serial* m_serial;
 			bool m_bootROMEnabled;
 
-			byte* m_wram;
-			byte* m_hram;
-			byte* m_vram;
-			byte* m_oam;
+			//Held by value, next to the rest of the machine
+			alignas(64) std::array<byte, StaticData::wram_size> m_wram;
+			alignas(64) std::array<byte, StaticData::hram_size> m_hram;
+			alignas(64) std::array<byte, StaticData::vram_size> m_vram;
+			alignas(64) std::array<byte, StaticData::oam_size> m_oam;
 
-			/*
-			*
-			*	Bit 0: VBlank   Interrupt Enable  (INT $40)  (1=Enable)
-				Bit 1: LCD STAT Interrupt Enable  (INT $48)  (1=Enable)
-				Bit 2: Timer    Interrupt Enable  (INT $50)  (1=Enable)
-				Bit 3: Serial   Interrupt Enable  (INT $58)  (1=Enable)
-				Bit 4: Joypad   Interrupt Enable  (INT $60)  (1=Enable)
-			*/
-			byte m_interrupt_enable;
+			OamIndex m_oam_index;
 
-			std::atomic_uchar m_interrupt_flag;
+			//IE and IF
+			InterruptController m_interrupts;
 
 			dma_status m_dma;
 
-			byte* m_bootrom;
+			RomImage* m_bootrom_image;
+			const byte* m_bootrom;
 
 			void reset_dma();
+
+			//Starts the transfer from source_base
+			void start_dma();
+
+			//Copies to OAM the bytes transferred before time
+			void dma_commit(uint64_t time);
+
+			//Marks the pages the cpu cannot access
+			//during the transfer
+			void dma_flag_pages(bool set);
+
+			//Access of the cpu to a page of the transfer
+			byte dma_read(word address) const;
+
+			byte read_bus(word address) const;
+
+			//Slow path of the watched pages
+			void watch_access(word address, byte value, bool write) const;
+
+		private:
+			static constexpr byte watch_read = 0x1;
+			static constexpr byte watch_write = 0x2;
+
+			//Bus used by the OAM DMA
+			static constexpr byte dma_bus = 0x4;
+
+			/*
+			* Slow path flags of each 256 bytes page, the only
+			* test made on accesses to the other pages.
+			* Accesses to watched pages test the address
+			* in the bitmaps before looking up the watchpoint
+			*/
+			std::array<byte, 0x100> m_page_flags;
+			std::array<uint64_t, 0x10000 / 64> m_watch_read_bits;
+			std::array<uint64_t, 0x10000 / 64> m_watch_write_bits;
+
+			mutable Debugger::WatchHit m_watch_hit;
+
+			//A callback reading the address does not recurse
+			mutable bool m_in_watch;
+
+			bool m_watching;
 		};
 	}
 }
\ No newline at end of file
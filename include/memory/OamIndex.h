@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <array>
+#include <cstdint>
+
+namespace GameboyEmu {
+	namespace Mem {
+		/*
+		* Objects of the OAM on each visible line, kept
+		* up to date by the writes to the Y positions.
+		*
+		* A line has one bit per object (40 of them),
+		* for 8x8 and 8x16 objects, so the OAM scan of
+		* the PPU takes the first 10 set bits instead
+		* of comparing the 40 positions every line
+		*/
+		class OamIndex {
+		public:
+			static constexpr byte max_objects = 10;
+
+			OamIndex();
+
+			//A byte of OAM was written
+			inline void Write(byte offset, byte value) {
+				if ((offset & 3) == 0) {
+					set_y(offset >> 2, value);
+				}
+			}
+
+			//After a change of all the OAM
+			void Rebuild(const byte* oam);
+
+			/*
+			* Indices of the objects on the line, in OAM order,
+			* at most max_objects. Returns their count
+			*/
+			byte Lookup(byte line, bool tall,
+				std::array<byte, max_objects>& found) const;
+
+		private:
+			static constexpr unsigned objects = 40;
+			static constexpr unsigned lines = 144;
+
+			void set_y(byte object, byte y);
+
+			//Sets or clears the bit of the object
+			//on the lines covered from y
+			void mark(byte object, byte y, bool set);
+
+		private:
+			std::array<byte, objects> m_y;
+
+			//8x8 then 8x16 objects
+			std::array<std::array<uint64_t, lines>, 2> m_lines;
+		};
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <filesystem>
+#include <memory>
+
+namespace GameboyEmu::Mem {
+	/*
+	* Read only image of a rom file (cartridge or bootrom).
+	* 
+	* The file is memory mapped instead of being copied,
+	* and the mapping is shared by every image of the same
+	* file opened in the process. Other processes mapping
+	* the same file share the pages through the page cache.
+	* 
+	* The only writer are the Game Genie patches, Writable()
+	* moves the image to a private copy on write mapping,
+	* so only the patched pages are duplicated and the
+	* other instances keep seeing the original rom
+	*/
+	class RomImage {
+	public :
+		static std::pair<RomImage*, std::string> Open(std::filesystem::path const& path);
+
+		const byte* Data() const;
+		std::size_t Size() const;
+
+		byte* Writable();
+
+		bool IsShared() const;
+
+		~RomImage();
+
+		struct Mapping;
+
+	private :
+		RomImage(std::filesystem::path const& path, std::shared_ptr<Mapping> mapping);
+
+		std::filesystem::path m_path;
+
+		std::shared_ptr<Mapping> m_mapping;
+
+		//Private copy, after the first Writable()
+		std::unique_ptr<Mapping> m_private;
+	};
+}
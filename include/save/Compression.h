@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <vector>
+
+/*
+* Small in-tree LZ77 compressor, using the
+* LZ4 block layout:
+* 
+* [token][literal len ext][literals][offset lo, hi][match len ext]
+* 
+* The high nibble of the token is the number of
+* literals, the low nibble the match length - 4,
+* a nibble of 15 is followed by extension bytes
+* (255 means "add and keep reading").
+* The last sequence contains only literals.
+* 
+* It is not the fastest or the best possible
+* compressor, but savestates are mostly made
+* of zeros and repeated patterns, which
+* are handled very well
+*/
+
+namespace GameboyEmu::Saves::Compression {
+	//Worst case size of the compressed data
+	std::size_t CompressBound(std::size_t len);
+
+	//Appends the compressed data to out,
+	//returns the compressed size
+	std::size_t Compress(const byte* in, std::size_t len, std::vector<byte>& out);
+
+	/*
+	* Decompresses exactly out_len bytes,
+	* returns false if the input is malformed
+	* or does not produce out_len bytes
+	*/
+	bool Decompress(const byte* in, std::size_t len, byte* out, std::size_t out_len);
+}
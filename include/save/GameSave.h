@@ -2,6 +2,8 @@
 
 #include "../common/Common.h"
 
+#include <fstream>
+
 namespace GameboyEmu::Cartridge {
 	class MemoryCard;
 }
@@ -14,6 +16,9 @@ namespace GameboyEmu::Saves {
 		uint8_t size_kb;
 	};
 
+	//Header and content of an already copied ram
+	std::pair<bool, std::string> WriteGame(std::ofstream& file, const byte* ram, std::size_t size_kb, std::string_view title);
+
 	std::pair<bool, std::string> SaveGame(Cartridge::MemoryCard* card, std::string const& path);
 
 	std::pair<bool, std::string> LoadGame(Cartridge::MemoryCard* card, std::string const& path);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace GameboyEmu::Saves {
+	/*
+	* Cartridge RAM backed by a memory mapped .sav file,
+	* using the same layout written by SaveGame
+	* (save_header followed by the RAM banks).
+	* 
+	* The cartridge reads and writes the mapping directly,
+	* every write marks its block as dirty and a background
+	* thread periodically flushes the dirty blocks to disk.
+	* Even if the emulator crashes the data is already
+	* in the file, the flush protects from OS crashes
+	*/
+	class MappedSram {
+	public :
+		//Granularity of the dirty tracking
+		static constexpr std::size_t block_size = 4096;
+
+		static constexpr unsigned sync_interval_ms = 1000;
+
+		MappedSram();
+
+		/*
+		* Opens or creates the file. A new file is
+		* filled with initial, an existing one must
+		* have the same title and size
+		*/
+		std::pair<bool, std::string> Open(std::string const& path,
+			std::string_view title, std::size_t size, const byte* initial);
+
+		byte* Data();
+		std::size_t Size() const;
+
+		inline void MarkDirty(std::size_t offset) {
+			uint64_t bit = uint64_t(1) << ((m_data_offset + offset) / block_size);
+
+			//Avoids a locked operation when the
+			//block is already dirty
+			if ((m_dirty.load(std::memory_order_relaxed) & bit) == 0) {
+				m_dirty.fetch_or(bit, std::memory_order_relaxed);
+			}
+		}
+
+		void MarkAllDirty();
+
+		//Flushes the dirty blocks
+		void Sync();
+
+		void Close();
+
+		~MappedSram();
+
+	private :
+		byte* m_base;
+		std::size_t m_file_size;
+		std::size_t m_data_offset;
+
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_fd;
+#endif
+
+		std::atomic<uint64_t> m_dirty;
+
+		std::thread m_sync_thread;
+		std::mutex m_sync_mutex;
+		std::condition_variable m_sync_cv;
+		bool m_stop;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "Snapshot.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+
+namespace GameboyEmu::State {
+	class EmulatorState;
+}
+
+namespace GameboyEmu::Saves {
+	/*
+	* Recorded session : the game, the state it starts
+	* from and the buttons held during each frame.
+	*
+	* The buttons of a frame are given to the joypad
+	* when the previous frame ends (EmulatorState::frame_tasks),
+	* never in the middle of one, and the clock of the
+	* cartridge runs on the emulated time, so playing
+	* a movie always gives the same states.
+	*
+	* Without a start state the movie starts at
+	* power on, without the boot ROM
+	*/
+	class Movie {
+	public :
+		Movie();
+
+		//Empty movie for the game, recording from
+		//power on or from a state, with the clock
+		//of the cartridge starting at clock_start
+		void Begin(word checksum, int64_t clock_start);
+		void Begin(word checksum, int64_t clock_start, Snapshot const& start);
+
+		void Append(byte pressed);
+
+		//Next frame of the playback, false at the end
+		bool Next(byte& pressed);
+
+		word GetChecksum() const;
+		int64_t GetClockStart() const;
+
+		bool HasStartState() const;
+		Snapshot const& GetStartState() const;
+
+		std::size_t FrameCount() const;
+
+		//Frames given by Next so far
+		std::size_t Position() const;
+
+		std::pair<bool, std::string> Save(std::string const& path, std::string_view title) const;
+
+		//The movie must be of the game of the state,
+		//which also gives the layout of the start state
+		std::pair<bool, std::string> Load(std::string const& path, State::EmulatorState* state);
+
+	private :
+		word m_checksum;
+		int64_t m_clock_start;
+
+		bool m_has_state;
+		Snapshot m_start;
+
+		//Pressed buttons, one byte per frame (see Input::Joypad)
+		std::vector<byte> m_frames;
+		std::size_t m_position;
+	};
+}
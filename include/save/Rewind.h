@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "Snapshot.h"
+
+#include <deque>
+#include <vector>
+#include <atomic>
+
+namespace GameboyEmu::State {
+	class EmulatorState;
+}
+
+namespace GameboyEmu::Saves {
+	/*
+	* Keeps the recent history of the emulation.
+	* 
+	* A snapshot is captured every N frames, but only
+	* the newest one is stored in full. Every older
+	* state is stored as the XOR between it and the
+	* next state, run-length encoded. Most of the
+	* state (framebuffer, VRAM, WRAM, SRAM...) changes
+	* very little from one frame to the other, so
+	* the deltas are mostly runs of zeros.
+	* 
+	* When the memory used exceeds the budget,
+	* the oldest deltas are dropped.
+	* 
+	* Push/StepBack must be called from the
+	* emulation thread (or while it is paused),
+	* the setters can be called from any thread
+	*/
+	class RewindBuffer {
+	public :
+		RewindBuffer(std::size_t budget, unsigned interval);
+
+		//Called once per frame, captures the
+		//state every m_interval frames
+		void OnFrame(State::EmulatorState* state);
+
+		//Captures the state immediately
+		void Push(State::EmulatorState* state);
+
+		/*
+		* Goes back of count snapshots and loads
+		* the resulting state. Returns the number
+		* of snapshots actually rewound, nothing is
+		* loaded when it is 0. The buffer is cleared
+		* if the state cannot be restored
+		*/
+		unsigned StepBack(State::EmulatorState* state, unsigned count);
+
+		void Clear();
+
+		void SetBudget(std::size_t budget);
+		void SetInterval(unsigned interval);
+
+		std::size_t GetBudget() const;
+		unsigned GetInterval() const;
+
+		std::size_t GetUsedMemory() const;
+		std::size_t GetCount() const;
+
+		static constexpr std::size_t default_budget = 32 * 1024 * 1024;
+		static constexpr unsigned default_interval = 4;
+
+	private :
+		void evict();
+
+	private :
+		std::atomic<std::size_t> m_budget;
+		std::atomic<unsigned> m_interval;
+
+		unsigned m_frames;
+
+		//Newest state, in full
+		Snapshot m_head;
+		Snapshot m_scratch;
+
+		//deltas.back() turns m_head
+		//into the previous state
+		std::deque<std::vector<byte>> m_deltas;
+
+		std::atomic<std::size_t> m_used;
+		std::atomic<std::size_t> m_count;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "../logging/Logger.h"
+
+#include <fstream>
+#include <functional>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace GameboyEmu::Saves {
+	using write_function = std::function<std::pair<bool, std::string>(std::ofstream&)>;
+
+	/*
+	* Writes to path.tmp, flushes it to the disk and
+	* renames it to path only if everything succeeded,
+	* so a crash or a power loss never leaves a torn file
+	*/
+	std::pair<bool, std::string> WriteAtomic(std::string const& path, write_function const& write);
+
+	/*
+	* Background thread that writes saves to disk.
+	* The emulation thread only captures the data
+	* in memory, compression and I/O happen here
+	* so saving does not cause a frame hitch.
+	* 
+	* Jobs are written in the order they are queued,
+	* the destructor writes all the pending ones
+	*/
+	class SaveWriter {
+	public :
+		SaveWriter(Logger& log);
+
+		void Queue(std::string const& path, write_function write);
+
+		//Blocks until every queued job is written
+		void Flush();
+
+		std::size_t Pending();
+
+		//Result of the last completed job
+		std::pair<bool, std::string> LastResult();
+
+		~SaveWriter();
+
+	private :
+		struct Job {
+			std::string path;
+			write_function write;
+		};
+
+		void worker();
+
+		Logger& m_logger;
+
+		std::deque<Job> m_jobs;
+
+		std::mutex m_mutex;
+		std::condition_variable m_job_cv;
+		std::condition_variable m_idle_cv;
+
+		bool m_busy;
+		bool m_stop;
+
+		std::pair<bool, std::string> m_last_result;
+
+		std::thread m_thread;
+	};
+}
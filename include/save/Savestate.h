@@ -2,11 +2,21 @@
 
 #include "../common/Common.h"
 
+#include <fstream>
+
 namespace GameboyEmu::State {
 	class EmulatorState;
 }
 
 namespace GameboyEmu::Saves {
+	class Snapshot;
+
+	//Header and chunks of an already captured state
+	std::pair<bool, std::string> WriteState(std::ofstream& file, Snapshot const& snap, std::string_view title);
+
+	//Reads a state written by WriteState into snap, without restoring it
+	std::pair<bool, std::string> ReadState(std::ifstream& file, State::EmulatorState* state, Snapshot& snap);
+
 	std::pair<bool, std::string> SaveState(std::string const& to, State::EmulatorState* state);
 	std::pair<bool, std::string> LoadState(std::string const& from, State::EmulatorState* state);
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../common/Common.h"
+
+#include <vector>
+#include <array>
+
+namespace GameboyEmu::Saves {
+	//Components stored in a snapshot,
+	//in the order they are dumped
+	enum class Section : unsigned {
+		cpu,
+		memory,
+		ppu,
+		timer,
+		serial,
+		apu,
+		cartridge,
+		count
+	};
+
+	static constexpr std::size_t section_count = (std::size_t)Section::count;
+
+	/*
+	* In-memory image of the whole emulator state,
+	* filled by EmulatorState::Capture and consumed
+	* by EmulatorState::Restore.
+	* 
+	* The buffer is kept between captures, so
+	* the same object can be reused without
+	* allocating again (rewind, run-ahead...)
+	*/
+	class Snapshot {
+	public :
+		Snapshot();
+		Snapshot(std::size_t capacity);
+
+		//Grows the buffer, never shrinks it
+		void Reserve(std::size_t capacity);
+
+		//Sets the number of valid bytes in the buffer
+		void Resize(std::size_t size);
+
+		void Clear();
+
+		byte* Data();
+		const byte* Data() const;
+
+		std::size_t Size() const;
+		std::size_t Capacity() const;
+
+		bool Empty() const;
+
+		//Marks where a component starts, a section
+		//ends where the next one starts
+		void SetSectionStart(Section section, std::size_t offset);
+
+		std::size_t SectionOffset(Section section) const;
+		std::size_t SectionSize(Section section) const;
+
+	private :
+		std::vector<byte> m_buffer;
+		std::size_t m_size;
+
+		std::array<std::size_t, section_count> m_sections;
+	};
+}
@@ -2,7 +2,9 @@
 
 #include "../../common/Common.h"
 #include "../output/OutputDevice.h"
-#include "Channel.h"
+#include "PulseChannel.h"
+#include "WaveChannel.h"
+#include "NoiseChannel.h"
 
 #include <array>
 
@@ -28,23 +30,43 @@ namespace GameboyEmu::Sound {
 		void Tick(byte cycles);
 
 		std::size_t DumpState(byte* buffer, std::size_t offset);
-		std::size_t LoadState(byte* buffer, std::size_t offset);
+		std::size_t LoadState(const byte* buffer, std::size_t offset);
+
+		//Mixes one sample of each channel and sends
+		//it to the output, public for the benchmarks
+		void mix_samples(std::array<short, 4> const& samples);
 
 		~APU();
 
 	private :
-		void mix_samples(std::array<short, 4> const& samples);
-
 		float high_pass(float in);
 
+		//Handlers of one register, the address
+		//is passed for the wave RAM
+		struct register_access {
+			byte (*read)(APU& apu, word address);
+			void (*write)(APU& apu, word address, byte value);
+		};
+
+		static constexpr word first_register = 0xFF10;
+		static constexpr word num_registers = 0xFF40 - first_register;
+
+		//Table indexed by address - first_register,
+		//built at compile time
+		static constexpr std::array<register_access, num_registers> make_registers();
+
+		static const std::array<register_access, num_registers> s_registers;
+
 	private :
 		State::EmulatorState* m_state;
 		OutputDevice* m_dev;
 
-		AudioChannel* m_ch1;
-		AudioChannel* m_ch2;
-		AudioChannel* m_ch3;
-		AudioChannel* m_ch4;
+		//Held by value with their final types, the
+		//register accesses are direct calls
+		PulseChannel m_ch1;
+		PulseChannel m_ch2;
+		WaveChannel m_ch3;
+		NoiseChannel m_ch4;
 
 		byte m_left_vol;
 		byte m_right_vol;
@@ -53,14 +75,15 @@ namespace GameboyEmu::Sound {
 
 		Panning m_panning[4];
 
-		byte* m_samples;
+		static constexpr unsigned num_samples = 4096;
+
+		std::array<byte, num_samples> m_samples;
 		word m_num_samples;
 
 		word m_curr_cycles;
 
 		float m_capacitor;
 
-		static constexpr unsigned num_samples = 4096;
 		static constexpr unsigned sample_rate = 44100;
 		static constexpr unsigned cpu_clock = 4194304;
 		static constexpr unsigned sample_clocks = cpu_clock / sample_rate;
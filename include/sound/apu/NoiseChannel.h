@@ -17,7 +17,7 @@ namespace GameboyEmu::Sound {
          112
 	};
 
-	class NoiseChannel : public AudioChannel {
+	class NoiseChannel final : public AudioChannel {
 	public :
 		NoiseChannel();
 
@@ -15,7 +15,7 @@ namespace GameboyEmu::Sound {
 		{0, 1, 1, 1, 1, 1, 1, 0}
 	};
 
-	class PulseChannel : public AudioChannel {
+	class PulseChannel final : public AudioChannel {
 	public :
 		PulseChannel(bool use_sweep);
 
@@ -57,7 +57,10 @@ namespace GameboyEmu::Sound {
 
 		Envelope m_envelope;
 		LenCounter m_counter;
-		Sweep* m_sweep;
+		Sweep m_sweep;
+
+		//Only the first channel has a sweep
+		bool m_use_sweep;
 
 		Sequencer<PulseChannel> m_seq;
 
@@ -7,7 +7,7 @@
 #include "Sequencer.h"
 
 namespace GameboyEmu::Sound {
-	class WaveChannel : public AudioChannel {
+	class WaveChannel final : public AudioChannel {
 	public :
 		WaveChannel();
 
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "OutputDevice.h"
+
+namespace GameboyEmu::Sound {
+	/*
+	* Output device that discards the samples,
+	* used by headless instances
+	*/
+	class NullOutputDevice : public OutputDevice {
+	public :
+		NullOutputDevice() = default;
+
+		std::string GetDeviceName() const override;
+
+		int GetFrequency() const override;
+		byte GetSilence() const override;
+		unsigned GetBufferSize() const override;
+
+		void SendSamples(byte* buffer) override;
+
+		void Init() override;
+
+		~NullOutputDevice() override = default;
+	};
+}
@@ -5,6 +5,8 @@
 #include <vector>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <optional>
 
 #include "../common/Common.h"
 #include "../logging/Logger.h"
@@ -29,7 +31,7 @@ namespace GameboyEmu {
 
 	namespace Graphics {
 		class PPU;
-		class Display;
+		class Screen;
 	}
 
 	namespace Timing {
@@ -49,6 +51,19 @@ namespace GameboyEmu {
 		class Serial;
 	}
 
+	namespace Saves {
+		class Snapshot;
+		class RewindBuffer;
+		class SaveWriter;
+		class Movie;
+	}
+
+	namespace Debugger {
+		class Profiler;
+		class GuestProfiler;
+		class Tracer;
+	}
+
 	namespace State {
 
 		/*
@@ -58,12 +73,19 @@ namespace GameboyEmu {
 		* It also offers a method used for synchronization between
 		* the CPU and the other components.
 		*/
+		class Frontend;
+		struct Machine;
+
 		class EmulatorState {
 		private:
 			std::string m_file;
 
 			Logger& m_logger;
 
+			//Owns the components, the pointers
+			//below are views into it
+			Machine* m_machine;
+
 			CPU::Cpu* m_cpu;
 			Mem::Memory* m_memory;
 			Cartridge::MemoryCard* m_card;
@@ -77,7 +99,14 @@ namespace GameboyEmu {
 
 			std::string m_fatal_message;
 
-			Graphics::Display* m_display;
+			Graphics::Screen* m_display;
+
+			//No window, audio or network,
+			//the frames are not paced
+			bool m_headless;
+
+			uint64_t m_frame_count;
+			const byte* m_framebuffer;
 
 			unsigned m_stop_check_cycles;
 
@@ -102,6 +131,57 @@ namespace GameboyEmu {
 			std::map<std::string, cheat_pair> m_genies;
 			std::map<std::string, Cheats::GameShark> m_sharks;
 
+			std::size_t m_state_size;
+
+			//Start of the cartridge in a captured state
+			std::size_t m_card_offset;
+
+			bool m_frame_ready;
+
+			Saves::RewindBuffer* m_rewind;
+			std::atomic<bool> m_rewind_enabled;
+			std::atomic<unsigned> m_rewind_pending;
+
+			enum class SaveKind {
+				state,
+				game
+			};
+
+			Saves::SaveWriter* m_writer;
+
+			//Saves requested while the emulation
+			//thread is running
+			std::vector<std::pair<SaveKind, std::string>> m_save_requests;
+			std::mutex m_save_mutex;
+			std::atomic<bool> m_save_pending;
+
+			Debugger::Profiler* m_profiler;
+
+			Debugger::GuestProfiler* m_guest_profiler;
+			std::atomic<bool> m_guest_sampling;
+			std::atomic<bool> m_guest_restart;
+
+			Debugger::Tracer* m_tracer;
+
+			//Clock cycles run since the start
+			uint64_t m_cycle_count;
+
+			std::atomic<bool> m_idle_skip;
+
+			Saves::Movie* m_movie;
+			bool m_movie_recording;
+			bool m_movie_finished;
+
+			//Buttons given to the joypad for the current
+			//frame, appended to the movie when it ends
+			byte m_movie_pressed;
+
+			//The clock of the cartridge follows the emulated
+			//time, from m_clock_start at m_clock_origin cycles
+			bool m_fixed_clock;
+			int64_t m_clock_start;
+			uint64_t m_clock_origin;
+
 		public:
 			/*
 			* Creates the Cartridge objects, reading from
@@ -110,8 +190,11 @@ namespace GameboyEmu {
 			* place
 			*
 			* @param filename The rom file
+			* @param frontend Creates window, audio and serial devices,
+			*                 without one the emulator runs headless,
+			*                 as fast as possible
 			*/
-			EmulatorState(std::string_view const& filename, Logger& log);
+			EmulatorState(std::string_view const& filename, Logger& log, Frontend* frontend = nullptr);
 
 			/*
 			* Synchronization of Timer, PPU and other
@@ -119,6 +202,41 @@ namespace GameboyEmu {
 			*/
 			void Sync(byte cycles);
 
+			/*
+			* Clock cycles before something the cpu can
+			* observe happens : a change of the PPU mode
+			* or line, or an interrupt of the timer, at
+			* most a line away.
+			* 0 while a DMA or a serial transfer runs
+			*/
+			uint64_t CyclesToEvent();
+
+			//Syncs for clock cycles (a multiple of 4)
+			void Skip(uint64_t cycles);
+
+			/*
+			* Executes one instruction and, if a frame
+			* was completed during it, runs the
+			* per-frame tasks (rewind...), which
+			* must not happen in the middle
+			* of an instruction
+			*/
+			unsigned Step();
+
+			/*
+			* Runs until the PPU completes a frame, or for
+			* the duration of a frame if the LCD is off.
+			* Returns the number of cycles executed
+			*/
+			unsigned RunFrame();
+
+			bool IsHeadless() const;
+
+			uint64_t GetFrameCount() const;
+
+			//Last frame completed by the PPU
+			const byte* GetFramebuffer() const;
+
 			CPU::Cpu* GetCPU();
 			Mem::Memory* GetMemory();
 			Cartridge::MemoryCard* GetCard();
@@ -156,10 +274,21 @@ namespace GameboyEmu {
 			bool WatchpointsEnabled() const;
 			void EnableWatchpoints(bool value);
 
+			//Marks the watched pages of the memory,
+			//call after changing the watchpoints
+			void UpdateWatchpoints();
+
 			inline bool StacktraceEnabled() const {
 				return m_enable_stacktrace;
 			}
 
+			//Calls are tracked for the debugger
+			//or for the guest profiler
+			inline bool StacktraceActive() const {
+				return (m_debugging && m_enable_stacktrace) ||
+					m_guest_sampling.load(std::memory_order_relaxed);
+			}
+
 			void EnableStacktrace(bool value);
 
 			void StacktraceClear();
@@ -171,6 +300,9 @@ namespace GameboyEmu {
 
 			bool ShouldBreak() const;
 
+			//Deeper calls drop the oldest entries
+			static constexpr std::size_t max_stacktrace_depth = 512;
+
 			void add_stacktrace_entry(word callee, 
 				word dest, word ret, byte page);
 			void remove_stacktrace_entry(word ret_address);
@@ -189,6 +321,113 @@ namespace GameboyEmu {
 
 			std::vector<std::string> GetShark() const;
 
+			/*
+			* Serializes the state of all the components
+			* into the snapshot buffer, no file I/O
+			* is involved. The buffer is grown only
+			* the first time
+			*/
+			void Capture(Saves::Snapshot& snap);
+
+			/*
+			* Loads back a state produced by Capture,
+			* the machine is left untouched if the
+			* cartridge does not match
+			*/
+			std::pair<bool, std::string> Restore(Saves::Snapshot const& snap);
+
+			//Exact size in bytes of a captured state
+			std::size_t StateSize();
+
+			void EnableRewind(bool value);
+			bool RewindEnabled() const;
+
+			Saves::RewindBuffer* GetRewind();
+
+			/*
+			* Goes back of count rewind snapshots.
+			* If the emulation is running, the request
+			* is served at the end of the next frame
+			*/
+			void Rewind(unsigned count);
+
+			/*
+			* Asynchronous savestate and battery save.
+			* The data is captured on the emulation thread
+			* between two instructions, then compression and
+			* writing are done by the SaveWriter thread.
+			* Errors are reported through the logger
+			*/
+			void SaveStateAsync(std::string const& path);
+			std::pair<bool, std::string> SaveGameAsync(std::string const& path);
+
+			//Null until the first save, most instances
+			//never save and must not hold a thread
+			Saves::SaveWriter* GetSaveWriter();
+
+			/*
+			* Time spent in the cpu, per opcode and in each
+			* component ticked by Sync, collected only
+			* in LEARNBOY_PROFILER builds
+			*/
+			Debugger::Profiler* GetProfiler();
+
+			/*
+			* Samples the game code every period cycles,
+			* see Debugger::GuestProfiler
+			*/
+			void ProfileGuest(bool enable);
+			bool GuestProfiling() const;
+
+			Debugger::GuestProfiler* GetGuestProfiler();
+
+			//Instruction trace, see Debugger::Tracer
+			Debugger::Tracer* GetTracer();
+
+			inline uint64_t GetCycleCount() const {
+				return m_cycle_count;
+			}
+
+			/*
+			* HALT and busy-wait loops are fast-forwarded
+			* to the next event (see CPU::IdleDetector).
+			* Breakpoints inside a skipped loop are hit
+			* once per skip
+			*/
+			void SetIdleSkip(bool enable);
+			bool IdleSkipEnabled() const;
+
+			//Idle loops are not skipped while
+			//tracing or watching the memory
+			bool IdleLoopSkip() const;
+
+			/*
+			* Input movies (see Saves::Movie). Recording starts
+			* at power on, without the boot ROM, or from the
+			* current state. From then on the joypad is latched
+			* at frame boundaries and the clock of the cartridge
+			* follows the emulated time. Not thread safe, call
+			* while the emulation is not running
+			*/
+			std::pair<bool, std::string> RecordMovie(bool from_state);
+
+			//Saves the frames completed so far and
+			//stops the recording
+			std::pair<bool, std::string> SaveMovie(std::string const& path);
+
+			//Restores the start of the movie and plays it
+			//until MovieFinished, the frontend has no effect
+			std::pair<bool, std::string> PlayMovie(std::string const& path);
+
+			void StopMovie();
+
+			//Every frame of the played movie has run
+			bool MovieFinished() const;
+
+			//Seconds since the epoch (UTC) for the clock of the
+			//cartridge, empty when it follows the host clock
+			std::optional<int64_t> FixedClock() const;
+
 		/// <summary>
 		/// Options
 		/// </summary>
@@ -196,6 +435,18 @@ namespace GameboyEmu {
 		
 		private :
 			void ApplySharks();
+
+			void frame_tasks();
+			void save_tasks();
+
+			//Latches the buttons of the next frame
+			void movie_frame();
+
+			void start_clock(int64_t start);
+
+			void queue_save(SaveKind kind, std::string const& path);
+
+			void guest_sample(unsigned cycles);
 		};
 	}
 }
\ No newline at end of file
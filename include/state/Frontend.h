@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "../logging/Logger.h"
+
+#include <functional>
+
+namespace GameboyEmu {
+	namespace Graphics {
+		class Screen;
+	}
+
+	namespace Sound {
+		class OutputDevice;
+	}
+
+	namespace DataTransfer {
+		class SerialDevice;
+	}
+
+	namespace State {
+		/*
+		* Creates the platform dependent devices
+		* (window, audio output, serial link) used
+		* by an EmulatorState. 
+		* 
+		* The core is built without SDL, Poco or cli,
+		* the executable passes its own frontend,
+		* while headless instances have none
+		*/
+		class Frontend {
+		public :
+			virtual Graphics::Screen* CreateScreen(Logger& log, std::function<void()> on_stop) = 0;
+			virtual Sound::OutputDevice* CreateAudio(Logger& log) = 0;
+			virtual DataTransfer::SerialDevice* CreateSerial() = 0;
+
+			virtual ~Frontend() {}
+		};
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../common/Common.h"
+#include "../cpu/Cpu.h"
+#include "../memory/Memory.h"
+#include "../graphics/ppu/PPU.h"
+#include "../timing/Timer.h"
+#include "../input/Joypad.h"
+#include "../sound/apu/APU.h"
+#include "../datatransfer/Serial.h"
+
+namespace GameboyEmu {
+	namespace State {
+		class EmulatorState;
+
+		/*
+		* The components of the console, held by value in
+		* a single block : the state touched on every step
+		* is contiguous instead of spread over the heap.
+		*
+		* The members are built in this order, the memory
+		* after the devices it maps and the cpu last
+		*/
+		struct alignas(64) Machine {
+			Machine(EmulatorState* state, Cartridge::MemoryCard* card,
+				Sound::OutputDevice* out_dev, DataTransfer::SerialDevice* serial_dev);
+
+			Machine(Machine const&) = delete;
+			Machine& operator=(Machine const&) = delete;
+
+			DataTransfer::Serial serial;
+			Sound::APU apu;
+			Graphics::PPU ppu;
+			Timing::Timer timer;
+			Input::Joypad joypad;
+			Mem::Memory memory;
+			CPU::Cpu cpu;
+		};
+	}
+}
@@ -3,10 +3,19 @@
 #include "../common/Common.h"
 #include <ctime>
 
+namespace GameboyEmu::State {
+	class EmulatorState;
+}
+
 namespace GameboyEmu::Timing {
+	/*
+	* Clock of the MBC3, it follows the host clock
+	* unless the emulator runs on a fixed clock
+	* (see EmulatorState::FixedClock)
+	*/
 	class RealTimeClock {
 	public :
-		RealTimeClock();
+		RealTimeClock(State::EmulatorState* state);
 
 		byte ReadRegister(byte id) const;
 		void WriteRegister(byte id, byte value);
@@ -17,6 +26,8 @@ namespace GameboyEmu::Timing {
 		std::tm GetTimePoint() const;
 
 	private :
+		State::EmulatorState* m_state;
+
 		byte m_last_written;
 
 		byte m_seconds;
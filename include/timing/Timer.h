@@ -2,24 +2,43 @@
 
 #include "../common/Common.h"
 
+#include <cstdint>
+
 namespace GameboyEmu {
 	namespace Mem {
 		class Memory;
 	}
 
+	namespace State {
+		class EmulatorState;
+	}
+
 	namespace Timing {
 
+		/*
+		* DIV is the upper byte of a 16 bit system counter
+		* incremented every clock cycle, TIMA is incremented
+		* on the falling edges of one of its bits (selected
+		* by TAC, when enabled).
+		*
+		* Both are computed from the clock of the emulator
+		* when read or written, the only scheduled work is
+		* the next TIMA overflow (see NextEvent).
+		* Writes to DIV and TAC can produce a falling edge,
+		* and increment TIMA like the hardware does
+		*/
 		class Timer {
 		private:
-			//Incremented at a rate of 16384Hz
-			//always incremented (when the cpu is not STOPPED)
-			byte m_divider;
-
-			//Incremented at the frequence specified by
-			//the TAC register
-			//On overflow, it is reset at the value
-			//set in TMA and an interrupt is requested
+			State::EmulatorState* m_state;
+
+			//Clock cycle at which the system counter was 0,
+			//reset by writes to DIV
+			uint64_t m_counter_base;
+
+			//Value of TIMA at the clock cycle m_tima_time,
+			//the increments after are computed when needed
 			byte m_tima;
+			uint64_t m_tima_time;
 
 			//Timer modulo, the value that is assigned
 			//to TIMA on overflow
@@ -30,19 +49,20 @@ namespace GameboyEmu {
 
 			byte m_clock_select;
 
+			//Clock cycles between two increments of TIMA
 			unsigned m_real_clock_cycle;
 
-			unsigned m_current_cycles;
-			unsigned m_divider_cycles;
+			//Clock cycle of the next overflow
+			uint64_t m_next_event;
 
 			Mem::Memory* m_mem;
 
 		public:
-			Timer();
+			Timer(State::EmulatorState* state);
 
 			void SetMemory(Mem::Memory* mmu);
 
-			//Writes to Div will reset the register 
+			//Writes to Div will reset the register
 			//to 0 (the argument is effectively ignored)
 			void SetDiv(byte);
 
@@ -57,10 +77,40 @@ namespace GameboyEmu {
 			byte GetTma() const;
 			byte GetTAC() const;
 
-			void Tick(byte cycles);
+			//Update must be called once the clock reaches it
+			inline uint64_t NextEvent() const {
+				return m_next_event;
+			}
+
+			//Serves the overflows up to now
+			void Update();
 
 			std::size_t DumpState(byte* buffer, std::size_t offset);
-			std::size_t LoadState(byte* buffer, std::size_t offset);
+			std::size_t LoadState(const byte* buffer, std::size_t offset);
+
+		private:
+			uint64_t now() const;
+
+			//System counter at the clock cycle time
+			inline uint64_t counter(uint64_t time) const {
+				return time - m_counter_base;
+			}
+
+			//Increments of TIMA in (from, to]
+			uint64_t edges(uint64_t from, uint64_t to) const;
+
+			//Brings TIMA up to time
+			void sync(uint64_t time);
+
+			//Handles the overflows and their interrupt
+			void increment(uint64_t count);
+
+			void schedule();
+
+			//The timer input, its falling edges increment TIMA
+			bool signal(uint64_t time) const;
+
+			void set_clock_select(byte select);
 		};
 	}
-}
\ No newline at end of file
+}
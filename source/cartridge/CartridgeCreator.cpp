@@ -1,66 +1,51 @@
 #include "../../include/cartridge/CartridgeCreator.h"
 
 #include <utility>
-#include <fstream>
 
 #include "../../include/cartridge/RomOnly.h"
 #include "../../include/cartridge/Mbc1.h"
 #include "../../include/cartridge/Mbc3.h"
 #include "../../include/cartridge/CardUtils.h"
+#include "../../include/memory/RomImage.h"
 
 namespace GameboyEmu::Cartridge {
 
 	std::pair< MemoryCard*, std::string > CreateCartridge(std::filesystem::path const& path, State::EmulatorState* ctx) {
-		if (!std::filesystem::exists(path)) {
-			return std::pair(nullptr, "File does not exist");
-		}
-
-		if (!std::filesystem::is_regular_file(path)) {
-			return std::pair(nullptr, "File is not a regular file");
-		}
-
-		//open file in read binary mode
-		std::ifstream file(path, std::ios::in | std::ios::binary);
-
-		//file is not readable 
-		if (!file.good())
-			return std::pair(nullptr, "Cannot read file");
+		//The rom is mapped read only and shared
+		//with the other instances of the same file
+		auto image_or_error = Mem::RomImage::Open(path);
 
-		//set position at the end of the file and read the index value
-		file.seekg(0, std::ios::end);
+		Mem::RomImage* image = image_or_error.first;
 
-		std::streampos sz = file.tellg();
-
-		//reset the position
-		file.seekg(0, std::ios::beg);
-		////////////////////////
-
-		//allocate buffer
-		byte* data = new byte[sz];
+		if (image == nullptr) {
+			return std::pair(nullptr, image_or_error.second);
+		}
 
-		//copy all the file into memory
-		file.read((char*)data, sz);
+		const byte* data = image->Data();
 
-		if (sz < 0x014F)
+		if (image->Size() < 0x0150) {
+			delete image;
 			return std::pair(nullptr, "File is too small");
+		}
 
 		MemoryCard* ret = nullptr;
 		std::string message = "";
 
 		if (data[0x0143] == 0xC0) {
+			delete image;
 			return std::pair(nullptr, "Cartridge requires CGB functions");
 		}
 
 		switch (data[0x0147])
 		{
 		case 0x00:
-			ret = new RomOnly(ctx, data, sz);
+			ret = new RomOnly(ctx, image);
 			break;
 
 		case 0x01:
 		case 0x02:
 		case 0x03:
-			ret = new Mbc1(ctx, data, sz);
+			ret = new Mbc1(ctx, image);
 			break;
 
 		case 0x0F:
@@ -68,10 +53,11 @@ namespace GameboyEmu::Cartridge {
 		case 0x11:
 		case 0x12:
 		case 0x13:
-			ret = new Mbc3(ctx, data, sz);
+			ret = new Mbc3(ctx, image);
 			break;
 
 		default:
+			delete image;
 			message = "Invalid or unimplemented cartridge type";
 			break;
 		}
@@ -1,13 +1,15 @@
 #include "../../include/cartridge/Mbc1.h"
 #include "../../include/state/EmulatorState.h"
+#include "../../include/save/MappedSram.h"
+#include "../../include/memory/RomImage.h"
 
 namespace GameboyEmu::Cartridge {
 
-	Mbc1::Mbc1(State::EmulatorState* state, byte* data, unsigned numb)
-		: m_state(state), m_therom(data), m_numbytes(numb), m_second_bank_num(1),
+	Mbc1::Mbc1(State::EmulatorState* state, Mem::RomImage* rom)
+		: m_state(state), m_image(rom), m_therom(rom->Data()), m_numbytes((unsigned)rom->Size()), m_second_bank_num(1),
 		m_bank_num_hi(0), m_first_bank_num(0), m_enableRam(false), m_bankingMode(false), m_numbanks(0),
-		m_rambank(0), m_numrambanks(0), m_sram(nullptr),
-		MemoryCard(span(data + 0x100, 0x014F - 0x100 + 1)) {
+		m_rambank(0), m_numrambanks(0), m_sram(nullptr), m_mapped(nullptr),
+		MemoryCard(span(const_cast<byte*>(rom->Data()) + 0x100, 0x014F - 0x100 + 1)) {
 		m_numbanks = m_numbytes / 0x4000;
 
 		auto ramSz = MemoryCard::GetRamSize();
@@ -16,7 +18,7 @@ namespace GameboyEmu::Cartridge {
 
 		m_numrambanks = ramKb / 8;
 
-		m_sram = new byte[ramKb * 1024];
+		m_sram = new byte[ramKb * 1024]();
 	}
 
 	/*
@@ -183,8 +185,14 @@ namespace GameboyEmu::Cartridge {
 					& (m_numrambanks - 1);
 			}
 
-			m_sram[(address - 0xA000) +
-				(rambankSelect * 0x2000)] = value;
+			std::size_t index = (address - 0xA000) +
+				(rambankSelect * 0x2000);
+
+			m_sram[index] = value;
+
+			if (m_mapped != nullptr) {
+				m_mapped->MarkDirty(index);
+			}
 		} break;
 
 		default:
@@ -217,11 +225,48 @@ namespace GameboyEmu::Cartridge {
 
 	void Mbc1::LoadRamSave(byte* buf) {
 		std::copy_n(buf, m_numrambanks * 0x2000, m_sram);
+
+		if (m_mapped != nullptr) {
+			m_mapped->MarkAllDirty();
+		}
 	}
 
-	Mbc1::~Mbc1() {
-		delete[] m_therom;
+	std::pair<bool, std::string> Mbc1::MapRamSave(std::string const& path) {
+		if (!SupportsSaves()) {
+			return std::pair(false, "Cartridge does not support saves");
+		}
+
+		if (m_mapped != nullptr) {
+			return std::pair(false, "RAM is already mapped");
+		}
+
+		Saves::MappedSram* mapped = new Saves::MappedSram();
+
+		auto res = mapped->Open(path, MemoryCard::GetTitle(),
+			(std::size_t)m_numrambanks * 0x2000, m_sram);
+
+		if (!res.first) {
+			delete mapped;
+			return res;
+		}
+
 		delete[] m_sram;
+
+		m_sram = mapped->Data();
+		m_mapped = mapped;
+
+		return res;
+	}
+
+	Mbc1::~Mbc1() {
+		delete m_image;
+
+		if (m_mapped != nullptr) {
+			delete m_mapped;
+		}
+		else {
+			delete[] m_sram;
+		}
 	}
 
 	std::size_t Mbc1::DumpState(byte* buffer, std::size_t offset) {
@@ -242,7 +287,7 @@ namespace GameboyEmu::Cartridge {
 		return offset + (sizekb * 1024);
 	}
 
-	std::size_t Mbc1::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t Mbc1::LoadState(const byte* buffer, std::size_t offset) {
 		byte type = buffer[offset];
 
 		if (type != MemoryCard::GetType()) {
@@ -262,12 +307,22 @@ namespace GameboyEmu::Cartridge {
 
 		std::copy_n(buffer + offset, (uint64_t)sizekb * 1024, m_sram);
 
+		if (m_mapped != nullptr) {
+			m_mapped->MarkAllDirty();
+		}
+
 		return offset + (sizekb * 1024);
 	}
 
 	std::vector<Mbc1::replace_type> Mbc1::ApplyPatch(byte replace, word address, short compare) {
 		std::vector<Mbc1::replace_type> list;
 
+		//The first patch moves the rom to
+		//a private copy on write mapping
+		byte* rom = m_image->Writable();
+
+		m_therom = rom;
+
 		if (address < 0x4000) {
 			//Replace values in all the
 			//possible banks that can
@@ -287,7 +342,7 @@ namespace GameboyEmu::Cartridge {
 				if (compare == -1 || m_therom[pos] == compare) {
 					byte old = m_therom[pos];
 
-					m_therom[pos] = replace;
+					rom[pos] = replace;
 
 					list.push_back(replace_type((word)bank_index, old));
 				}
@@ -307,7 +362,7 @@ namespace GameboyEmu::Cartridge {
 				if (compare == -1 || m_therom[pos] == compare) {
 					byte old = m_therom[pos];
 
-					m_therom[pos] = replace;
+					rom[pos] = replace;
 
 					list.push_back(replace_type((word)bank, old));
 				}
@@ -318,6 +373,8 @@ namespace GameboyEmu::Cartridge {
 	}
 
 	void Mbc1::RemovePatch(std::vector<Mbc1::replace_type> const& replaces, word address) {
+		byte* rom = m_image->Writable();
+
 		for (auto const& replace : replaces) {
 			byte old_value = replace.second;
 			word banknum = replace.first;
@@ -326,7 +383,7 @@ namespace GameboyEmu::Cartridge {
 
 			uint64_t pos = ((uint64_t)banknum * 0x4000) + address;
 
-			m_therom[pos] = old_value;
+			rom[pos] = old_value;
 		}
 	}
 
@@ -342,6 +399,10 @@ namespace GameboyEmu::Cartridge {
 
 		m_sram[address] = shark.new_data;
 
+		if (m_mapped != nullptr) {
+			m_mapped->MarkDirty(address);
+		}
+
 		return old;
 	}
 }
\ No newline at end of file
@@ -1,19 +1,23 @@
 #include "../../include/cartridge/Mbc3.h"
+#include "../../include/save/MappedSram.h"
+#include "../../include/memory/RomImage.h"
+
+#include <algorithm>
 
 namespace GameboyEmu::Cartridge {
-	Mbc3::Mbc3(State::EmulatorState* state, byte* data, unsigned numb) :
-		m_state(state), m_rom(data), m_bank_number(1), 
-		m_sram(nullptr), m_ram_bank_number(), m_enable_rtc_ram(false), 
+	Mbc3::Mbc3(State::EmulatorState* state, Mem::RomImage* rom) :
+		m_state(state), m_image(rom), m_rom(rom->Data()), m_bank_number(1), 
+		m_sram(nullptr), m_mapped(nullptr), m_ram_bank_number(), m_enable_rtc_ram(false), 
 		m_total_banks(), m_total_ram_banks(), m_rtc_reg_select(),
-		m_rtc_or_ram(false), m_rtc(),
-		MemoryCard(span(data + 0x100, 0x014F - 0x100 + 1))
+		m_rtc_or_ram(false), m_rtc(state),
+		MemoryCard(span(const_cast<byte*>(rom->Data()) + 0x100, 0x014F - 0x100 + 1))
 	{
 		word ramkb = getRamKb(MemoryCard::GetRamSize());
 
-		m_total_banks = numb / (16 * 1024);
+		m_total_banks = (byte)(rom->Size() / (16 * 1024));
 		m_total_ram_banks = ramkb / 8;
 
-		m_sram = new byte[ramkb * 1024];
+		m_sram = new byte[ramkb * 1024]();
 	}
 
 	byte Mbc3::Read(word address) {
@@ -31,6 +35,9 @@ namespace GameboyEmu::Cartridge {
 				return m_rtc.ReadRegister(m_rtc_reg_select);
 			}
 
+			if (m_total_ram_banks == 0)
+				return 0xFF;
+
 			return m_sram[(address - 0xA000) + (m_ram_bank_number * 0x2000)];
 		}
 
@@ -57,7 +64,11 @@ namespace GameboyEmu::Cartridge {
 			else {
 				m_rtc_or_ram = false;
 				m_ram_bank_number = value;
-				m_ram_bank_number &= ~m_total_ram_banks;
+
+				//Bank counts are powers of two, the
+				//selected bank must stay inside the RAM
+				m_ram_bank_number &= m_total_ram_banks != 0 ?
+					m_total_ram_banks - 1 : 0;
 			}
 		}
 		else if (address < 0x8000) {
@@ -71,9 +82,17 @@ namespace GameboyEmu::Cartridge {
 				m_rtc.WriteRegister(m_rtc_reg_select, value);
 				return;
 			}
+
+			if (m_total_ram_banks == 0)
+				return;
 				
-			m_sram[(address - 0xA000) + (m_ram_bank_number * 0x2000)] =
-				value;
+			std::size_t index = (address - 0xA000) + (m_ram_bank_number * 0x2000);
+
+			m_sram[index] = value;
+
+			if (m_mapped != nullptr) {
+				m_mapped->MarkDirty(index);
+			}
 		}
 	}
 
@@ -94,31 +113,74 @@ namespace GameboyEmu::Cartridge {
 
 	void Mbc3::LoadRamSave(byte* buf) {
 		std::copy_n(buf, m_total_ram_banks * 0x2000, m_sram);
+
+		if (m_mapped != nullptr) {
+			m_mapped->MarkAllDirty();
+		}
 	}
 
-	Mbc3::~Mbc3() {
+	std::pair<bool, std::string> Mbc3::MapRamSave(std::string const& path) {
+		if (!SupportsSaves()) {
+			return std::pair(false, "Cartridge does not support saves");
+		}
+
+		if (m_mapped != nullptr) {
+			return std::pair(false, "RAM is already mapped");
+		}
+
+		Saves::MappedSram* mapped = new Saves::MappedSram();
+
+		auto res = mapped->Open(path, MemoryCard::GetTitle(),
+			(std::size_t)m_total_ram_banks * 0x2000, m_sram);
+
+		if (!res.first) {
+			delete mapped;
+			return res;
+		}
+
 		delete[] m_sram;
-		delete[] m_rom;
+
+		m_sram = mapped->Data();
+		m_mapped = mapped;
+
+		return res;
+	}
+
+	Mbc3::~Mbc3() {
+		if (m_mapped != nullptr) {
+			delete m_mapped;
+		}
+		else {
+			delete[] m_sram;
+		}
+
+		delete m_image;
 	}
 
 	std::size_t Mbc3::DumpState(byte* buffer, std::size_t offset) {
 		return offset;
 	}
 
-	std::size_t Mbc3::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t Mbc3::LoadState(const byte* buffer, std::size_t offset) {
 		return offset;
 	}
 
 	std::vector<Mbc3::replace_type> Mbc3::ApplyPatch(byte replace, word address, short compare) {
 		std::vector<replace_type> ret;
 
+		//The first patch moves the rom to
+		//a private copy on write mapping
+		byte* rom = m_image->Writable();
+
+		m_rom = rom;
+
 		if (address < 0x4000) {
 			//Only rom bank 00 can be
 			//mapped to 0x0000 - 0x3FFF
 			if (compare == -1 || m_rom[address] == compare) {
 				byte old_value = m_rom[address];
 
-				m_rom[address] = replace;
+				rom[address] = replace;
 
 				ret.push_back(replace_type(0, old_value));
 			}
@@ -131,7 +193,7 @@ namespace GameboyEmu::Cartridge {
 				if (compare == -1 || m_rom[address] == compare) {
 					byte old_value = m_rom[address];
 
-					m_rom[address] = replace;
+					rom[address] = replace;
 
 					ret.push_back(replace_type(bank, old_value));
 				}
@@ -142,6 +204,8 @@ namespace GameboyEmu::Cartridge {
 	}
 
 	void Mbc3::RemovePatch(std::vector<Mbc3::replace_type> const& replaces, word address) {
+		byte* rom = m_image->Writable();
+
 		for (auto const& replace : replaces) {
 			byte old_value = replace.second;
 			word banknum = replace.first;
@@ -150,7 +214,7 @@ namespace GameboyEmu::Cartridge {
 
 			uint64_t pos = ((uint64_t)banknum * 0x4000) + address;
 
-			m_rom[pos] = old_value;
+			rom[pos] = old_value;
 		}
 	}
 
@@ -166,6 +230,10 @@ namespace GameboyEmu::Cartridge {
 
 		m_sram[address] = shark.new_data;
 
+		if (m_mapped != nullptr) {
+			m_mapped->MarkDirty(address);
+		}
+
 		return old;
 	}
 }
\ No newline at end of file
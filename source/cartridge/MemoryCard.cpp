@@ -72,6 +72,12 @@ namespace GameboyEmu {
 			return m_newLicenseeCode;
 		}
 
+		std::pair<bool, std::string> MemoryCard::MapRamSave(std::string const& path) {
+			(void)path;
+
+			return std::pair(false, "Cartridge does not support saves");
+		}
+
 		std::string_view MemoryCard::GetTitle() const {
 			return std::string_view(m_title);
 		}
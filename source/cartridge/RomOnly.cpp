@@ -1,13 +1,18 @@
 #include "../../include/cartridge/RomOnly.h"
 #include "../../include/state/EmulatorState.h"
+#include "../../include/memory/RomImage.h"
 
 namespace GameboyEmu::Cartridge {
 
-	RomOnly::RomOnly(State::EmulatorState* state, byte* theRom, unsigned numbytes) :
-		m_state(state), m_rom(theRom), m_bytes(numbytes),
-		MemoryCard(span(theRom + 0x100, 0x014F - 0x0100 + 1)) {}
+	RomOnly::RomOnly(State::EmulatorState* state, Mem::RomImage* rom) :
+		m_state(state), m_image(rom), m_rom(rom->Data()), m_bytes((unsigned)rom->Size()),
+		MemoryCard(span(const_cast<byte*>(rom->Data()) + 0x100, 0x014F - 0x0100 + 1)) {}
 
 	byte RomOnly::Read(word address) {
+		//No RAM, the bus reads 0xFF
+		if (address >= m_bytes)
+			return 0xFF;
+
 		return m_rom[address];
 	}
 
@@ -38,7 +43,7 @@ namespace GameboyEmu::Cartridge {
 	}
 
 	RomOnly::~RomOnly() {
-		delete[] m_rom;
+		delete m_image;
 	}
 
 	std::size_t RomOnly::DumpState(byte* buffer, std::size_t offset) {
@@ -47,7 +52,7 @@ namespace GameboyEmu::Cartridge {
 		return offset + 1;
 	}
 
-	std::size_t RomOnly::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t RomOnly::LoadState(const byte* buffer, std::size_t offset) {
 		byte type = buffer[offset];
 
 		if (type != MemoryCard::GetType()) {
@@ -60,10 +65,16 @@ namespace GameboyEmu::Cartridge {
 	std::vector<RomOnly::replace_type> RomOnly::ApplyPatch(byte replace, word address, short compare) {
 		std::vector<replace_type> ret;
 
+		//The first patch moves the rom to
+		//a private copy on write mapping
+		byte* rom = m_image->Writable();
+
+		m_rom = rom;
+
 		if (compare == -1 || m_rom[address] == compare) {
 			byte old = m_rom[address];
 
-			m_rom[address] = replace;
+			rom[address] = replace;
 
 			if (address < 0x4000) {
 				ret.push_back(replace_type(0, old));
@@ -79,7 +90,7 @@ namespace GameboyEmu::Cartridge {
 	void RomOnly::RemovePatch(std::vector<RomOnly::replace_type> const& replaces, word address) {
 		replace_type replace = replaces[0];
 
-		m_rom[address] = replace.second;
+		m_image->Writable()[address] = replace.second;
 	}
 
 	byte RomOnly::ApplyShark(Cheats::GameShark const& shark) { return 0xFF; }
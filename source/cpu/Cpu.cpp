@@ -8,6 +8,8 @@
 #include "../../include/cpu/CpuInstr.h"
 #include "../../include/state/EmulatorState.h"
 #include "../../include/memory/Memory.h"
+#include "../../include/debugger/Profiler.h"
+#include "../../include/debugger/Tracer.h"
 
 /*
 * Fetch - Decode - Execute
@@ -294,7 +296,11 @@ namespace GameboyEmu {
 		}
 
 		Cpu::Cpu(State::EmulatorState* emuctx, Mem::Memory* mmu)
-			: m_ctx(), m_state(emuctx), m_mem(mmu), m_jumpTable(nullptr)
+			: m_ctx(), m_state(emuctx), m_mem(mmu), m_jumpTable(nullptr),
+			m_profiler(emuctx->GetProfiler()),
+			m_tracer(emuctx->GetTracer()),
+			m_interrupts(&mmu->GetInterrupts()),
+			m_idle()
 		{
 			m_jumpTable = new jmp_type[256];
 
@@ -310,97 +316,26 @@ namespace GameboyEmu {
 			if (!m_ctx.enableInt)
 				return 0;
 
-			//read interrupt request register
-			byte ir = m_mem->Read(0xFF0F);
-			byte ie = m_mem->Read(0xFFFF);
+			//Requested and enabled, lowest bit first
+			byte pending = m_interrupts->Pending();
 
-			if (
-				VBLANK_BIT_GET(ir) &&
-				VBLANK_BIT_GET(ie)
-				) {
-				//LOG_INFO(state->getLogger(), "VBLANK Interrupt\n");
-				return serve_interrupt(0x00);
-			}
-
-			if (
-				LCDSTAT_BIT_GET(ir) &&
-				LCDSTAT_BIT_GET(ie)
-				) {
-				//LOG_INFO(state->getLogger(), "LCDSTAT Interrupt\n");
-				return serve_interrupt(0x01);
-			}
-
-			if (
-				TIMER_BIT_GET(ir) &&
-				TIMER_BIT_GET(ie)
-				) {
-				//LOG_INFO(state->getLogger(), "Timer Interrupt\n");
-				return serve_interrupt(0x02);
-			}
-
-			if (
-				SERIAL_BIT_GET(ir) &&
-				SERIAL_BIT_GET(ie)
-				) {
-				//LOG_INFO(state->getLogger(), "Serial Interrupt\n");
-				return serve_interrupt(0x03);
-			}
-
-			if (
-				JOYPAD_BIT_GET(ir) &&
-				JOYPAD_BIT_GET(ie)
-				) {
-				//LOG_INFO(state->getLogger(), "Joypad Interrupt\n");
-				return serve_interrupt(0x04);
-			}
+			if (pending == 0)
+				return 0;
 
-			return 0;
+			return serve_interrupt(Mem::InterruptController::First(pending));
 		}
 
-		byte Cpu::serve_interrupt(byte type) {
+		byte Cpu::serve_interrupt(Mem::Interrupt type) {
 			//LOG_INFO(state->getLogger(), "Serving interrupt 0x{2:x}\n", type);
 
-			byte ir = m_mem->Read(0xFF0F);
-
 			m_ctx.enableInt = false;
 
-			word handler = 0x00;
-
-			switch (type)
-			{
-			case 0x00: //VBLANK
-				VBLANK_BIT_RESET(ir);
-				handler = 0x40;
-				break;
-
-			case 0x01: //LCD STAT
-				LCDSTAT_BIT_RESET(ir);
-				handler = 0x48;
-				break;
-
-			case 0x02: //Timer
-				TIMER_BIT_RESET(ir);
-				handler = 0x50;
-				break;
-
-			case 0x03: //Serial
-				SERIAL_BIT_RESET(ir);
-				handler = 0x58;
-				break;
-
-			case 0x04: //Joypad
-				JOYPAD_BIT_RESET(ir);
-				handler = 0x60;
-				break;
-
-			default:
-				LOG_ERR(m_state->GetLogger(), "Invalid interrupt code\n");
-				return 0;
-			}
+			m_interrupts->Acknowledge(type);
 
-			m_mem->Write(0xFF0F, ir);
+			//The handler runs out of the loop
+			m_idle.Reset();
 
-			interrupt_routine(handler);
+			interrupt_routine(Mem::InterruptController::Handler(type));
 
 			return 5;
 		}
@@ -421,14 +356,34 @@ namespace GameboyEmu {
 			m_state->Sync(1);
 		}
 
-		byte Cpu::Step() {
-			if (m_ctx.halted) {
-				byte ie = m_mem->Read(0xFFFF);
-				byte ir = m_mem->Read(0xFF0F);
+		unsigned Cpu::halted_step() {
+			//Only an interrupt wakes the cpu up, and they
+			//are raised by the events (or by the inputs)
+			uint64_t cycles = m_state->CyclesToEvent() & ~(uint64_t)3;
+
+			if (cycles <= 4) {
+				m_state->Sync(1);
+
+				return 4;
+			}
 
-				if ((ir & ie) != 0) {
+			m_state->Skip(cycles);
+
+			return (unsigned)cycles;
+		}
+
+		unsigned Cpu::Step() {
+			//Halt, interrupts, fetch and the rest
+			//of the step, minus the instruction
+			PROFILE_SCOPE(m_profiler, Debugger::Component::cpu_decode);
+
+			if (m_ctx.halted) {
+				if (m_interrupts->Pending() != 0) {
 					m_ctx.halted = false;
 				}
+				else if (m_ctx.ei_delay == 0 && m_state->IdleSkipEnabled()) {
+					return halted_step();
+				}
 
 				m_state->Sync(1);
 
@@ -443,7 +398,13 @@ namespace GameboyEmu {
 
 			handle_interrupts();
 
-			byte instruction = m_mem->Read(m_ctx.ip);
+			word pc = m_ctx.ip;
+
+			byte instruction = m_mem->Read(pc);
+
+			if (m_tracer->Enabled()) [[unlikely]] {
+				trace(instruction);
+			}
 
 			if (!m_ctx.haltBug) {
 				m_ctx.ip++;
@@ -454,7 +415,7 @@ namespace GameboyEmu {
 
 			m_state->Sync(1);
 
-			byte cycles = 0;
+			unsigned cycles = 0;
 
 			//state->getLogger().log_info("Instruction : {0} at 0x{1:x}\n", disassemble(ctx.ip - 1, this->mem).first, ctx.ip - 1);
 
@@ -464,7 +425,11 @@ namespace GameboyEmu {
 					instruction, m_ctx.ip - 1);
 			}
 			else {
-				cycles = (m_jumpTable[instruction])(m_ctx, m_mem, m_state);
+				//CB prefixed opcodes are counted apart
+				PROFILED_OPCODE(m_profiler,
+					instruction == 0xCB ? 0x100 + m_mem->Peek(m_ctx.ip) : instruction,
+					cycles = (m_jumpTable[instruction])(m_ctx, m_mem, m_state)
+				);
 			}
 			
 			if (m_ctx.ei_delay > 0) {
@@ -473,6 +438,12 @@ namespace GameboyEmu {
 				m_ctx.enableInt = (m_ctx.ei_delay == 0);
 			}
 
+			//Short jump back, maybe a busy-wait loop
+			if (m_ctx.ip < pc && pc - m_ctx.ip <= IdleDetector::max_length &&
+				m_state->IdleLoopSkip()) {
+				cycles += (unsigned)m_idle.Closed(m_ctx.ip, pc, m_ctx, m_mem, m_state);
+			}
+
 			return cycles;
 		}
 
@@ -488,6 +459,31 @@ namespace GameboyEmu {
 			delete[] m_jumpTable;
 		}
 
+		void Cpu::trace(byte instruction) {
+			Debugger::TraceRecord record;
+
+			record.cycle = m_state->GetCycleCount();
+			record.pc = m_ctx.ip;
+			record.af = m_ctx.af;
+			record.bc = m_ctx.bc;
+			record.de = m_ctx.de;
+			record.hl = m_ctx.hl;
+			record.sp = m_ctx.sp;
+
+			record.bank = m_ctx.ip <= 0x7FFF ?
+				m_state->GetCard()->GetCurrentBank(m_ctx.ip) : 0;
+
+			//Only the bytes of the instruction are read
+			byte len = instruction == 0xCB ? 2 :
+				normalInstructions::len[instruction];
+
+			record.code[0] = instruction;
+			record.code[1] = len > 1 ? m_mem->Peek(m_ctx.ip + 1) : 0;
+			record.code[2] = len > 2 ? m_mem->Peek(m_ctx.ip + 2) : 0;
+
+			m_tracer->Record(record);
+		}
+
 		word Cpu::GetIP() const {
 			return m_ctx.ip;
 		}
@@ -519,7 +515,7 @@ namespace GameboyEmu {
 			return offset + 16;
 		}
 
-		std::size_t Cpu::LoadState(byte* buffer, std::size_t offset) {
+		std::size_t Cpu::LoadState(const byte* buffer, std::size_t offset) {
 			m_ctx.ip = ReadWord(buffer, offset);
 			m_ctx.af = ReadWord(buffer, offset + 2);
 			m_ctx.bc = ReadWord(buffer, offset + 4);
@@ -530,6 +526,9 @@ namespace GameboyEmu {
 			m_ctx.ei_delay = buffer[offset + 13];
 			m_ctx.halted = buffer[offset + 14];
 			m_ctx.haltBug = buffer[offset + 15];
+
+			//The memory changed with the registers
+			m_idle.Reset();
 			
 			return offset + 16;
 		}
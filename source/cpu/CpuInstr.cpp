@@ -137,9 +137,7 @@ inline void stacktrace_push(
 	GameboyEmu::State::EmulatorState* state,
 	word callee, word dest, word ret
 ) {
-	if (
-		state->IsDebugging()
-		&& state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		
 		byte page = 0;
 
@@ -158,9 +156,7 @@ inline void stacktrace_pop(
 	GameboyEmu::State::EmulatorState* state,
 	word ret
 ) {
-	if (
-		state->IsDebugging()
-		&& state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		state->remove_stacktrace_entry(ret);
 	}
 }
@@ -262,8 +258,7 @@ INSTRUCTION(CD, {
 
 	state->Sync(1);
 
-	if (state->IsDebugging() && 
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ipcopy - 3, newip,
 			ipcopy
@@ -302,8 +297,7 @@ INSTRUCTION(C9, {
 
 	ctx.sp += 2;
 
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_pop(state, oldip);
 	}
 
@@ -728,8 +722,7 @@ INSTRUCTION(C4, {
 
 		state->Sync(1);
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_push(
 				state, ipcopy - 3, newip,
 				ipcopy
@@ -961,8 +954,7 @@ INSTRUCTION(D0, {
 
 		ctx.sp += 2;
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_pop(
 				state, oldip
 			);
@@ -989,8 +981,7 @@ INSTRUCTION(C0, {
 
 		ctx.sp += 2;
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_pop(
 				state, oldip
 			);
@@ -1017,8 +1008,7 @@ INSTRUCTION(C8, {
 
 		ctx.sp += 2;
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_pop(
 				state, oldip
 			);
@@ -1045,8 +1035,7 @@ INSTRUCTION(D8, {
 
 		ctx.sp += 2;
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_pop(
 				state, oldip
 			);
@@ -1396,10 +1385,7 @@ INSTRUCTION(76, {
 	ctx.halted = true;
 
 	if (!ctx.enableInt) {
-		byte ie = mem->Read(0xFFFF);
-		byte ir = mem->Read(0xFF0F);
-
-		if ((ie & ir) != 0) {
+		if (mem->GetInterrupts().Pending() != 0) {
 			ctx.haltBug = true;
 		}
 	}
@@ -1986,8 +1972,7 @@ INSTRUCTION(CC, {
 
 		state->Sync(1);
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_push(
 				state, ipcopy - 3, newip,
 				ipcopy
@@ -2028,8 +2013,7 @@ INSTRUCTION(D4, {
 
 		state->Sync(1);
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_push(
 				state, ipcopy - 3, newip,
 				ipcopy
@@ -2070,8 +2054,7 @@ INSTRUCTION(DC, {
 
 		state->Sync(1);
 
-		if (state->IsDebugging() &&
-			state->StacktraceEnabled()) {
+		if (state->StacktraceActive()) {
 			stacktrace_push(
 				state, ipcopy - 3, newip,
 				ipcopy
@@ -2096,8 +2079,7 @@ INSTRUCTION(D9, {
 		ctx.ei_delay = 2;
 	}
 
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_pop(
 			state, oldip
 		);
@@ -2116,8 +2098,7 @@ INSTRUCTION(D9, {
 	state->Sync(1);
 
 INSTRUCTION(C7, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0000,
 			ctx.ip
@@ -2130,8 +2111,7 @@ INSTRUCTION(C7, {
 });
 
 INSTRUCTION(D7, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0010,
 			ctx.ip
@@ -2144,8 +2124,7 @@ INSTRUCTION(D7, {
 	});
 
 INSTRUCTION(E7, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0020,
 			ctx.ip
@@ -2158,8 +2137,7 @@ INSTRUCTION(E7, {
 	});
 
 INSTRUCTION(F7, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0030,
 			ctx.ip
@@ -2172,8 +2150,7 @@ INSTRUCTION(F7, {
 	});
 
 INSTRUCTION(CF, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0008,
 			ctx.ip
@@ -2186,8 +2163,7 @@ INSTRUCTION(CF, {
 	});
 
 INSTRUCTION(DF, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0018,
 			ctx.ip
@@ -2200,8 +2176,7 @@ INSTRUCTION(DF, {
 	});
 
 INSTRUCTION(EF, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0028,
 			ctx.ip
@@ -2214,8 +2189,7 @@ INSTRUCTION(EF, {
 	});
 
 INSTRUCTION(FF, {
-	if (state->IsDebugging() &&
-		state->StacktraceEnabled()) {
+	if (state->StacktraceActive()) {
 		stacktrace_push(
 			state, ctx.ip - 1, 0x0038,
 			ctx.ip
@@ -3,23 +3,28 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
 namespace GameboyEmu::CPU {
 
-	std::pair< std::string, byte > Disassemble(word address, Mem::Memory* mem) {
-		word oldaddress = address;
+	//read(offset) returns the byte at offset from the start
+	//of the instruction, count is the number of readable bytes
+	template <typename Read>
+	static std::pair< std::string, byte > disassemble(Read read, unsigned count) {
+		unsigned offset = 0;
 
-		byte inst = mem->Read(address);
+		byte inst = read(offset);
 
 		std::string ret = "";
 
 		const byte* paramTable;
 
-		if (inst == 0xCB) {
+		if (inst == 0xCB && offset + 1 < count) {
 			ret += "CB ";
 
-			address++;
+			offset++;
 
-			inst = mem->Read(address);
+			inst = read(offset);
 
 			ret += cbInstructions::disasm[inst];
 
@@ -33,12 +38,28 @@ namespace GameboyEmu::CPU {
 
 		byte numParams = paramTable[inst];
 
-		while (numParams-- && (unsigned)address + 1 <= 0xFFFF) {
-			address++;
+		while (numParams-- && offset + 1 < count) {
+			offset++;
+
+			ret += fmt::format(" 0x{:x}", read(offset));
+		}
+
+		return std::pair(ret, (byte)(offset + 1));
+	}
+
+	std::pair< std::string, byte > Disassemble(word address, Mem::Memory* mem) {
+		return disassemble([address, mem](unsigned offset) {
+			return mem->Peek((word)(address + offset));
+		}, 0x10000 - address);
+	}
 
-			ret += fmt::format(" 0x{:x}", mem->Read(address));
+	std::pair< std::string, byte > Disassemble(const byte* code, std::size_t size) {
+		if (size == 0) {
+			return std::pair(std::string{ "<EMPTY>" }, (byte)0);
 		}
 
-		return std::pair(ret, address - oldaddress + 1);
+		return disassemble([code](unsigned offset) {
+			return code[offset];
+		}, (unsigned)std::min<std::size_t>(size, 3));
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,247 @@
+#include "../../include/cpu/IdleDetector.h"
+#include "../../include/cpu/Disasm.h"
+#include "../../include/memory/Memory.h"
+#include "../../include/state/EmulatorState.h"
+#include "../../include/cartridge/MemoryCard.h"
+
+namespace GameboyEmu::CPU {
+
+	IdleDetector::IdleDetector() :
+		m_head(0), m_end(0), m_bank(0), m_idle(false),
+		m_written(0), m_pointers(0),
+		m_armed(false), m_arrival(), m_time(0), m_deadline(0) {}
+
+	bool IdleDetector::safe_read(word address) {
+		//ROM, VRAM and WRAM
+		if (address <= 0x9FFF || (address >= 0xC000 && address <= 0xDFFF)) {
+			return true;
+		}
+
+		//OAM
+		if (address >= 0xFE00 && address <= 0xFE9F) {
+			return true;
+		}
+
+		//LCD registers, but DMA
+		if (address >= 0xFF40 && address <= 0xFF4B) {
+			return address != 0xFF46;
+		}
+
+		//HRAM
+		return address >= 0xFF80 && address <= 0xFFFE;
+	}
+
+	bool IdleDetector::add_instruction(byte opcode, byte low, byte high) {
+		//B, C, D, E, H, L, (HL), A
+		static constexpr byte registers[8] = {
+			reg_b, reg_c, reg_d, reg_e, reg_h, reg_l, 0, reg_a
+		};
+
+		switch (opcode) {
+		case 0x00: //NOP
+		case 0x37: //SCF
+		case 0x3F: //CCF
+			return true;
+
+		case 0x2F: //CPL
+			m_written |= reg_a;
+			return true;
+
+		case 0x0A: //LD A, (BC)
+			m_pointers |= reg_b | reg_c;
+			m_written |= reg_a;
+			return true;
+
+		case 0x1A: //LD A, (DE)
+			m_pointers |= reg_d | reg_e;
+			m_written |= reg_a;
+			return true;
+
+		case 0xF2: //LD A, (C)
+			m_pointers |= reg_c;
+			m_written |= reg_a;
+			return true;
+
+		case 0xF0: //LDH A, (a8)
+			m_written |= reg_a;
+			return safe_read(0xFF00 | low);
+
+		case 0xFA: //LD A, (a16)
+			m_written |= reg_a;
+			return safe_read((word)((high << 8) | low));
+
+		//ALU A, d8
+		case 0xC6: case 0xCE: case 0xD6: case 0xDE:
+		case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+			m_written |= reg_a;
+			return true;
+
+		case 0xCB:
+			//Only BIT, that does not write
+			if (low < 0x40 || low > 0x7F) {
+				return false;
+			}
+
+			if ((low & 7) == 6) {
+				m_pointers |= reg_h | reg_l;
+			}
+
+			return true;
+
+		default:
+			break;
+		}
+
+		//LD r, r' and LD r, (HL), but the stores and HALT
+		if (opcode >= 0x40 && opcode <= 0x7F) {
+			if (opcode >= 0x70 && opcode <= 0x77) {
+				return false;
+			}
+
+			if ((opcode & 7) == 6) {
+				m_pointers |= reg_h | reg_l;
+			}
+
+			m_written |= registers[(opcode >> 3) & 7];
+
+			return true;
+		}
+
+		//ALU A, r and ALU A, (HL)
+		if (opcode >= 0x80 && opcode <= 0xBF) {
+			if ((opcode & 7) == 6) {
+				m_pointers |= reg_h | reg_l;
+			}
+
+			m_written |= reg_a;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool IdleDetector::analyse(word head, word end, Mem::Memory* mem) {
+		m_written = 0;
+		m_pointers = 0;
+
+		word address = head;
+
+		while (address < end) {
+			byte opcode = mem->Peek(address);
+
+			byte len = opcode == 0xCB ? 2 :
+				normalInstructions::len[opcode];
+
+			byte low = len > 1 ? mem->Peek(address + 1) : 0;
+			byte high = len > 2 ? mem->Peek(address + 2) : 0;
+
+			if (!add_instruction(opcode, low, high)) {
+				return false;
+			}
+
+			address += len;
+		}
+
+		if (address != end) {
+			return false;
+		}
+
+		//The body is left by the jump, or not at all
+		switch (mem->Peek(end)) {
+		case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+		case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA:
+			break;
+
+		default:
+			return false;
+		}
+
+		//A pointer written by the body changes
+		//from one read to the other
+		return (m_pointers & m_written) == 0;
+	}
+
+	bool IdleDetector::safe_pointers(CpuContext const& ctx) const {
+		if ((m_pointers & reg_b) && !safe_read(ctx.bc)) {
+			return false;
+		}
+
+		if ((m_pointers & reg_d) && !safe_read(ctx.de)) {
+			return false;
+		}
+
+		if ((m_pointers & reg_h) && !safe_read(ctx.hl)) {
+			return false;
+		}
+
+		return !(m_pointers & reg_c) || safe_read(0xFF00 | GET_LOW(ctx.bc));
+	}
+
+	bool IdleDetector::same_registers(CpuContext const& ctx) const {
+		return ctx.af == m_arrival.af && ctx.bc == m_arrival.bc &&
+			ctx.de == m_arrival.de && ctx.hl == m_arrival.hl &&
+			ctx.sp == m_arrival.sp;
+	}
+
+	void IdleDetector::arrive(CpuContext const& ctx, State::EmulatorState* state) {
+		m_armed = true;
+		m_arrival = ctx;
+		m_time = state->GetCycleCount();
+		m_deadline = m_time + state->CyclesToEvent();
+	}
+
+	uint64_t IdleDetector::Closed(word head, word end, CpuContext const& ctx,
+		Mem::Memory* mem, State::EmulatorState* state) {
+		//Only the code of the ROM cannot change,
+		//in a single bank
+		if (end > 0x7FFF || (head < 0x4000 && end >= 0x4000)) {
+			return 0;
+		}
+
+		//The ROM may be the bus of the DMA
+		if (mem->GetDma().running) {
+			return 0;
+		}
+
+		byte bank = state->GetCard()->GetCurrentBank(end);
+
+		if (head != m_head || end != m_end || bank != m_bank) {
+			m_head = head;
+			m_end = end;
+			m_bank = bank;
+
+			m_armed = false;
+
+			m_idle = analyse(head, end, mem);
+		}
+
+		if (!m_idle) {
+			return 0;
+		}
+
+		uint64_t skipped = 0;
+
+		//The last iteration saw no event and left the
+		//registers as they were : the next ones are the
+		//same until the next event
+		if (m_armed && same_registers(ctx) &&
+			state->GetCycleCount() < m_deadline &&
+			ctx.ei_delay == 0 && !ctx.haltBug &&
+			!(ctx.enableInt && mem->GetInterrupts().Pending() != 0) &&
+			safe_pointers(ctx)) {
+
+			uint64_t period = state->GetCycleCount() - m_time;
+
+			if (period != 0) {
+				skipped = (state->CyclesToEvent() / period) * period;
+
+				state->Skip(skipped);
+			}
+		}
+
+		arrive(ctx, state);
+
+		return skipped;
+	}
+}
@@ -93,11 +93,7 @@ namespace GameboyEmu::DataTransfer {
 		m_flag = 0;
 		m_data_transfer = data;
 
-		byte ir = m_mmu->Read(0xFF0F);
-
-		SERIAL_BIT_SET(ir);
-
-		m_mmu->Write(0xFF0F, ir);
+		m_mmu->GetInterrupts().Raise(Mem::Interrupt::serial);
 	}
 
 	Serial::~Serial() {
@@ -117,7 +113,7 @@ namespace GameboyEmu::DataTransfer {
 		return offset + 5;
 	}
 
-	std::size_t Serial::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t Serial::LoadState(const byte* buffer, std::size_t offset) {
 		m_data_transfer = buffer[offset];
 		m_flag = buffer[offset + 1];
 		m_clock = (ClockType)buffer[offset + 2];
@@ -0,0 +1,30 @@
+#include "../../../include/datatransfer/out/NullSerial.h"
+
+namespace GameboyEmu::DataTransfer {
+	bool NullSerial::Send(byte& in) {
+		(void)in;
+		return false;
+	}
+
+	void NullSerial::SetOut(byte out) {
+		(void)out;
+	}
+
+	void NullSerial::Listen(std::string const& on) {
+		(void)on;
+	}
+
+	void NullSerial::Connect(std::string const& to) {
+		(void)to;
+	}
+
+	void NullSerial::CloseConnection() {}
+
+	void NullSerial::SetClockType(byte type) {
+		(void)type;
+	}
+
+	bool NullSerial::Connected() const {
+		return false;
+	}
+}
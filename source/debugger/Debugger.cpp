@@ -2,12 +2,13 @@
 #include "../../include/state/EmulatorState.h"
 #include "../../include/cpu/Cpu.h"
 #include "../../include/cpu/Disasm.h"
+#include "../../include/memory/Memory.h"
 
 namespace GameboyEmu::Debugger {
 	DebuggerClass::DebuggerClass() :
 		m_state(nullptr), m_debugging(true),
 		m_enable_breakpoints(true),
-		m_breakpoints(),
+		m_breakpoints(), m_break_bits{},
 		m_emu_thread()
 	{}
 
@@ -75,7 +76,7 @@ namespace GameboyEmu::Debugger {
 	}
 
 	void DebuggerClass::Step(std::ostream& out, bool useout) {
-		m_state->GetCPU()->Step();
+		m_state->Step();
 
 		if (m_state->ShouldBreak()) {
 			m_state->Break(false);
@@ -90,7 +91,7 @@ namespace GameboyEmu::Debugger {
 
 		auto mem = m_state->GetMemory();
 
-		byte instruction = mem->Read(ip);
+		byte instruction = mem->Peek(ip);
 
 		static constexpr byte calls[] = {
 			0xC4, 0xD4, 0xCC, 0xCD, 0xDC,
@@ -111,12 +112,12 @@ namespace GameboyEmu::Debugger {
 			word nextip = ip + disassemble.second;
 
 			do {
-				cpu->Step();
+				m_state->Step();
 			} while (!m_state->Stopped()
 				&& cpu->GetIP() != nextip);
 		}
 		else {
-			cpu->Step();
+			m_state->Step();
 		}
 
 		m_state->Break(false);
@@ -139,8 +140,19 @@ namespace GameboyEmu::Debugger {
 		return itr;
 	}
 
+	void DebuggerClass::rebuild_bitmap() {
+		m_break_bits.fill(0);
+
+		for (auto const& [address, br] : m_breakpoints) {
+			if (br.enabled) {
+				m_break_bits[address >> 6] |= 1ull << (address & 63);
+			}
+		}
+	}
+
 	bool DebuggerClass::breakpoint_triggered(word address) {
-		if (!m_enable_breakpoints || m_breakpoints.size() == 0) {
+		if (!m_enable_breakpoints ||
+			!(m_break_bits[address >> 6] & (1ull << (address & 63)))) {
 			return false;
 		}
 
@@ -189,7 +201,7 @@ namespace GameboyEmu::Debugger {
 		bool br = false;
 
 		do {
-			cpu->Step();
+			m_state->Step();
 
 			br = breakpoint_triggered(cpu->GetIP());
 		} while (!m_state->Stopped() 
@@ -202,8 +214,12 @@ namespace GameboyEmu::Debugger {
 		}
 
 		if (useout && m_state->ShouldBreak()) {
-			out << fmt::format("Break request at IP = 0x{:x}\n",
-				cpu->GetIP());
+			auto const& hit = m_state->GetMemory()->LastWatchHit();
+
+			out << fmt::format("Watchpoint hit at IP = 0x{:x} : "
+				"{} 0x{:x} at 0x{:x}\n",
+				cpu->GetIP(), hit.write ? "write" : "read",
+				hit.value, hit.address);
 		}
 
 		m_state->Break(false);
@@ -264,6 +280,8 @@ namespace GameboyEmu::Debugger {
 		br.enabled = true;
 
 		breaks.insert(std::pair(address, br));
+
+		rebuild_bitmap();
 	}
 
 	void DebuggerClass::BreakpointChange(byte page, word address, word new_hitrate, std::ostream& out, bool useout) {
@@ -294,6 +312,8 @@ namespace GameboyEmu::Debugger {
 		auto itr = findBreakpoint(page, range.first, range.second);
 
 		breaks.erase(itr);
+
+		rebuild_bitmap();
 	}
 
 	void DebuggerClass::BreakpointToggle(byte page, word address, bool enable, std::ostream& out, bool useout) {
@@ -309,46 +329,128 @@ namespace GameboyEmu::Debugger {
 		auto itr = findBreakpoint(page, range.first, range.second);
 
 		itr->second.enabled = enable;
+
+		rebuild_bitmap();
 	}
 
 	void DebuggerClass::BreakpointsDisableAll() {
 		for (auto& key_val : m_breakpoints) {
 			key_val.second.enabled = false;
 		}
+
+		rebuild_bitmap();
 	}
 
 	void DebuggerClass::BreakpointsEnableAll() {
 		for (auto& key_val : m_breakpoints) {
 			key_val.second.enabled = true;
 		}
+
+		rebuild_bitmap();
 	}
 
 	void DebuggerClass::WatchpointsDisableAll() {
 		for (auto& key_val : m_state->GetWatchpoints()) {
 			key_val.second.enabled = false;
 		}
+
+		m_state->UpdateWatchpoints();
 	}
 
 	void DebuggerClass::WatchpointsEnableAll() {
 		for (auto& key_val : m_state->GetWatchpoints()) {
 			key_val.second.enabled = true;
 		}
+
+		m_state->UpdateWatchpoints();
+	}
+
+	bool DebuggerClass::check_watchpoint(bool existsok, word address, std::ostream& out, bool useout) {
+		bool found = m_state->GetWatchpoints().contains(address);
+
+		if (found && !existsok) {
+			if (useout) {
+				out << "Watchpoint already present\n";
+			}
+
+			return false;
+		}
+		else if (!found && existsok) {
+			if (useout) {
+				out << "Watchpoint not present\n";
+			}
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool DebuggerClass::check_watch_type(byte type, std::ostream& out, bool useout) {
+		if (type > (byte)WatchType::readwrite) {
+			if (useout) {
+				out << fmt::format("Invalid watch type {}\n", type);
+			}
+
+			return false;
+		}
+
+		return true;
 	}
 
-	void DebuggerClass::WatchpointSet(word address, byte type, Callbak&& callback, std::ostream& out, bool useout) {
-		//
+	void DebuggerClass::WatchpointSet(word address, byte type, std::optional<byte> value, Callbak&& callback, std::ostream& out, bool useout) {
+		if (!check_watch_type(type, out, useout) ||
+			!check_watchpoint(false, address, out, useout)) {
+			return;
+		}
+
+		Watchpoint watch = {};
+
+		watch.address = address;
+		watch.enabled = true;
+		watch.type = (WatchType)type;
+		watch.conditional = value.has_value();
+		watch.value = value.value_or(0);
+		watch.callback = std::move(callback);
+
+		m_state->GetWatchpoints().emplace(address, std::move(watch));
+
+		m_state->UpdateWatchpoints();
 	}
 
-	void DebuggerClass::WatchpointChange(word address, byte type, std::ostream& out, bool useout) {
-		//
+	void DebuggerClass::WatchpointChange(word address, byte type, std::optional<byte> value, std::ostream& out, bool useout) {
+		if (!check_watch_type(type, out, useout) ||
+			!check_watchpoint(true, address, out, useout)) {
+			return;
+		}
+
+		auto& watch = m_state->GetWatchpoints()[address];
+
+		watch.type = (WatchType)type;
+		watch.conditional = value.has_value();
+		watch.value = value.value_or(0);
+
+		m_state->UpdateWatchpoints();
 	}
 
 	void DebuggerClass::WatchpointDelete(word address, std::ostream& out, bool useout) {
-		//
+		if (!check_watchpoint(true, address, out, useout)) {
+			return;
+		}
+
+		m_state->GetWatchpoints().erase(address);
+
+		m_state->UpdateWatchpoints();
 	}
 
 	void DebuggerClass::WatchpointToggle(word address, bool enable, std::ostream& out, bool useout) {
-		//
+		if (!check_watchpoint(true, address, out, useout)) {
+			return;
+		}
+
+		m_state->GetWatchpoints()[address].enabled = enable;
+
+		m_state->UpdateWatchpoints();
 	}
 
 	std::multimap<word, Breakpoint> const& DebuggerClass::GetBreakpoints() const {
@@ -384,10 +486,8 @@ namespace GameboyEmu::Debugger {
 		m_state->SetStopped(false);
 
 		m_emu_thread = std::thread([this]() {
-			auto cpu = m_state->GetCPU();
-
 			while (!m_state->Stopped()) {
-				cpu->Step();
+				m_state->Step();
 			}
 		});
 	}
@@ -400,10 +500,14 @@ namespace GameboyEmu::Debugger {
 		decltype(m_breakpoints) clear_map;
 
 		m_breakpoints.swap(clear_map);
+
+		rebuild_bitmap();
 	}
 
 	void DebuggerClass::ClearWatchpointList() {
-		//
+		m_state->GetWatchpoints().clear();
+
+		m_state->UpdateWatchpoints();
 	}
 
 	bool DebuggerClass::StacktraceEnabled() const {
@@ -456,7 +560,7 @@ namespace GameboyEmu::Debugger {
 
 		while (last_entry.ret_address !=
 			cpu->GetIP()) {
-			cpu->Step();
+			m_state->Step();
 		}
 
 		m_state->Break(false);
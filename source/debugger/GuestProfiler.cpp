@@ -0,0 +1,263 @@
+#include "../../include/debugger/GuestProfiler.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace GameboyEmu::Debugger {
+	GuestProfiler::GuestProfiler() :
+		m_mutex(), m_period(default_period),
+		m_countdown(default_period), m_samples(0),
+		m_hits(), m_stacks(), m_symbols()
+	{}
+
+	void GuestProfiler::SetPeriod(unsigned cycles) {
+		m_period = std::max(cycles, 4u);
+	}
+
+	unsigned GuestProfiler::GetPeriod() const {
+		return m_period;
+	}
+
+	void GuestProfiler::Reset() {
+		std::scoped_lock lock(m_mutex);
+
+		m_samples = 0;
+		m_hits.clear();
+		m_stacks.clear();
+	}
+
+	void GuestProfiler::Sample(byte bank, word pc, std::vector<StacktraceEntry> const& stack) {
+		std::vector<uint32_t> frames{};
+
+		std::size_t first = stack.size() > max_depth - 1 ?
+			stack.size() - (max_depth - 1) : 0;
+
+		frames.reserve(stack.size() - first + 2);
+
+		//The outermost call site gives the root function
+		if (first < stack.size()) {
+			frames.push_back(make_key(stack[first].page, stack[first].callee));
+		}
+
+		for (std::size_t i = first; i < stack.size(); i++) {
+			frames.push_back(make_key(stack[i].dest_page, stack[i].dest_address));
+		}
+
+		frames.push_back(make_key(bank, pc));
+
+		std::scoped_lock lock(m_mutex);
+
+		m_samples++;
+		m_hits[frames.back()]++;
+		m_stacks[std::move(frames)]++;
+	}
+
+	uint64_t GuestProfiler::SampleCount() const {
+		std::scoped_lock lock(m_mutex);
+
+		return m_samples;
+	}
+
+	std::pair<bool, std::string> GuestProfiler::LoadSymbols(std::string const& path) {
+		std::ifstream file{ path };
+
+		if (!file) {
+			return std::pair(false, fmt::format("Cannot open {}", path));
+		}
+
+		std::vector<std::pair<uint32_t, std::string>> symbols{};
+		std::string line{};
+
+		//"BB:AAAA Name", comments start with ;
+		while (std::getline(file, line)) {
+			auto comment = line.find(';');
+
+			if (comment != std::string::npos) {
+				line.resize(comment);
+			}
+
+			std::istringstream stream{ line };
+			std::string location{}, name{};
+
+			if (!(stream >> location >> name)) {
+				continue;
+			}
+
+			auto colon = location.find(':');
+
+			if (colon == std::string::npos) {
+				continue;
+			}
+
+			try {
+				unsigned long bank = std::stoul(location.substr(0, colon), nullptr, 16);
+				unsigned long address = std::stoul(location.substr(colon + 1), nullptr, 16);
+
+				if (bank > 0xFF || address > 0xFFFF) {
+					continue;
+				}
+
+				symbols.emplace_back(make_key((byte)bank, (word)address), name);
+			}
+			catch (std::exception const&) {
+				continue;
+			}
+		}
+
+		if (symbols.empty()) {
+			return std::pair(false, fmt::format("No symbols found in {}", path));
+		}
+
+		std::scoped_lock lock(m_mutex);
+
+		m_symbols.insert(m_symbols.end(), symbols.begin(), symbols.end());
+
+		std::stable_sort(m_symbols.begin(), m_symbols.end(),
+			[](auto const& a, auto const& b) {
+				return a.first < b.first;
+			});
+
+		return std::pair(true, "");
+	}
+
+	std::pair<uint32_t, std::string> const* GuestProfiler::find_symbol(uint32_t key) const {
+		auto it = std::upper_bound(m_symbols.begin(), m_symbols.end(), key,
+			[](uint32_t value, auto const& sym) {
+				return value < sym.first;
+			});
+
+		if (it == m_symbols.begin()) {
+			return nullptr;
+		}
+
+		--it;
+
+		//Symbols do not cross banks
+		if ((it->first >> 16) != (key >> 16)) {
+			return nullptr;
+		}
+
+		return &(*it);
+	}
+
+	std::string GuestProfiler::frame_name(uint32_t key, bool inside) const {
+		auto sym = find_symbol(key);
+
+		if (sym == nullptr) {
+			return fmt::format("{:02X}:{:04X}", key >> 16, key & 0xFFFF);
+		}
+
+		if (inside || sym->first == key) {
+			return sym->second;
+		}
+
+		return fmt::format("{}+{:X}", sym->second, key - sym->first);
+	}
+
+	std::string GuestProfiler::Symbolize(byte bank, word address) const {
+		std::scoped_lock lock(m_mutex);
+
+		uint32_t key = make_key(bank, address);
+		auto sym = find_symbol(key);
+
+		if (sym == nullptr) {
+			return fmt::format("{:02X}:{:04X}", bank, address);
+		}
+
+		if (sym->first == key) {
+			return sym->second;
+		}
+
+		return fmt::format("{}+{:X}", sym->second, key - sym->first);
+	}
+
+	void GuestProfiler::PrintTop(std::ostream& out, unsigned count) const {
+		std::vector<std::pair<uint32_t, uint64_t>> hits{};
+		uint64_t samples = 0;
+
+		{
+			std::scoped_lock lock(m_mutex);
+
+			hits.assign(m_hits.begin(), m_hits.end());
+			samples = m_samples;
+		}
+
+		std::sort(hits.begin(), hits.end(), [](auto const& a, auto const& b) {
+			return a.second > b.second || (a.second == b.second && a.first < b.first);
+		});
+
+		if (hits.size() > count) {
+			hits.resize(count);
+		}
+
+		out << fmt::format("{} samples, one every {} cycles\n\n",
+			samples, GetPeriod());
+
+		out << fmt::format("{:<8} {:>10} {:>7}  {}\n",
+			"Address", "Samples", "%", "Symbol");
+
+		for (auto const& [key, hit] : hits) {
+			out << fmt::format("{:02X}:{:04X} {:>10} {:>7.2f}  {}\n",
+				key >> 16, key & 0xFFFF, hit,
+				samples ? hit * 100.0 / samples : 0.0,
+				Symbolize((byte)(key >> 16), (word)(key & 0xFFFF)));
+		}
+	}
+
+	std::pair<bool, std::string> GuestProfiler::WriteFolded(std::string const& path) const {
+		std::ofstream file{ path };
+
+		if (!file) {
+			return std::pair(false, fmt::format("Cannot open {}", path));
+		}
+
+		//Different addresses can give the same
+		//names, merge them before writing
+		std::map<std::string, uint64_t> folded{};
+
+		{
+			std::scoped_lock lock(m_mutex);
+
+			for (auto const& [frames, count] : m_stacks) {
+				std::string line{};
+				std::string previous{};
+
+				//The root is a call site and the leaf the
+				//program counter, both are named after the
+				//function they are in, which may be the
+				//frame next to them
+				for (std::size_t i = 0; i < frames.size(); i++) {
+					bool inside = (i == 0 && frames.size() > 1) || i + 1 == frames.size();
+
+					std::string name = frame_name(frames[i], inside);
+
+					if (name == previous) {
+						continue;
+					}
+
+					if (!line.empty()) {
+						line += ';';
+					}
+
+					line += name;
+					previous = std::move(name);
+				}
+
+				folded[line] += count;
+			}
+		}
+
+		for (auto const& [line, count] : folded) {
+			file << line << ' ' << count << '\n';
+		}
+
+		if (!file) {
+			return std::pair(false, fmt::format("Cannot write {}", path));
+		}
+
+		return std::pair(true, "");
+	}
+}
@@ -0,0 +1,264 @@
+#include "../../include/debugger/Profiler.h"
+#include "../../include/cpu/Disasm.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace GameboyEmu::Debugger {
+	static int64_t steady_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count();
+	}
+
+	const char* ComponentName(Component component) {
+		switch (component) {
+		case Component::cpu_decode: return "cpu_decode";
+		case Component::cpu_execute: return "cpu_execute";
+		case Component::ppu_hblank: return "ppu_hblank";
+		case Component::ppu_vblank: return "ppu_vblank";
+		case Component::ppu_oam: return "ppu_oam";
+		case Component::ppu_transfer: return "ppu_transfer";
+		case Component::apu: return "apu";
+		case Component::timer: return "timer";
+		case Component::dma: return "dma";
+		case Component::serial: return "serial";
+		default: return "unknown";
+		}
+	}
+
+	const char* OpcodeName(unsigned id) {
+		if (id < 0x100) {
+			return CPU::normalInstructions::disasm[id];
+		}
+		else if (id < opcode_count) {
+			return CPU::cbInstructions::disasm[id - 0x100];
+		}
+
+		return "<INVALID>";
+	}
+
+	Profiler::Profiler() :
+		m_components{}, m_opcodes{}, m_nested(0),
+		m_probe_ticks(0), m_child_ticks(0),
+		m_enabled(false), m_start_ticks(0), m_start_time(0),
+		m_segment_start(0), m_enabled_ns(0) {
+		calibrate();
+		Reset();
+	}
+
+	void Profiler::calibrate() {
+		static constexpr unsigned batches = 64;
+		static constexpr unsigned scopes = 32;
+
+		uint64_t best_inside = std::numeric_limits<uint64_t>::max();
+		uint64_t best_outside = std::numeric_limits<uint64_t>::max();
+
+		m_enabled = true;
+
+		//The fastest batch is the one least
+		//disturbed by interrupts and migrations
+		for (unsigned batch = 0; batch < batches; batch++) {
+			uint64_t nested = m_nested;
+			uint64_t start = Now();
+
+			for (unsigned i = 0; i < scopes; i++) {
+				ProfileScope scope{ this, Component::cpu_decode };
+			}
+
+			uint64_t outside = (Now() - start) / scopes;
+			uint64_t inside = (m_nested - nested) / scopes;
+
+			best_inside = std::min(best_inside, inside);
+			best_outside = std::min(best_outside, outside);
+		}
+
+		m_enabled = false;
+		m_nested = 0;
+
+		m_probe_ticks = best_inside;
+		m_child_ticks = best_outside > best_inside ? best_outside - best_inside : 0;
+	}
+
+	double Profiler::ProbeOverheadNanoseconds() const {
+		return (double)(m_probe_ticks + m_child_ticks) / ticks_per_ns();
+	}
+
+	void Profiler::Enable(bool enable) {
+		bool was = m_enabled.exchange(enable);
+		int64_t now = steady_ns();
+
+		if (enable && !was) {
+			m_segment_start = now;
+		}
+		else if (!enable && was) {
+			m_enabled_ns += (uint64_t)(now - m_segment_start);
+		}
+	}
+
+	void Profiler::Reset() {
+		for (auto& counter : m_components) {
+			counter.ticks = 0;
+			counter.calls = 0;
+		}
+
+		for (auto& counter : m_opcodes) {
+			counter.ticks = 0;
+			counter.calls = 0;
+		}
+
+		m_start_ticks = Now();
+		m_start_time = steady_ns();
+
+		m_segment_start = m_start_time.load();
+		m_enabled_ns = 0;
+	}
+
+	double Profiler::ticks_per_ns() const {
+#ifdef LEARNBOY_HAS_RDTSC
+		uint64_t ticks = Now() - m_start_ticks;
+		int64_t ns = steady_ns() - m_start_time;
+
+		if (ns <= 0 || ticks == 0) {
+			return 1.0;
+		}
+
+		return (double)ticks / (double)ns;
+#else
+		return 1.0;
+#endif
+	}
+
+	ComponentStats Profiler::to_stats(Counter const& counter) const {
+		return ComponentStats{
+			(uint64_t)((double)counter.ticks.load(std::memory_order_relaxed) / ticks_per_ns()),
+			counter.calls.load(std::memory_order_relaxed)
+		};
+	}
+
+	ComponentStats Profiler::Get(Component component) const {
+		return to_stats(m_components[(std::size_t)component]);
+	}
+
+	ComponentStats Profiler::GetOpcode(unsigned id) const {
+		return to_stats(m_opcodes[id]);
+	}
+
+	uint64_t Profiler::ElapsedNanoseconds() const {
+		uint64_t res = m_enabled_ns;
+
+		if (Enabled()) {
+			res += (uint64_t)(steady_ns() - m_segment_start);
+		}
+
+		return res;
+	}
+
+	void Profiler::PrintTable(std::ostream& out, unsigned max_opcodes) const {
+		double elapsed = (double)ElapsedNanoseconds();
+
+		if (elapsed <= 0.0) {
+			elapsed = 1.0;
+		}
+
+		std::vector<std::pair<Component, ComponentStats>> components{};
+
+		for (std::size_t i = 0; i < component_count; i++) {
+			auto comp = (Component)i;
+			components.emplace_back(comp, Get(comp));
+		}
+
+		std::sort(components.begin(), components.end(), [](auto const& a, auto const& b) {
+			return a.second.nanoseconds > b.second.nanoseconds;
+		});
+
+		out << fmt::format("Profiled for {:.1f} ms, {:.1f} ns of probe overhead "
+			"subtracted per call\n\n", elapsed / 1e6, ProbeOverheadNanoseconds());
+		out << fmt::format("{:<14} {:>12} {:>7} {:>14} {:>10}\n",
+			"Component", "Time (ms)", "%", "Calls", "ns/call");
+
+		for (auto const& [comp, stats] : components) {
+			out << fmt::format("{:<14} {:>12.2f} {:>7.2f} {:>14} {:>10.1f}\n",
+				ComponentName(comp), stats.nanoseconds / 1e6,
+				stats.nanoseconds * 100.0 / elapsed, stats.calls,
+				stats.calls ? (double)stats.nanoseconds / stats.calls : 0.0);
+		}
+
+		if (max_opcodes == 0) {
+			return;
+		}
+
+		std::vector<std::pair<unsigned, ComponentStats>> opcodes{};
+
+		for (unsigned id = 0; id < opcode_count; id++) {
+			auto stats = GetOpcode(id);
+
+			if (stats.calls != 0) {
+				opcodes.emplace_back(id, stats);
+			}
+		}
+
+		std::sort(opcodes.begin(), opcodes.end(), [](auto const& a, auto const& b) {
+			return a.second.nanoseconds > b.second.nanoseconds;
+		});
+
+		if (opcodes.size() > max_opcodes) {
+			opcodes.resize(max_opcodes);
+		}
+
+		out << fmt::format("\n{:<8} {:<18} {:>12} {:>7} {:>14} {:>10}\n",
+			"Opcode", "Instruction", "Time (ms)", "%", "Calls", "ns/call");
+
+		for (auto const& [id, stats] : opcodes) {
+			std::string opcode = id < 0x100 ?
+				fmt::format("{:02X}", id) :
+				fmt::format("CB {:02X}", id - 0x100);
+
+			out << fmt::format("{:<8} {:<18} {:>12.2f} {:>7.2f} {:>14} {:>10.1f}\n",
+				opcode, OpcodeName(id), stats.nanoseconds / 1e6,
+				stats.nanoseconds * 100.0 / elapsed, stats.calls,
+				(double)stats.nanoseconds / stats.calls);
+		}
+	}
+
+	void Profiler::DumpJson(std::ostream& out) const {
+		out << "{\n";
+		out << fmt::format("  \"elapsed_ns\": {},\n", ElapsedNanoseconds());
+		out << fmt::format("  \"probe_overhead_ns\": {:.1f},\n", ProbeOverheadNanoseconds());
+		out << "  \"components\": [";
+
+		for (std::size_t i = 0; i < component_count; i++) {
+			auto comp = (Component)i;
+			auto stats = Get(comp);
+
+			out << (i == 0 ? "\n" : ",\n");
+			out << fmt::format("    {{ \"name\": \"{}\", \"nanoseconds\": {}, \"calls\": {} }}",
+				ComponentName(comp), stats.nanoseconds, stats.calls);
+		}
+
+		out << "\n  ],\n  \"opcodes\": [";
+
+		bool first = true;
+
+		for (unsigned id = 0; id < opcode_count; id++) {
+			auto stats = GetOpcode(id);
+
+			if (stats.calls == 0) {
+				continue;
+			}
+
+			out << (first ? "\n" : ",\n");
+			out << fmt::format("    {{ \"opcode\": {}, \"cb\": {}, \"name\": \"{}\", "
+				"\"nanoseconds\": {}, \"calls\": {} }}",
+				id & 0xFF, id >= 0x100, OpcodeName(id),
+				stats.nanoseconds, stats.calls);
+
+			first = false;
+		}
+
+		out << "\n  ]\n}\n";
+	}
+}
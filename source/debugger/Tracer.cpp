@@ -0,0 +1,287 @@
+#include "../../include/debugger/Tracer.h"
+#include "../../include/cpu/Disasm.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+namespace GameboyEmu::Debugger {
+	static constexpr char trace_magic[8] = { 'L', 'B', 'T', 'R', 'A', 'C', 'E', '\0' };
+	static constexpr uint32_t trace_version = 1;
+
+	//Records copied at once by the stream thread
+	static constexpr std::size_t stream_chunk = 4096;
+
+	Tracer::Tracer() :
+		m_ring(nullptr), m_mask(default_capacity - 1),
+		m_head(0), m_start(0), m_enabled(false),
+		m_stream_file(), m_stream_thread(), m_streaming(false),
+		m_stream_pos(0), m_stream_buffer(), m_dropped(0) {
+	}
+
+	Tracer::~Tracer() {
+		StopStream();
+
+		delete[] m_ring;
+	}
+
+	void Tracer::Enable(bool enable) {
+		//The ring is only allocated once tracing is used
+		if (enable && m_ring == nullptr) {
+			m_ring = new TraceRecord[GetCapacity()]();
+		}
+
+		m_enabled.store(enable, std::memory_order_release);
+	}
+
+	std::pair<bool, std::string> Tracer::SetCapacity(std::size_t records) {
+		if (Enabled() || Streaming()) {
+			return { false, "Stop tracing before changing the capacity" };
+		}
+
+		if (records == 0 || records > ((std::size_t)1 << 28)) {
+			return { false, fmt::format("Invalid capacity {}", records) };
+		}
+
+		std::size_t capacity = std::bit_ceil(records);
+
+		TraceRecord* ring = new TraceRecord[capacity]();
+
+		delete[] m_ring;
+
+		m_ring = ring;
+		m_mask = capacity - 1;
+
+		m_head = 0;
+		m_start = 0;
+
+		return { true, "" };
+	}
+
+	std::size_t Tracer::GetCapacity() const {
+		return m_mask + 1;
+	}
+
+	void Tracer::Clear() {
+		m_start = m_head.load();
+	}
+
+	uint64_t Tracer::Count() const {
+		return m_head.load() - m_start.load();
+	}
+
+	uint64_t Tracer::first_valid(uint64_t head) const {
+		//The writer may be overwriting the slot of head - capacity
+		return head > m_mask ? head - m_mask : 0;
+	}
+
+	uint64_t Tracer::copy(uint64_t from, uint64_t to, TraceRecord* out) const {
+		for (uint64_t i = from; i < to; i++) {
+			out[i - from] = m_ring[i & m_mask];
+		}
+
+		//The copies must be done before reading the head again
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		return std::max(from, first_valid(m_head.load(std::memory_order_relaxed)));
+	}
+
+	std::vector<TraceRecord> Tracer::Last(std::size_t count) const {
+		if (m_ring == nullptr) {
+			return {};
+		}
+
+		uint64_t head = m_head.load(std::memory_order_acquire);
+
+		uint64_t from = std::max(first_valid(head), m_start.load());
+
+		if (head - from > count) {
+			from = head - count;
+		}
+
+		std::vector<TraceRecord> records(head - from);
+
+		uint64_t valid = copy(from, head, records.data());
+
+		records.erase(records.begin(),
+			records.begin() + (std::ptrdiff_t)std::min<uint64_t>(valid - from, records.size()));
+
+		return records;
+	}
+
+	void Tracer::write_header(std::ostream& out) {
+		uint32_t size = sizeof(TraceRecord);
+
+		out.write(trace_magic, sizeof(trace_magic));
+		out.write((const char*)&trace_version, sizeof(trace_version));
+		out.write((const char*)&size, sizeof(size));
+	}
+
+	std::pair<bool, std::string> Tracer::Dump(std::string const& path) const {
+		std::ofstream file{ path, std::ios::binary };
+
+		if (!file) {
+			return { false, fmt::format("Cannot open {}", path) };
+		}
+
+		auto records = Last(GetCapacity());
+
+		write_header(file);
+
+		file.write((const char*)records.data(),
+			(std::streamsize)(records.size() * sizeof(TraceRecord)));
+
+		if (!file) {
+			return { false, fmt::format("Cannot write {}", path) };
+		}
+
+		return { true, "" };
+	}
+
+	std::pair<bool, std::string> Tracer::StartStream(std::string const& path) {
+		if (Streaming()) {
+			return { false, "Already streaming" };
+		}
+
+		m_stream_file.open(path, std::ios::binary | std::ios::trunc);
+
+		if (!m_stream_file) {
+			m_stream_file.clear();
+			return { false, fmt::format("Cannot open {}", path) };
+		}
+
+		write_header(m_stream_file);
+
+		m_stream_buffer.resize(stream_chunk);
+		m_stream_pos = m_head.load();
+		m_dropped = 0;
+
+		m_streaming = true;
+
+		m_stream_thread = std::thread([this]() {
+			stream_loop();
+		});
+
+		return { true, "" };
+	}
+
+	void Tracer::StopStream() {
+		if (!m_streaming.exchange(false)) {
+			return;
+		}
+
+		m_stream_thread.join();
+
+		m_stream_file.close();
+		m_stream_file.clear();
+	}
+
+	bool Tracer::Streaming() const {
+		return m_streaming.load();
+	}
+
+	uint64_t Tracer::Dropped() const {
+		return m_dropped.load();
+	}
+
+	void Tracer::stream_loop() {
+		using namespace std::chrono_literals;
+
+		while (m_streaming.load()) {
+			if (!stream_drain()) {
+				std::this_thread::sleep_for(2ms);
+			}
+		}
+
+		//Records written before the stop
+		while (stream_drain());
+
+		m_stream_file.flush();
+	}
+
+	bool Tracer::stream_drain() {
+		uint64_t head = m_head.load(std::memory_order_acquire);
+
+		if (head == m_stream_pos) {
+			return false;
+		}
+
+		uint64_t valid = first_valid(head);
+
+		if (m_stream_pos < valid) {
+			m_dropped += valid - m_stream_pos;
+			m_stream_pos = valid;
+		}
+
+		uint64_t to = std::min<uint64_t>(head, m_stream_pos + stream_chunk);
+
+		valid = copy(m_stream_pos, to, m_stream_buffer.data());
+
+		if (valid > m_stream_pos) {
+			m_dropped += std::min(valid, to) - m_stream_pos;
+		}
+
+		if (valid < to) {
+			m_stream_file.write((const char*)(m_stream_buffer.data() + (valid - m_stream_pos)),
+				(std::streamsize)((to - valid) * sizeof(TraceRecord)));
+		}
+
+		m_stream_pos = to;
+
+		return true;
+	}
+
+	std::pair<bool, std::string> Tracer::ReadFile(std::string const& path,
+		std::vector<TraceRecord>& records) {
+		std::ifstream file{ path, std::ios::binary };
+
+		if (!file) {
+			return { false, fmt::format("Cannot open {}", path) };
+		}
+
+		char magic[sizeof(trace_magic)] = {};
+		uint32_t version = 0, size = 0;
+
+		file.read(magic, sizeof(magic));
+		file.read((char*)&version, sizeof(version));
+		file.read((char*)&size, sizeof(size));
+
+		if (!file || std::memcmp(magic, trace_magic, sizeof(magic)) != 0) {
+			return { false, fmt::format("{} is not a trace", path) };
+		}
+
+		if (version != trace_version || size != sizeof(TraceRecord)) {
+			return { false, fmt::format("Unsupported trace version {}, record size {}",
+				version, size) };
+		}
+
+		auto start = file.tellg();
+		file.seekg(0, std::ios::end);
+
+		std::size_t count = (std::size_t)(file.tellg() - start) / sizeof(TraceRecord);
+
+		file.seekg(start);
+
+		records.resize(count);
+
+		file.read((char*)records.data(), (std::streamsize)(count * sizeof(TraceRecord)));
+
+		if (!file) {
+			return { false, fmt::format("Cannot read {}", path) };
+		}
+
+		return { true, "" };
+	}
+
+	std::string Tracer::Format(TraceRecord const& record) {
+		auto instruction = CPU::Disassemble(record.code, sizeof(record.code));
+
+		return fmt::format("{:>12} {:02X}:{:04X}  {:<26} "
+			"AF={:04X} BC={:04X} DE={:04X} HL={:04X} SP={:04X}",
+			record.cycle, record.bank, record.pc, instruction.first,
+			record.af, record.bc, record.de, record.hl, record.sp);
+	}
+}
@@ -0,0 +1,19 @@
+#include "../../include/frontend/SdlFrontend.h"
+
+#include "../../include/graphics/display/Display.h"
+#include "../../include/sound/output/SdlOutput.h"
+#include "../../include/datatransfer/out/UdpSerial.h"
+
+namespace GameboyEmu::Frontend {
+	Graphics::Screen* SdlFrontend::CreateScreen(Logger& log, std::function<void()> on_stop) {
+		return new Graphics::Display(log, on_stop);
+	}
+
+	Sound::OutputDevice* SdlFrontend::CreateAudio(Logger& log) {
+		return new Sound::SdlOutputDevice(log);
+	}
+
+	DataTransfer::SerialDevice* SdlFrontend::CreateSerial() {
+		return new DataTransfer::UdpSerial();
+	}
+}
@@ -11,7 +11,8 @@ namespace GameboyEmu::Graphics {
 		m_stop(), m_pixel_buffer(nullptr),
 		m_buffer_mutex(),
 		m_log(logger), m_joypad(nullptr), 
-		m_ctrl_c_fun(ctrl_c), m_ctrl_status(false) {
+		m_ctrl_c_fun(ctrl_c), m_ctrl_status(false),
+		m_rewind_held(false) {
 		m_pixel_buffer = new byte[buffer_size];
 
 		std::fill_n(m_pixel_buffer,
@@ -232,6 +233,10 @@ namespace GameboyEmu::Graphics {
 					m_ctrl_c_fun();
 			} break;
 
+			case SDLK_BACKSPACE: {
+				m_rewind_held.store(true);
+			} break;
+
 			default:
 				break;
 			}
@@ -279,6 +284,10 @@ namespace GameboyEmu::Graphics {
 				m_ctrl_status = false;
 			} break;
 
+			case SDLK_BACKSPACE: {
+				m_rewind_held.store(false);
+			} break;
+
 			default:
 				break;
 			}
@@ -318,4 +327,8 @@ namespace GameboyEmu::Graphics {
 	void Display::SetJoypad(Input::Joypad* joypad) {
 		m_joypad = joypad;
 	}
+
+	bool Display::RewindHeld() const {
+		return m_rewind_held.load();
+	}
 }
\ No newline at end of file
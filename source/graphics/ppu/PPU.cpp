@@ -3,23 +3,21 @@
 #include "../../../include/state/EmulatorState.h"
 #include "../../../include/graphics/ppu/PixelFifos.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace GameboyEmu::Graphics {
 
 	PPU::PPU(State::EmulatorState* state) :
 		m_state(state), m_mem(nullptr),
-		m_ctx(), m_objects(nullptr), m_current_object_fetch{},
-		m_fetch_count(0), m_encountered_objs(0),
-		m_oam_index(0), m_wy_trigger(0),
+		m_ctx(), m_objects{}, m_encountered_objs(0),
+		m_wy_trigger(0),
 		m_current_scanline_cycles(0), m_pipeline(nullptr),
-		m_frame(nullptr), m_pixel_index(0) {
-		m_objects = new oam_object[10];
-
+		m_frame{}, m_pixel_index(0) {
 		DisableLcd();
 
 		m_ctx.enable = 0x00;
 
-		m_frame = new byte[160 * 144];
-
 		m_window_line = 255;
 	}
 
@@ -35,6 +33,10 @@ namespace GameboyEmu::Graphics {
 		m_mem = mmu;
 
 		m_pipeline = new PixelPipeline(mmu, this);
+
+		//Set before the first line, a state can be
+		//captured as soon as the emulator is created
+		m_pipeline->SetSpritePtr(m_objects.data());
 	}
 
 	void PPU::stat_source(byte type) {
@@ -63,25 +65,14 @@ namespace GameboyEmu::Graphics {
 		}
 
 		if (doit) {
-			byte ir = m_mem->Read(0xFF0F);
-
-			LCDSTAT_BIT_SET(ir);
-
-			m_mem->Write(0xFF0F, ir);
+			m_mem->GetInterrupts().Raise(Mem::Interrupt::lcdstat);
 		}
 	}
 
 	void PPU::reset_oam_scan() {
-		std::fill_n(m_objects, 10, oam_object{});
-
-		m_current_object_fetch[0] = 0x00;
-		m_current_object_fetch[1] = 0x00;
-		m_current_object_fetch[2] = 0x00;
-		m_current_object_fetch[3] = 0x00;
+		m_objects.fill(oam_object{});
 
-		m_fetch_count = 0;
 		m_encountered_objs = 0;
-		m_oam_index = 0;
 
 		m_wy_trigger = 0;
 	}
@@ -157,25 +148,33 @@ namespace GameboyEmu::Graphics {
 			{
 			case 0x00: // HBLANK
 			{
-				tstates--;
-				m_current_scanline_cycles++;
+				word cycles = idle_cycles(tstates);
+
+				tstates -= cycles;
+				m_current_scanline_cycles += cycles;
 
 				mode_hblank();
 			} break;
 
 			case 0x01: // VBLANK
 			{
-				tstates--;
-				m_current_scanline_cycles++;
+				word cycles = idle_cycles(tstates);
+
+				tstates -= cycles;
+				m_current_scanline_cycles += cycles;
 
 				mode_vblank();
 			} break;
 
 			case 0x02: // OAM scan
 			{
-				mode_oam();
+				word cycles = m_current_scanline_cycles < 80 ?
+					std::min<word>(tstates, 80 - m_current_scanline_cycles) : 1;
 
-				tstates--;
+				tstates -= cycles;
+				m_current_scanline_cycles += cycles;
+
+				mode_oam();
 			} break;
 
 			case 0x03: // Pixel output
@@ -216,9 +215,39 @@ namespace GameboyEmu::Graphics {
 		}
 	}
 
+	word PPU::idle_cycles(word tstates) const {
+		//Nothing happens before the end of the line
+		if (m_current_scanline_cycles >= 456) {
+			return 1;
+		}
+
+		return std::min<word>(tstates, 456 - m_current_scanline_cycles);
+	}
+
+	unsigned PPU::CyclesToEvent() {
+		if (!m_ctx.enable) {
+			return std::numeric_limits<unsigned>::max();
+		}
+
+		switch (m_ctx.mode_flag)
+		{
+		case 0x00:
+		case 0x01:
+			return m_current_scanline_cycles < 456 ?
+				456 - m_current_scanline_cycles : 1;
+
+		case 0x02:
+			return m_current_scanline_cycles < 80 ?
+				80 - m_current_scanline_cycles : 1;
+
+		default:
+			//At most one pixel is output per cycle
+			return m_pipeline->GetX() < 160 ?
+				160 - m_pipeline->GetX() : 1;
+		}
+	}
+
 	PPU::~PPU() {
-		delete[] m_objects;
-		delete[] m_frame;
 		delete m_pipeline;
 	}
 
@@ -498,14 +527,12 @@ namespace GameboyEmu::Graphics {
 			offset += 11;
 		}
 
-		buffer[offset] = m_current_object_fetch[0];
-		buffer[offset + 1] = m_current_object_fetch[1];
-		buffer[offset + 2] = m_current_object_fetch[2];
-		buffer[offset + 3] = m_current_object_fetch[3];
+		//Were the state of the object fetch, the
+		//objects are now selected at once
+		std::fill_n(buffer + offset, 5, 0);
 
-		buffer[offset + 4] = m_fetch_count;
 		buffer[offset + 5] = m_encountered_objs;
-		buffer[offset + 6] = m_oam_index;
+		buffer[offset + 6] = 0;
 		buffer[offset + 7] = m_wy_trigger;
 		buffer[offset + 8] = m_window_line;
 
@@ -516,7 +543,7 @@ namespace GameboyEmu::Graphics {
 
 		offset += 15;
 
-		std::copy_n(m_frame, 160 * 144, buffer + offset);
+		std::copy_n(m_frame.begin(), 160 * 144, buffer + offset);
 
 		offset += (160 * 144);
 
@@ -525,7 +552,7 @@ namespace GameboyEmu::Graphics {
 		return offset;
 	}
 
-	std::size_t PPU::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t PPU::LoadState(const byte* buffer, std::size_t offset) {
 		m_ctx.enable = buffer[offset];
 		m_ctx.window_tile_map = buffer[offset + 1];
 		m_ctx.window_enable = buffer[offset + 2];
@@ -574,14 +601,7 @@ namespace GameboyEmu::Graphics {
 			offset += 11;
 		}
 
-		m_current_object_fetch[0] = buffer[offset];
-		m_current_object_fetch[1] = buffer[offset + 1];
-		m_current_object_fetch[2] = buffer[offset + 2];
-		m_current_object_fetch[3] = buffer[offset + 3];
-
-		m_fetch_count = buffer[offset + 4];
 		m_encountered_objs = buffer[offset + 5];
-		m_oam_index = buffer[offset + 6];
 		m_wy_trigger = buffer[offset + 7];
 		m_window_line = buffer[offset + 8];
 
@@ -592,11 +612,11 @@ namespace GameboyEmu::Graphics {
 
 		offset += 15;
 
-		std::copy_n(buffer + offset, 160 * 144, m_frame);
+		std::copy_n(buffer + offset, 160 * 144, m_frame.begin());
 
 		offset += (160 * 144);
 
-		m_pipeline->SetSpritePtr(m_objects);
+		m_pipeline->SetSpritePtr(m_objects.data());
 
 		offset = m_pipeline->LoadState(buffer, offset);
 
@@ -3,6 +3,8 @@
 #include "../../../include/state/EmulatorState.h"
 #include "../../../include/graphics/ppu/PixelFifos.h"
 
+#include <array>
+
 namespace GameboyEmu::Graphics {
 
 	void PPU::mode_hblank() {
@@ -16,13 +18,9 @@ namespace GameboyEmu::Graphics {
 
 				stat_source(0x02);
 
-				byte ir = m_mem->Read(0xFF0F);
-
-				VBLANK_BIT_SET(ir);
+				m_mem->GetInterrupts().Raise(Mem::Interrupt::vblank);
 
-				m_mem->Write(0xFF0F, ir);
-
-				m_state->ShowFrame(m_frame);
+				m_state->ShowFrame(m_frame.data());
 
 				m_pixel_index = 0;
 			}
@@ -83,63 +81,48 @@ namespace GameboyEmu::Graphics {
 		}
 	}
 
-	void PPU::mode_oam() {
-
-		if (m_encountered_objs < 10) {
-			m_current_object_fetch[m_fetch_count++]
-				= m_mem->ppu_read_oam(
-					0xFE00 + m_oam_index);
-			m_current_object_fetch[m_fetch_count++]
-				= m_mem->ppu_read_oam(
-					0xFE00 + m_oam_index + 1);
-
-			if (m_fetch_count == 4) {
-				m_fetch_count = 0;
-
-				byte y = m_current_object_fetch[0];
-				byte x = m_current_object_fetch[1];
-				byte tile_index = m_current_object_fetch[2];
-				byte attributes = m_current_object_fetch[3];
-
-				short real_y = y - 16;
-				byte h = m_ctx.obj_size ? 16 : 8;
-
-
-				if (real_y <= (short)m_ctx.lcd_y && real_y + h > (short)m_ctx.lcd_y) {
-					//found object
-					m_objects[m_encountered_objs].y_pos = real_y;
-					m_objects[m_encountered_objs].x_pos = x - 8;
-					m_objects[m_encountered_objs].tile_index_1 = tile_index;
-					m_objects[m_encountered_objs].oam_index = m_oam_index - 4;
-					m_objects[m_encountered_objs].bg_w_over_obj =
-						GET_BIT(attributes, 7);
-					m_objects[m_encountered_objs].y_flip =
-						GET_BIT(attributes, 6);
-					m_objects[m_encountered_objs].x_flip =
-						GET_BIT(attributes, 5);
-					m_objects[m_encountered_objs].palette_num =
-						GET_BIT(attributes, 4);
-					m_objects[m_encountered_objs].size = h;
-
-					m_encountered_objs++;
-				}
-
-				//encountered_objs++;
-			}
-		}
-		else {
-			bool here = true;
+	void PPU::select_objects() {
+		std::array<byte, Mem::OamIndex::max_objects> found;
+
+		m_encountered_objs = m_mem->GetOamIndex().Lookup(
+			m_ctx.lcd_y, m_ctx.obj_size, found);
+
+		byte h = m_ctx.obj_size ? 16 : 8;
+
+		for (byte i = 0; i < m_encountered_objs; i++) {
+			word address = 0xFE00 + found[i] * 4;
+
+			byte y = m_mem->ppu_read_oam(address);
+			byte x = m_mem->ppu_read_oam(address + 1);
+			byte tile_index = m_mem->ppu_read_oam(address + 2);
+			byte attributes = m_mem->ppu_read_oam(address + 3);
+
+			m_objects[i].y_pos = y - 16;
+			m_objects[i].x_pos = x - 8;
+			m_objects[i].tile_index_1 = tile_index;
+			m_objects[i].oam_index = found[i] * 4;
+			m_objects[i].bg_w_over_obj =
+				GET_BIT(attributes, 7);
+			m_objects[i].y_flip =
+				GET_BIT(attributes, 6);
+			m_objects[i].x_flip =
+				GET_BIT(attributes, 5);
+			m_objects[i].palette_num =
+				GET_BIT(attributes, 4);
+			m_objects[i].size = h;
 		}
+	}
 
-		m_oam_index += 2;
-
-		m_current_scanline_cycles++;
-
+	void PPU::mode_oam() {
+		//The scan still takes 80 cycles, but
+		//the objects come from the OAM index
 		if (m_current_scanline_cycles >= 80) {
+			select_objects();
+
 			m_ctx.mode_flag = 0x03;
 			m_pipeline->Reset(
 				m_ctx.lcd_y, m_wy_trigger, m_window_line,
-				m_objects, m_encountered_objs
+				m_objects.data(), m_encountered_objs
 			);
 		}
 	}
@@ -624,7 +624,7 @@ namespace GameboyEmu::Graphics {
 		return offset + 4;
 	}
 
-	std::size_t PixelPipeline::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t PixelPipeline::LoadState(const byte* buffer, std::size_t offset) {
 		m_fifo.len = ReadWord(buffer, offset);
 		m_fifo.first = ReadWord(buffer, offset + 2);
 		m_fifo.last = ReadWord(buffer, offset + 4);
@@ -0,0 +1,270 @@
+#include "../../include/host/EmulatorHost.h"
+#include "../../include/state/EmulatorState.h"
+
+namespace GameboyEmu::Host {
+	EmulatorHost::EmulatorHost(Logger& log, unsigned threads) :
+		m_logger(log), m_instances(), m_instance_count(0),
+		m_workers(), m_run_mutex(), m_start_cv(), m_done_cv(),
+		m_generation(0), m_stop(false), m_remaining(0),
+		m_active_workers(0), m_task_mutex(), m_task_cv(),
+		m_task_events(0), m_waiting(0), m_callback() {
+		if (threads == 0) {
+			threads = std::thread::hardware_concurrency();
+		}
+
+		if (threads == 0) {
+			threads = 1;
+		}
+
+		for (unsigned index = 0; index < threads; index++) {
+			m_workers.push_back(std::make_unique<Worker>());
+		}
+
+		for (unsigned index = 0; index < threads; index++) {
+			m_workers[index]->thread = std::thread([this, index]() {
+				this->worker_loop(index);
+			});
+		}
+	}
+
+	std::pair<EmulatorHost::instance_id, std::string> EmulatorHost::AddInstance(std::string const& rom) {
+		State::EmulatorState* emu = new State::EmulatorState(rom, m_logger, nullptr);
+
+		if (!emu->Ok()) {
+			std::string message = emu->GetMessage();
+
+			delete emu;
+
+			return std::pair(invalid_instance, message);
+		}
+
+		//Removed slots are reused
+		for (instance_id id = 0; id < m_instances.size(); id++) {
+			if (m_instances[id] == nullptr) {
+				m_instances[id] = emu;
+				m_instance_count++;
+
+				return std::pair(id, "");
+			}
+		}
+
+		m_instances.push_back(emu);
+		m_instance_count++;
+
+		return std::pair(m_instances.size() - 1, "");
+	}
+
+	void EmulatorHost::RemoveInstance(instance_id id) {
+		if (id >= m_instances.size() || m_instances[id] == nullptr)
+			return;
+
+		delete m_instances[id];
+
+		m_instances[id] = nullptr;
+		m_instance_count--;
+	}
+
+	State::EmulatorState* EmulatorHost::GetInstance(instance_id id) {
+		if (id >= m_instances.size())
+			return nullptr;
+
+		return m_instances[id];
+	}
+
+	std::size_t EmulatorHost::InstanceCount() const {
+		return m_instance_count;
+	}
+
+	unsigned EmulatorHost::ThreadCount() const {
+		return (unsigned)m_workers.size();
+	}
+
+	void EmulatorHost::RunFrames(unsigned frames, frame_callback callback) {
+		if (frames == 0 || m_instance_count == 0)
+			return;
+
+		//Instances are spread evenly, the
+		//stealing takes care of the rest
+		unsigned worker = 0;
+
+		for (instance_id id = 0; id < m_instances.size(); id++) {
+			if (m_instances[id] == nullptr)
+				continue;
+
+			push_task(worker, Task{ id, frames });
+
+			worker = (worker + 1) % m_workers.size();
+		}
+
+		std::unique_lock<std::mutex> lock(m_run_mutex);
+
+		m_callback = std::move(callback);
+		m_remaining = m_instance_count;
+		m_active_workers = (unsigned)m_workers.size();
+		m_generation++;
+
+		m_start_cv.notify_all();
+
+		//Waits for every worker, not only for
+		//the tasks, so none of them is still
+		//looking at the queues of this run
+		m_done_cv.wait(lock, [this]() {
+			return m_active_workers == 0;
+		});
+
+		m_callback = nullptr;
+	}
+
+	void EmulatorHost::worker_loop(unsigned index) {
+		uint64_t generation = 0;
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_run_mutex);
+
+				m_start_cv.wait(lock, [this, generation]() {
+					return m_stop || m_generation != generation;
+				});
+
+				if (m_stop)
+					return;
+
+				generation = m_generation;
+			}
+
+			run_tasks(index);
+
+			std::scoped_lock<std::mutex> lock(m_run_mutex);
+
+			m_active_workers--;
+
+			if (m_active_workers == 0) {
+				m_done_cv.notify_all();
+			}
+		}
+	}
+
+	void EmulatorHost::run_tasks(unsigned index) {
+		Task task{};
+
+		while (m_remaining.load() != 0) {
+			uint64_t seen = m_task_events.load();
+
+			if (!pop_task(index, task) && !steal_task(index, task)) {
+				//The last tasks are running
+				//on other workers
+				wait_task(seen);
+				continue;
+			}
+
+			State::EmulatorState* emu = m_instances[task.id];
+
+			emu->RunFrame();
+
+			if (m_callback) {
+				m_callback(task.id, emu);
+			}
+
+			task.frames_left--;
+
+			if (task.frames_left != 0) {
+				push_task(index, task);
+			}
+			else {
+				m_remaining--;
+			}
+
+			signal_task();
+		}
+	}
+
+	void EmulatorHost::signal_task() {
+		m_task_events++;
+
+		//Both counters are sequentially consistent, either
+		//the waiter sees the event or this sees the waiter
+		if (m_waiting.load() == 0)
+			return;
+
+		std::scoped_lock<std::mutex> lock(m_task_mutex);
+
+		m_task_cv.notify_all();
+	}
+
+	void EmulatorHost::wait_task(uint64_t seen) {
+		std::unique_lock<std::mutex> lock(m_task_mutex);
+
+		m_waiting++;
+
+		m_task_cv.wait(lock, [this, seen]() {
+			return m_task_events.load() != seen || m_remaining.load() == 0;
+		});
+
+		m_waiting--;
+	}
+
+	bool EmulatorHost::pop_task(unsigned index, Task& task) {
+		Worker& worker = *m_workers[index];
+
+		std::scoped_lock<std::mutex> lock(worker.mutex);
+
+		if (worker.tasks.empty())
+			return false;
+
+		//Round robin between the own instances
+		task = worker.tasks.front();
+		worker.tasks.pop_front();
+
+		return true;
+	}
+
+	bool EmulatorHost::steal_task(unsigned index, Task& task) {
+		std::size_t count = m_workers.size();
+
+		for (std::size_t offset = 1; offset < count; offset++) {
+			Worker& victim = *m_workers[(index + offset) % count];
+
+			std::scoped_lock<std::mutex> lock(victim.mutex);
+
+			if (victim.tasks.empty())
+				continue;
+
+			//The owner takes from the front, stealing
+			//from the back keeps the contention low
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void EmulatorHost::push_task(unsigned index, Task const& task) {
+		Worker& worker = *m_workers[index];
+
+		std::scoped_lock<std::mutex> lock(worker.mutex);
+
+		worker.tasks.push_back(task);
+	}
+
+	EmulatorHost::~EmulatorHost() {
+		{
+			std::scoped_lock<std::mutex> lock(m_run_mutex);
+
+			m_stop = true;
+		}
+
+		m_start_cv.notify_all();
+
+		for (auto& worker : m_workers) {
+			if (worker->thread.joinable()) {
+				worker->thread.join();
+			}
+		}
+
+		for (auto emu : m_instances) {
+			delete emu;
+		}
+	}
+}
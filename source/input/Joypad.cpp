@@ -3,195 +3,141 @@
 #include "../../include/memory/Memory.h"
 
 namespace GameboyEmu::Input {
-	Joypad::Joypad() : m_mutex(),
-		m_ctx{}, m_mem(nullptr) {
-		m_ctx.m_select_actions = 1;
-		m_ctx.m_select_direction = 1;
-
-		m_ctx.m_status[0][0] = 0x1;
-		m_ctx.m_status[0][1] = 0x1;
-		m_ctx.m_status[0][2] = 0x1;
-		m_ctx.m_status[0][3] = 0x1;
-
-		m_ctx.m_status[1][0] = 0x1;
-		m_ctx.m_status[1][1] = 0x1;
-		m_ctx.m_status[1][2] = 0x1;
-		m_ctx.m_status[1][3] = 0x1;
-	}
+	Joypad::Joypad() : m_buttons(0xFF), m_edges(0),
+		m_host(0xFF), m_latched(false),
+		m_select_actions(1), m_select_direction(1),
+		m_mem(nullptr) {}
 
 	void Joypad::Write(byte val) {
-		byte action = GET_BIT(val, 5);
-		byte direction = GET_BIT(val, 4);
-
-		std::scoped_lock<std::mutex> lk(m_mutex);
-
-		m_ctx.m_select_actions = action;
-		m_ctx.m_select_direction = direction;
+		m_select_actions = GET_BIT(val, 5);
+		m_select_direction = GET_BIT(val, 4);
 	}
 
 	byte Joypad::Read() {
-		std::scoped_lock<std::mutex> lk(m_mutex);
-
-		byte* correct_table = nullptr;
-
-		if (m_ctx.m_select_actions
-			&& m_ctx.m_select_direction) {
+		if (m_select_actions
+			&& m_select_direction) {
 			return 0xFF;
 		}
 
+		byte buttons = m_buttons.load(std::memory_order_relaxed);
+
 		//actions (Start, ...) are in the
-		//first table
-		if (!m_ctx.m_select_actions) {
-			correct_table = m_ctx.m_status[0];
+		//low nibble, the directions win
+		//when both are selected
+		byte lines = !m_select_direction ?
+			(buttons >> 4) : (buttons & 0xF);
+
+		return (m_select_actions << 5) |
+			(m_select_direction << 4) | lines;
+	}
+
+	void Joypad::SetLatched(bool latched) {
+		m_latched.store(latched, std::memory_order_relaxed);
+
+		if (latched) {
+			//Starts released, whatever the frontend
+			//pressed before, like a fresh joypad
+			m_buttons.store(0xFF, std::memory_order_relaxed);
+			m_edges.store(0, std::memory_order_relaxed);
 		}
+		else {
+			Latch(HostPressed());
+		}
+	}
 
-		if(!m_ctx.m_select_direction) {
-			correct_table = m_ctx.m_status[1];
-		} 
+	void Joypad::Latch(byte pressed) {
+		byte buttons = (byte)~pressed;
+		byte was = m_buttons.exchange(buttons, std::memory_order_relaxed);
 
-		byte ret = 0;
+		//Released before, high to low
+		byte edges = was & pressed;
 
-		ret |= (m_ctx.m_select_actions << 5);
-		ret |= (m_ctx.m_select_direction << 4);
+		if (edges) {
+			m_edges.fetch_or(edges, std::memory_order_release);
+		}
+	}
 
-		ret |= (correct_table[3] << 3);
-		ret |= (correct_table[2] << 2);
-		ret |= (correct_table[1] << 1);
-		ret |= correct_table[0];
-		
-		return ret;
+	void Joypad::Update() {
+		if (m_edges.exchange(0, std::memory_order_acquire) != 0) {
+			RequestInterrupt();
+		}
 	}
 
 	void Joypad::RequestInterrupt() {
-		byte ir = m_mem->Read(0xFF0F);
-
-		JOYPAD_BIT_SET(ir);
-
-		m_mem->Write(0xFF0F, ir);
+		m_mem->GetInterrupts().Raise(Mem::Interrupt::joypad);
 	}
 
 	void Joypad::SetMemory(Mem::Memory* mem) {
 		m_mem = mem;
 	}
 
-#define LOCK std::scoped_lock<std::mutex> lk(m_mutex);
-
-
 	/// ////
 
 	void Joypad::SetStart() {
-		LOCK;
-
-		m_ctx.m_status[0][3] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::start);
 	}
 
 	void Joypad::UnsetStart() {
-		LOCK;
-
-		m_ctx.m_status[0][3] = 0x1;
+		Release(Button::start);
 	}
 
 	void Joypad::SetSelect() {
-		LOCK;
-
-		m_ctx.m_status[0][2] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::select);
 	}
 
 	void Joypad::UnsetSelect() {
-		LOCK;
-
-		m_ctx.m_status[0][2] = 0x1;
+		Release(Button::select);
 	}
 
 	void Joypad::SetB() {
-		LOCK;
-
-		m_ctx.m_status[0][1] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::b);
 	}
 
 	void Joypad::UnsetB() {
-		LOCK;
-
-		m_ctx.m_status[0][1] = 0x1;
+		Release(Button::b);
 	}
 
 	void Joypad::SetA() {
-		LOCK;
-
-		m_ctx.m_status[0][0] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::a);
 	}
 
 	void Joypad::UnsetA() {
-		LOCK;
-
-		m_ctx.m_status[0][0] = 0x1;
+		Release(Button::a);
 	}
 
 	/// ////
 
 	void Joypad::SetDown() {
-		LOCK;
-
-		m_ctx.m_status[1][3] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::down);
 	}
 
 	void Joypad::UnsetDown() {
-		LOCK;
-
-		m_ctx.m_status[1][3] = 0x1;
+		Release(Button::down);
 	}
 
 	void Joypad::SetUp() {
-		LOCK;
-
-		m_ctx.m_status[1][2] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::up);
 	}
 
 	void Joypad::UnsetUp() {
-		LOCK;
-
-		m_ctx.m_status[1][2] = 0x1;
+		Release(Button::up);
 	}
 
 	void Joypad::SetLeft() {
-		LOCK;
-
-		m_ctx.m_status[1][1] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::left);
 	}
 
 	void Joypad::UnsetLeft() {
-		LOCK;
-
-		m_ctx.m_status[1][1] = 0x1;
+		Release(Button::left);
 	}
 
 	void Joypad::SetRight() {
-		LOCK;
-
-		m_ctx.m_status[1][0] = 0x0;
-
-		RequestInterrupt();
+		Press(Button::right);
 	}
 
 	void Joypad::UnsetRight() {
-		LOCK;
-
-		m_ctx.m_status[1][0] = 0x1;
+		Release(Button::right);
 	}
 
 	/// ////
-}
\ No newline at end of file
+}
@@ -1 +1,147 @@
-#include "../../include/logging/Logger.h"
\ No newline at end of file
+#include "../../include/logging/Logger.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+	int64_t clock_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count();
+	}
+}
+
+LogQueue::LogQueue() : m_cells(nullptr), m_enqueue(0), m_dequeue(0) {
+	m_cells = new Cell[capacity];
+
+	for (std::size_t i = 0; i < capacity; i++) {
+		m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+LogQueue::~LogQueue() {
+	delete[] m_cells;
+}
+
+bool LogRateLimiter::Allow() {
+	uint32_t count = m_count.fetch_add(1, std::memory_order_relaxed);
+
+	//The first message opens the window
+	if (count == 0) {
+		m_window.store(clock_ns(), std::memory_order_relaxed);
+		return true;
+	}
+
+	if (count < max_burst) {
+		return true;
+	}
+
+	//Then the clock is only read once the burst is used
+	int64_t now = clock_ns();
+	int64_t start = m_window.load(std::memory_order_relaxed);
+
+	if (now - start >= window_ns &&
+		m_window.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+		m_count.store(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+	return false;
+}
+
+Logger::Logger() : m_queue(), m_lost(0), m_reported_lost(0),
+	m_written(0), m_output_mutex(), m_file(), m_running(true),
+	m_thread() {
+	m_thread = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+	m_running.store(false, std::memory_order_release);
+
+	m_thread.join();
+}
+
+std::pair<bool, std::string> Logger::set_file(std::string const& path) {
+	flush();
+
+	std::lock_guard lock(m_output_mutex);
+
+	m_file.open(path, std::ios::out | std::ios::app);
+
+	if (!m_file.is_open()) {
+		return { false, "Cannot open the log file " + path };
+	}
+
+	return { true, "" };
+}
+
+void Logger::write(LogRecord const& record) {
+	std::ostream& out = m_file.is_open() ? (std::ostream&)m_file : std::cout;
+
+	out.write(record.text, record.size);
+
+	if (record.truncated) {
+		out << "...\n";
+	}
+
+	if (record.dropped != 0) {
+		out << "  (" << record.dropped << " more from the same line were dropped)\n";
+	}
+}
+
+void Logger::drain() {
+	std::lock_guard lock(m_output_mutex);
+
+	std::size_t count = 0;
+
+	while (const LogRecord* record = m_queue.Front()) {
+		write(*record);
+
+		m_queue.Pop();
+
+		count++;
+	}
+
+	uint64_t lost = m_lost.load(std::memory_order_relaxed);
+
+	if (lost != m_reported_lost) {
+		std::ostream& out = m_file.is_open() ? (std::ostream&)m_file : std::cout;
+
+		out << lost - m_reported_lost << " log messages lost, the queue was full\n";
+
+		m_reported_lost = lost;
+	}
+
+	if (count != 0) {
+		(m_file.is_open() ? (std::ostream&)m_file : std::cout).flush();
+
+		m_written.fetch_add(count, std::memory_order_release);
+	}
+}
+
+void Logger::run() {
+	while (m_running.load(std::memory_order_acquire)) {
+		drain();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	//Messages logged before the destruction
+	drain();
+}
+
+void Logger::flush() {
+	std::size_t target = m_queue.Claimed();
+
+	//Every claimed record is published right
+	//after its formatting, the thread catches up
+	while (m_written.load(std::memory_order_acquire) < target) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+uint64_t Logger::lost() const {
+	return m_lost.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,25 @@
+#include "../../include/memory/InterruptController.h"
+
+namespace GameboyEmu {
+	namespace Mem {
+		InterruptController::InterruptController() :
+			m_enable(0x00), m_flag(0x00)
+		{}
+
+		byte InterruptController::GetIF() const {
+			return m_flag.load();
+		}
+
+		void InterruptController::SetIF(byte value) {
+			m_flag.store(value);
+		}
+
+		byte InterruptController::GetIE() const {
+			return m_enable;
+		}
+
+		void InterruptController::SetIE(byte value) {
+			m_enable = value;
+		}
+	}
+}
@@ -6,9 +6,11 @@
 #include "../../include/input/Joypad.h"
 #include "../../include/sound/apu/APU.h"
 #include "../../include/datatransfer/Serial.h"
+#include "../../include/memory/RomImage.h"
+
+#include <algorithm>
+#include <limits>
 
-#include <fstream>
-#include <filesystem>
 
 namespace GameboyEmu {
 	namespace Mem {
@@ -17,18 +19,17 @@ namespace GameboyEmu {
 		//This constructor sucks
 		Memory::Memory(State::EmulatorState* ctx, Cartridge::MemoryCard* card, Graphics::PPU* pp, Timing::Timer* tim, Input::Joypad* joypad, Sound::APU* apu, DataTransfer::Serial* serial)
 			: m_state(ctx), m_cartridge(card), m_ppu(pp), m_timer(tim), m_joypad(joypad), m_apu(apu), m_serial(serial),
-			m_bootROMEnabled(false), m_wram(nullptr),
-			m_hram(nullptr), m_vram(nullptr), m_oam(nullptr), 
-			m_interrupt_enable(0x00), m_interrupt_flag(0x00),
-			m_dma(), m_bootrom(nullptr) {
-			m_wram = new byte[8 * 1024];
-			m_hram = new byte[0xFFFF - 0xFF80];
-			m_vram = new byte[8 * 1024];
-			m_oam = new byte[0xFE9F - 0xFE00 + 1];
+			m_bootROMEnabled(false), m_wram{},
+			m_hram{}, m_vram{}, m_oam{}, m_oam_index(),
+			m_interrupts(),
+			m_dma(), m_bootrom_image(nullptr), m_bootrom(nullptr),
+			m_page_flags{}, m_watch_read_bits{}, m_watch_write_bits{},
+			m_watch_hit{}, m_in_watch(false), m_watching(false) {
+			m_oam.fill(0xFF);
 
-			std::fill_n(m_oam, 0xFE9F - 0xFE00 + 1, 0xFF);
+			m_oam_index.Rebuild(m_oam.data());
 
-			std::fill_n(m_vram, 8 * 1024, 0x00);
+			reset_dma();
 
 			m_bootROMEnabled = false;
 		}
@@ -50,39 +51,26 @@ namespace GameboyEmu {
 		}
 
 		void Memory::ReadBootrom(std::string const& path) {
-			if (!std::filesystem::exists(path)) {
-				LOG_ERR(m_state->GetLogger(), "Fatal: invalid boot rom\n");
-				std::exit(0);
-			}
+			auto image_or_error = RomImage::Open(path);
 
-			if (!std::filesystem::is_regular_file(path)) {
-				LOG_ERR(m_state->GetLogger(), "Invalid boot rom\n");
+			if (image_or_error.first == nullptr) {
+				LOG_ERR(m_state->GetLogger(), "Fatal: invalid boot rom, {2}\n",
+					image_or_error.second);
+				m_state->GetLogger().flush();
 				std::exit(0);
 			}
 
-			//open file in read binary mode
-			std::ifstream file(path, std::ios::in | std::ios::binary);
-
-			//file is not readable 
-			if (!file.good())
+			if (image_or_error.first->Size() < StaticData::dmg_bootrom_size) {
+				LOG_ERR(m_state->GetLogger(), "Fatal: boot rom is too small\n");
+				delete image_or_error.first;
+				m_state->GetLogger().flush();
 				std::exit(0);
+			}
 
-			//set position at the end of the file and read the index value
-			file.seekg(0, std::ios::end);
-
-			std::streampos sz = file.tellg();
-
-			//reset the position
-			file.seekg(0, std::ios::beg);
-			////////////////////////
-
-			//allocate buffer
-			byte* data = new byte[sz];
-
-			//copy all the file into memory
-			file.read((char*)data, sz);
+			delete m_bootrom_image;
 
-			m_bootrom = data;
+			m_bootrom_image = image_or_error.first;
+			m_bootrom = m_bootrom_image->Data();
 
 			m_bootROMEnabled = true;
 		}
@@ -93,36 +81,113 @@ namespace GameboyEmu {
 			m_dma.current_oam_index = 0;
 			m_dma.source_base = 0x00;
 			m_dma.cycle_count = 0;
+			m_dma.start = 0;
+			m_dma.end = std::numeric_limits<uint64_t>::max();
 		}
 
-		void Memory::DmaAdvance(byte cycles) {
-			if (!m_dma.running)
-				return;
+		void Memory::start_dma() {
+			word source = m_dma.source_base;
 
-			bool end = false;
+			//0xE000 - 0xFFFF are mirrors of the WRAM
+			if (source >= 0xE000) {
+				source -= 0x2000;
+			}
 
-			cycles *= 4;
+			if (source >= 0xC000) {
+				std::copy_n(m_wram.begin() + (source - 0xC000), 0xA0, m_dma.data.begin());
+			}
+			else if (source >= 0x8000 && source < 0xA000) {
+				std::copy_n(m_vram.begin() + (source - 0x8000), 0xA0, m_dma.data.begin());
+			}
+			else {
+				//ROM and external RAM, through the cartridge
+				for (byte i = 0; i < 0xA0; i++) {
+					m_dma.data[i] = read_bus(source + i);
+				}
+			}
 
-			while (cycles > 0 && !end) {
-				byte val = Read(m_dma.source_base +
-					m_dma.current_index);
+			m_dma.running = true;
 
-				m_oam[m_dma.current_oam_index] = val;
+			m_dma.end = (uint64_t)(m_dma.start + 0xA0 * 4);
 
-				cycles--;
+			dma_flag_pages(true);
+		}
 
-				m_dma.current_index++;
-				m_dma.current_oam_index++;
+		void Memory::dma_commit(uint64_t time) {
+			//Byte i is copied during the M-cycle i
+			int64_t elapsed = (int64_t)time - m_dma.start;
 
-				if (m_dma.current_index == 0xA0)
-					end = true;
+			uint64_t count = elapsed <= 0 ? 0 :
+				std::min<uint64_t>((uint64_t)elapsed / 4, 0xA0);
+
+			while (m_dma.current_index < count) {
+				byte index = m_dma.current_index++;
+
+				m_oam[index] = m_dma.data[index];
+				m_oam_index.Write(index, m_dma.data[index]);
 			}
 
-			if (end) {
-				reset_dma();
+			m_dma.current_oam_index = m_dma.current_index;
+		}
+
+		void Memory::DmaFinish() {
+			dma_commit(m_dma.end);
+
+			dma_flag_pages(false);
+
+			reset_dma();
+		}
+
+		void Memory::dma_flag_pages(bool set) {
+			//OAM, and the bus of the source : VRAM or
+			//the external bus (ROM, external RAM, WRAM)
+			auto flag = [&](unsigned first, unsigned last) {
+				for (unsigned page = first; page <= last; page++) {
+					if (set) {
+						m_page_flags[page] |= dma_bus;
+					}
+					else {
+						m_page_flags[page] &= ~dma_bus;
+					}
+				}
+			};
+
+			flag(0xFE, 0xFE);
+
+			if (m_dma.source_base >= 0x8000 && m_dma.source_base < 0xA000) {
+				flag(0x80, 0x9F);
+			}
+			else {
+				flag(0x00, 0x7F);
+				flag(0xA0, 0xFD);
 			}
 		}
 
+		byte Memory::dma_read(word address) const {
+			int64_t elapsed = (int64_t)m_state->GetCycleCount() - m_dma.start;
+
+			if (elapsed < 0) {
+				return read_bus(address);
+			}
+
+			if (address >= 0xFE00) {
+				return 0xFF;
+			}
+
+			//The cpu reads the byte being transferred
+			uint64_t index = std::min<uint64_t>((uint64_t)elapsed / 4, 0x9F);
+
+			return m_dma.data[index];
+		}
+
+		OamIndex const& Memory::GetOamIndex() {
+			if (m_dma.running) {
+				dma_commit(m_state->GetCycleCount());
+			}
+
+			return m_oam_index;
+		}
+
 		byte Memory::ppu_read_vram(word address) const {
 			return m_vram[address - 0x8000];
 		}
@@ -134,12 +199,111 @@ namespace GameboyEmu {
 			return m_oam[address - 0xFE00];
 		}
 
+		void Memory::UpdateWatchpoints(std::map<word, Debugger::Watchpoint> const& watchpoints, bool enabled) {
+			//The flags of the DMA stay
+			for (auto& flags : m_page_flags) {
+				flags &= dma_bus;
+			}
+
+			m_watch_read_bits.fill(0);
+			m_watch_write_bits.fill(0);
+
+			m_watching = false;
+
+			if (!enabled) {
+				return;
+			}
+
+			for (auto const& [address, watch] : watchpoints) {
+				if (!watch.enabled) {
+					continue;
+				}
+
+				m_watching = true;
+
+				uint64_t bit = 1ull << (address & 63);
+
+				if (watch.type != Debugger::WatchType::write) {
+					m_page_flags[address >> 8] |= watch_read;
+					m_watch_read_bits[address >> 6] |= bit;
+				}
+
+				if (watch.type != Debugger::WatchType::read) {
+					m_page_flags[address >> 8] |= watch_write;
+					m_watch_write_bits[address >> 6] |= bit;
+				}
+			}
+		}
+
+		Debugger::WatchHit const& Memory::LastWatchHit() const {
+			return m_watch_hit;
+		}
+
+		void Memory::watch_access(word address, byte value, bool write) const {
+			auto const& bits = write ? m_watch_write_bits : m_watch_read_bits;
+
+			if (!(bits[address >> 6] & (1ull << (address & 63))) || m_in_watch) {
+				return;
+			}
+
+			auto const& watchpoints = m_state->GetWatchpoints();
+			auto it = watchpoints.find(address);
+
+			if (it == watchpoints.end()) {
+				return;
+			}
+
+			auto const& watch = it->second;
+
+			if (watch.conditional && watch.value != value) {
+				return;
+			}
+
+			m_watch_hit = Debugger::WatchHit{ address, value, write };
+
+			if (watch.callback) {
+				m_in_watch = true;
+				watch.callback(m_state);
+				m_in_watch = false;
+			}
+
+			//The instruction completes, the debugger
+			//stops before the next one
+			if (m_state->IsDebugging()) {
+				m_state->Break(true);
+			}
+		}
+
+		byte Memory::Read(word address) const {
+			byte value = read_bus(address);
+
+			if (byte flags = m_page_flags[address >> 8]) [[unlikely]] {
+				if (flags & dma_bus) {
+					value = dma_read(address);
+				}
+
+				if (flags & watch_read) {
+					watch_access(address, value, false);
+				}
+			}
+
+			return value;
+		}
+
+		byte Memory::Peek(word address) const {
+			if (m_page_flags[address >> 8] & dma_bus) [[unlikely]] {
+				return dma_read(address);
+			}
+
+			return read_bus(address);
+		}
+
 		/*
-		* Writes value to address,
+		* Reads the value at address,
 		* effect depends on the address
 		* range.
 		*/
-		byte Memory::Read(word address) const {
+		byte Memory::read_bus(word address) const {
 			//0x8000 - 0x9FFF
 			//0xFE00 - 0xFE9F
 			if (address <= 0x7FFF) { //reading from ROM
@@ -214,7 +378,7 @@ namespace GameboyEmu {
 				} break;
 
 				case 0xFF0F: {
-					return m_interrupt_flag.load();
+					return m_interrupts.GetIF();
 				} break;
 
 				case 0xFF40: {
@@ -279,7 +443,7 @@ namespace GameboyEmu {
 				return m_hram[address - 0xFF80];
 			}
 			else if (address == 0xFFFF) {
-				return m_interrupt_enable;
+				return m_interrupts.GetIE();
 			}
 			else {
 				LOG_WARN(m_state->GetLogger(), " Unimplemented, reading address {2:x}\n", address);
@@ -288,7 +452,23 @@ namespace GameboyEmu {
 			return 0xFF;
 		}
 
+		/*
+		* Writes value to address,
+		* effect depends on the address
+		* range.
+		*/
 		void Memory::Write(word address, byte value) {
+			if (byte flags = m_page_flags[address >> 8]) [[unlikely]] {
+				if (flags & watch_write) {
+					watch_access(address, value, true);
+				}
+
+				//The bus is taken by the DMA
+				if ((flags & dma_bus) && (int64_t)m_state->GetCycleCount() >= m_dma.start) {
+					return;
+				}
+			}
+
 			if (address <= 0x7FFF) {
 				m_cartridge->Write(address, value);
 			}
@@ -323,6 +503,7 @@ namespace GameboyEmu {
 				}*/
 
 				m_oam[address - 0xFE00] = value;
+				m_oam_index.Write((byte)(address - 0xFE00), value);
 			}
 			else if (address >= 0xFF00 && address < 0xFF80) {
 				if (address >= 0xFF10 && address <= 0xFF3F) {
@@ -361,7 +542,7 @@ namespace GameboyEmu {
 				} break;
 
 				case 0xFF0F: {
-					m_interrupt_flag.store(value);
+					m_interrupts.SetIF(value);
 				} break;
 
 				case 0xFF40: {
@@ -392,11 +573,20 @@ namespace GameboyEmu {
 				} break;
 
 				case 0xFF46: {
-					reset_dma();
+					//A new transfer replaces the current one
+					if (m_dma.running) {
+						dma_commit(m_state->GetCycleCount());
+						dma_flag_pages(false);
+					}
 
-					m_dma.running = true;
+					reset_dma();
 
 					m_dma.source_base = value * 0x100;
+
+					//The transfer starts after one M-cycle
+					m_dma.start = (int64_t)m_state->GetCycleCount() + 4;
+
+					start_dma();
 				} break;
 
 				case 0xFF47: {
@@ -436,7 +626,7 @@ namespace GameboyEmu {
 				m_hram[address - 0xFF80] = value;
 			}
 			else if (address == 0xFFFF) {
-				m_interrupt_enable = (byte)value;
+				m_interrupts.SetIE(value);
 			}
 			else {
 				LOG_WARN(m_state->GetLogger(), "Unimplemented memory write at {2:x}\n", address);
@@ -447,10 +637,7 @@ namespace GameboyEmu {
 		Memory::~Memory() {
 			LOG_INFO(m_state->GetLogger(), " Destroying memory object\n");
 
-			delete[] m_wram;
-			delete[] m_hram;
-			delete[] m_vram;
-			delete[] m_oam;
+			delete m_bootrom_image;
 		}
 
 		bool Memory::IsBootEnabled() const {
@@ -458,11 +645,11 @@ namespace GameboyEmu {
 		}
 
 		byte Memory::GetIE() const {
-			return m_interrupt_enable;
+			return m_interrupts.GetIE();
 		}
 
 		byte Memory::GetIR() const {
-			return m_interrupt_flag;
+			return m_interrupts.GetIF();
 		}
 
 		dma_status const& Memory::GetDma() const {
@@ -470,6 +657,14 @@ namespace GameboyEmu {
 		}
 
 		std::size_t Memory::DumpState(byte* buffer, std::size_t offset) {
+			if (m_dma.running) {
+				uint64_t now = m_state->GetCycleCount();
+
+				dma_commit(now);
+
+				m_dma.cycle_count = (byte)(((int64_t)now + 4 - m_dma.start) / 4);
+			}
+
 			buffer[offset] = m_dma.running;
 			WriteWord(buffer, offset + 1, m_dma.source_base);
 			buffer[offset + 3] = m_dma.current_index;
@@ -480,69 +675,98 @@ namespace GameboyEmu {
 
 			offset += 7;
 
-			std::copy_n(m_wram, StaticData::wram_size, buffer + offset);
+			std::copy_n(m_wram.begin(), StaticData::wram_size, buffer + offset);
 
 			offset += StaticData::wram_size;
 
-			std::copy_n(m_hram, StaticData::hram_size, buffer + offset);
+			std::copy_n(m_hram.begin(), StaticData::hram_size, buffer + offset);
 
 			offset += StaticData::hram_size;
 
-			std::copy_n(m_vram, StaticData::vram_size, buffer + offset);
+			std::copy_n(m_vram.begin(), StaticData::vram_size, buffer + offset);
 
 			offset += StaticData::vram_size;
 
-			std::copy_n(m_oam, StaticData::oam_size, buffer + offset);
+			std::copy_n(m_oam.begin(), StaticData::oam_size, buffer + offset);
 
 			offset += StaticData::oam_size;
 
-			buffer[offset] = m_interrupt_enable;
-			buffer[offset + 1] = m_interrupt_flag.load();
+			buffer[offset] = m_interrupts.GetIE();
+			buffer[offset + 1] = m_interrupts.GetIF();
 			
 			offset += 2;
 
-			std::copy_n(m_bootrom, StaticData::dmg_bootrom_size, buffer + offset);
+			//The boot rom is not loaded when
+			//the emulator starts from 0x100
+			if (m_bootrom) {
+				std::copy_n(m_bootrom, StaticData::bootrom_state_size, buffer + offset);
+			}
+			else {
+				std::fill_n(buffer + offset, StaticData::bootrom_state_size, 0x00);
+			}
 
-			offset += StaticData::dmg_bootrom_size;
+			offset += StaticData::bootrom_state_size;
 
 			return offset;
 		}
 
-		std::size_t Memory::LoadState(byte* buffer, std::size_t offset) {
-			m_dma.running = buffer[offset];
+		std::size_t Memory::LoadState(const byte* buffer, std::size_t offset) {
+			if (m_dma.running) {
+				dma_flag_pages(false);
+			}
+
+			reset_dma();
+
+			bool running = buffer[offset];
+			byte committed = buffer[offset + 3];
+
 			m_dma.source_base = ReadWord(buffer, offset + 1);
-			m_dma.current_index = buffer[offset + 3];
-			m_dma.current_oam_index = buffer[offset + 4];
 			m_dma.cycle_count = buffer[offset + 5];
 
 			m_bootROMEnabled = buffer[offset + 6];
 
 			offset += 7;
 
-			std::copy_n(buffer + offset, StaticData::wram_size, m_wram);
+			std::copy_n(buffer + offset, StaticData::wram_size, m_wram.begin());
 
 			offset += StaticData::wram_size;
 
-			std::copy_n(buffer + offset, StaticData::hram_size, m_hram);
+			std::copy_n(buffer + offset, StaticData::hram_size, m_hram.begin());
 
 			offset += StaticData::hram_size;
 
-			std::copy_n(buffer + offset, StaticData::vram_size, m_vram);
+			std::copy_n(buffer + offset, StaticData::vram_size, m_vram.begin());
 
 			offset += StaticData::vram_size;
 
-			std::copy_n(buffer + offset, StaticData::oam_size, m_oam);
+			std::copy_n(buffer + offset, StaticData::oam_size, m_oam.begin());
+
+			m_oam_index.Rebuild(m_oam.data());
+
+			//The source is read again, after the memory
+			if (running) {
+				//The transfer lasts 161 M-cycles after the write
+				int64_t elapsed = std::min<int64_t>(m_dma.cycle_count, 0xA1);
+
+				m_dma.start = (int64_t)m_state->GetCycleCount() + 4 - elapsed * 4;
+
+				start_dma();
+
+				m_dma.current_index = committed;
+				m_dma.current_oam_index = m_dma.current_index;
+			}
 
 			offset += StaticData::oam_size;
 
-			m_interrupt_enable = buffer[offset];
-			m_interrupt_flag = buffer[offset + 1];
+			m_interrupts.SetIE(buffer[offset]);
+			m_interrupts.SetIF(buffer[offset + 1]);
 
 			offset += 2;
 
-			std::copy_n(buffer + offset, StaticData::dmg_bootrom_size, m_bootrom);
-
-			offset += StaticData::dmg_bootrom_size;
+			//The boot rom is read only and
+			//never changes, it is kept only
+			//for compatibility of the layout
+			offset += StaticData::bootrom_state_size;
 
 			return offset;
 		}
@@ -0,0 +1,75 @@
+#include "../../include/memory/OamIndex.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace GameboyEmu {
+	namespace Mem {
+		OamIndex::OamIndex() : m_y(), m_lines() {
+			//Y = 0 is above the screen
+			m_y.fill(0);
+		}
+
+		void OamIndex::mark(byte object, byte y, bool set) {
+			uint64_t bit = 1ull << object;
+
+			//The position is the line + 16
+			int top = (int)y - 16;
+
+			for (int height = 0; height < 2; height++) {
+				int bottom = top + (height ? 16 : 8);
+
+				for (int line = std::max(top, 0); line < bottom && line < (int)lines; line++) {
+					if (set) {
+						m_lines[height][line] |= bit;
+					}
+					else {
+						m_lines[height][line] &= ~bit;
+					}
+				}
+			}
+		}
+
+		void OamIndex::set_y(byte object, byte y) {
+			if (m_y[object] == y) {
+				return;
+			}
+
+			mark(object, m_y[object], false);
+			mark(object, y, true);
+
+			m_y[object] = y;
+		}
+
+		void OamIndex::Rebuild(const byte* oam) {
+			for (auto& height : m_lines) {
+				height.fill(0);
+			}
+
+			for (byte object = 0; object < objects; object++) {
+				m_y[object] = oam[object * 4];
+
+				mark(object, m_y[object], true);
+			}
+		}
+
+		byte OamIndex::Lookup(byte line, bool tall,
+			std::array<byte, max_objects>& found) const {
+			if (line >= lines) {
+				return 0;
+			}
+
+			uint64_t mask = m_lines[tall ? 1 : 0][line];
+
+			byte count = 0;
+
+			while (mask != 0 && count < max_objects) {
+				found[count++] = (byte)std::countr_zero(mask);
+
+				mask &= mask - 1;
+			}
+
+			return count;
+		}
+	}
+}
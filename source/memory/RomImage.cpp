@@ -0,0 +1,202 @@
+#include "../../include/memory/RomImage.h"
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace GameboyEmu::Mem {
+	/*
+	* A mapped file, or a heap copy if
+	* the file could not be mapped
+	*/
+	struct RomImage::Mapping {
+		byte* base = nullptr;
+		std::size_t size = 0;
+
+		bool mapped = false;
+
+		std::vector<byte> heap{};
+
+		~Mapping() {
+			if (!mapped)
+				return;
+#ifdef _WIN32
+			UnmapViewOfFile(base);
+#else
+			munmap(base, size);
+#endif
+		}
+	};
+
+	namespace {
+		//Mappings shared by the images of the same file
+		std::mutex shared_mutex;
+		std::map<std::string, std::weak_ptr<RomImage::Mapping>> shared_mappings;
+
+		bool map_file(std::filesystem::path const& path, std::size_t size,
+			bool copy_on_write, RomImage::Mapping& out) {
+#ifdef _WIN32
+			HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+				nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			HANDLE mapping = CreateFileMappingW(file, nullptr,
+				copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+
+			CloseHandle(file);
+
+			if (mapping == nullptr)
+				return false;
+
+			void* base = MapViewOfFile(mapping,
+				copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, size);
+
+			//The view keeps the mapping alive
+			CloseHandle(mapping);
+
+			if (base == nullptr)
+				return false;
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+
+			if (fd < 0)
+				return false;
+
+			int prot = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+
+			void* base = mmap(nullptr, size, prot, MAP_PRIVATE, fd, 0);
+
+			//The mapping keeps the file alive
+			close(fd);
+
+			if (base == MAP_FAILED)
+				return false;
+#endif
+			out.base = reinterpret_cast<byte*>(base);
+			out.size = size;
+			out.mapped = true;
+
+			return true;
+		}
+
+		bool read_file(std::filesystem::path const& path, std::size_t size,
+			RomImage::Mapping& out) {
+			std::ifstream file(path, std::ios::in | std::ios::binary);
+
+			if (!file.good())
+				return false;
+
+			out.heap.resize(size);
+
+			file.read(reinterpret_cast<char*>(out.heap.data()), size);
+
+			if (!file.good())
+				return false;
+
+			out.base = out.heap.data();
+			out.size = size;
+
+			return true;
+		}
+	}
+
+	std::pair<RomImage*, std::string> RomImage::Open(std::filesystem::path const& path) {
+		std::error_code ec{};
+
+		if (!std::filesystem::exists(path, ec)) {
+			return std::pair(nullptr, "File does not exist");
+		}
+
+		if (!std::filesystem::is_regular_file(path, ec)) {
+			return std::pair(nullptr, "File is not a regular file");
+		}
+
+		std::size_t size = (std::size_t)std::filesystem::file_size(path, ec);
+
+		if (ec || size == 0) {
+			return std::pair(nullptr, "Cannot read file");
+		}
+
+		std::string key = std::filesystem::weakly_canonical(path, ec).string();
+
+		if (ec) {
+			key = path.string();
+		}
+
+		std::scoped_lock<std::mutex> lock(shared_mutex);
+
+		auto found = shared_mappings.find(key);
+
+		if (found != shared_mappings.end()) {
+			auto mapping = found->second.lock();
+
+			//The file could have changed in the meantime
+			if (mapping && mapping->size == size) {
+				return std::pair(new RomImage(path, mapping), "");
+			}
+		}
+
+		auto mapping = std::make_shared<Mapping>();
+
+		if (!map_file(path, size, false, *mapping) &&
+			!read_file(path, size, *mapping)) {
+			return std::pair(nullptr, "Cannot read file");
+		}
+
+		shared_mappings[key] = mapping;
+
+		return std::pair(new RomImage(path, mapping), "");
+	}
+
+	RomImage::RomImage(std::filesystem::path const& path, std::shared_ptr<Mapping> mapping) :
+		m_path(path), m_mapping(std::move(mapping)), m_private()
+	{}
+
+	const byte* RomImage::Data() const {
+		return m_private ? m_private->base : m_mapping->base;
+	}
+
+	std::size_t RomImage::Size() const {
+		return m_mapping->size;
+	}
+
+	byte* RomImage::Writable() {
+		if (m_private)
+			return m_private->base;
+
+		auto copy = std::make_unique<Mapping>();
+
+		//Pages are copied only when written, if the
+		//file cannot be mapped again the whole rom
+		//is copied
+		if (!map_file(m_path, m_mapping->size, true, *copy)) {
+			copy->heap.assign(m_mapping->base, m_mapping->base + m_mapping->size);
+			copy->base = copy->heap.data();
+			copy->size = m_mapping->size;
+		}
+
+		m_private = std::move(copy);
+
+		return m_private->base;
+	}
+
+	bool RomImage::IsShared() const {
+		return !m_private;
+	}
+
+	//The shared mapping is released when
+	//the last image is destroyed
+	RomImage::~RomImage() = default;
+}
@@ -0,0 +1,197 @@
+#include "../../include/save/Compression.h"
+
+#include <cstring>
+
+namespace GameboyEmu::Saves::Compression {
+	namespace {
+		static constexpr std::size_t min_match = 4;
+
+		//The last 5 bytes are always literals,
+		//and no match can start in the last 12
+		static constexpr std::size_t last_literals = 5;
+		static constexpr std::size_t match_limit = 12;
+
+		static constexpr std::size_t max_offset = 0xFFFF;
+
+		static constexpr unsigned hash_bits = 13;
+
+		inline uint32_t read32(const byte* ptr) {
+			uint32_t value = 0;
+			std::memcpy(&value, ptr, 4);
+			return value;
+		}
+
+		inline uint32_t hash(uint32_t sequence) {
+			return (sequence * 2654435761u) >> (32 - hash_bits);
+		}
+
+		void write_length(std::vector<byte>& out, std::size_t len) {
+			while (len >= 255) {
+				out.push_back(255);
+				len -= 255;
+			}
+
+			out.push_back((byte)len);
+		}
+
+		void write_sequence(std::vector<byte>& out, const byte* literals,
+			std::size_t num_literals, std::size_t offset, std::size_t match_len) {
+			byte token = 0;
+
+			token |= (byte)((num_literals >= 15 ? 15 : num_literals) << 4);
+
+			if (match_len != 0) {
+				std::size_t len = match_len - min_match;
+				token |= (byte)(len >= 15 ? 15 : len);
+			}
+
+			out.push_back(token);
+
+			if (num_literals >= 15) {
+				write_length(out, num_literals - 15);
+			}
+
+			out.insert(out.end(), literals, literals + num_literals);
+
+			if (match_len == 0)
+				return;
+
+			out.push_back((byte)(offset & 0xFF));
+			out.push_back((byte)((offset >> 8) & 0xFF));
+
+			if (match_len - min_match >= 15) {
+				write_length(out, match_len - min_match - 15);
+			}
+		}
+	}
+
+	std::size_t CompressBound(std::size_t len) {
+		return len + (len / 255) + 16;
+	}
+
+	std::size_t Compress(const byte* in, std::size_t len, std::vector<byte>& out) {
+		std::size_t start_size = out.size();
+
+		out.reserve(start_size + CompressBound(len));
+
+		if (len < match_limit + 1) {
+			write_sequence(out, in, len, 0, 0);
+			return out.size() - start_size;
+		}
+
+		//Positions + 1, so that 0 means empty
+		std::vector<uint32_t> table(1u << hash_bits, 0);
+
+		std::size_t pos = 0;
+		std::size_t anchor = 0;
+
+		std::size_t limit = len - match_limit;
+
+		while (pos < limit) {
+			uint32_t sequence = read32(in + pos);
+			uint32_t h = hash(sequence);
+
+			std::size_t candidate = table[h];
+
+			table[h] = (uint32_t)(pos + 1);
+
+			if (candidate == 0 ||
+				pos - (candidate - 1) > max_offset ||
+				read32(in + candidate - 1) != sequence) {
+				pos++;
+				continue;
+			}
+
+			candidate--;
+
+			//Extend the match
+			std::size_t match_len = min_match;
+			std::size_t max_len = len - last_literals - pos;
+
+			while (match_len < max_len &&
+				in[candidate + match_len] == in[pos + match_len]) {
+				match_len++;
+			}
+
+			write_sequence(out, in + anchor, pos - anchor,
+				pos - candidate, match_len);
+
+			pos += match_len;
+			anchor = pos;
+		}
+
+		write_sequence(out, in + anchor, len - anchor, 0, 0);
+
+		return out.size() - start_size;
+	}
+
+	bool Decompress(const byte* in, std::size_t len, byte* out, std::size_t out_len) {
+		std::size_t ip = 0;
+		std::size_t op = 0;
+
+		auto read_length = [&](std::size_t& value) {
+			byte curr = 0;
+
+			do {
+				if (ip >= len)
+					return false;
+
+				curr = in[ip++];
+				value += curr;
+			} while (curr == 255);
+
+			return true;
+		};
+
+		while (ip < len) {
+			byte token = in[ip++];
+
+			std::size_t num_literals = token >> 4;
+
+			if (num_literals == 15 && !read_length(num_literals))
+				return false;
+
+			if (ip + num_literals > len || op + num_literals > out_len)
+				return false;
+
+			std::memcpy(out + op, in + ip, num_literals);
+
+			ip += num_literals;
+			op += num_literals;
+
+			//Last sequence
+			if (ip == len)
+				break;
+
+			if (ip + 2 > len)
+				return false;
+
+			std::size_t offset = in[ip] | (in[ip + 1] << 8);
+
+			ip += 2;
+
+			if (offset == 0 || offset > op)
+				return false;
+
+			std::size_t match_len = token & 0xF;
+
+			if (match_len == 15 && !read_length(match_len))
+				return false;
+
+			match_len += min_match;
+
+			if (op + match_len > out_len)
+				return false;
+
+			//The match can overlap the output,
+			//so it is copied byte by byte
+			std::size_t from = op - offset;
+
+			for (std::size_t index = 0; index < match_len; index++) {
+				out[op++] = out[from + index];
+			}
+		}
+
+		return op == out_len;
+	}
+}
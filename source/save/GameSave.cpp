@@ -1,5 +1,6 @@
 #include "../../include/save/GameSave.h"
 #include "../../include/cartridge/MemoryCard.h"
+#include "../../include/save/SaveWriter.h"
 
 #include <chrono>
 
@@ -7,7 +8,7 @@
 #include <fstream>
 
 namespace GameboyEmu::Saves {
-	void dumpHeader(Cartridge::MemoryCard* card, std::ofstream& file) {
+	void dumpHeader(std::string_view title, std::size_t size_kb, std::ofstream& file) {
 		save_header header{};
 
 		std::fill_n(header.title, 16, '\0');
@@ -20,11 +21,9 @@ namespace GameboyEmu::Saves {
 
 		header.modified = nano;
 
-		auto title = card->GetTitle();
-
-		std::copy_n(title.data(), title.length(), header.title);
+		std::copy_n(title.data(), std::min<std::size_t>(title.length(), 16), header.title);
 
-		header.size_kb = Cartridge::getRamKb(card->GetRamSize());
+		header.size_kb = (uint8_t)size_kb;
 
 		file.write(reinterpret_cast<char*>(&header), sizeof(header));
 	}
@@ -59,30 +58,32 @@ namespace GameboyEmu::Saves {
 		return std::pair(true, "Header ok");
 	}
 
-	std::pair<bool, std::string> SaveGame(Cartridge::MemoryCard* card, std::string const& path) {
-		if (!card->SupportsSaves()) {
-			return std::pair(false, "Cartridge does not support saves");
-		}
+	std::pair<bool, std::string> WriteGame(std::ofstream& file, const byte* ram, std::size_t size_kb, std::string_view title) {
+		dumpHeader(title, size_kb, file);
 
-		auto size_kb = Cartridge::getRamKb(card->GetRamSize());
-		
-		std::ofstream save(path, std::ios::out);
+		file.write(reinterpret_cast<const char*>(ram), (uint64_t)size_kb * 1024);
 
-		if (!save.is_open()) {
-			return std::pair(false, "Cannot create file");
+		if (!file.good()) {
+			return std::pair(false, "Could not write file");
 		}
 
-		save.close();
+		return std::pair(true, "Game saved");
+	}
 
-		save.open(path, std::ios::out | std::ios::binary);
+	std::pair<bool, std::string> SaveGame(Cartridge::MemoryCard* card, std::string const& path) {
+		if (!card->SupportsSaves()) {
+			return std::pair(false, "Cartridge does not support saves");
+		}
 
-		dumpHeader(card, save);
+		auto size_kb = Cartridge::getRamKb(card->GetRamSize());
 
 		const byte* buf = card->GetRamBuffer();
 
-		save.write(reinterpret_cast<const char*>(buf), (uint64_t)size_kb * 1024);
+		auto title = card->GetTitle();
 
-		return std::pair(true, "Game saved");
+		return WriteAtomic(path, [buf, size_kb, title](std::ofstream& file) {
+			return WriteGame(file, buf, size_kb, title);
+		});
 	}
 
 	std::pair<bool, std::string> LoadGame(Cartridge::MemoryCard* card, std::string const& path) {
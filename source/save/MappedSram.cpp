@@ -0,0 +1,262 @@
+#include "../../include/save/MappedSram.h"
+#include "../../include/save/GameSave.h"
+
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace GameboyEmu::Saves {
+	namespace {
+		static constexpr uint8_t save_magic = 0b10101010;
+
+		save_header make_header(std::string_view title, std::size_t size) {
+			save_header header{};
+
+			header.magic = save_magic;
+			header.modified = std::chrono::system_clock::now().time_since_epoch().count();
+
+			std::fill_n(header.title, 16, '\0');
+			std::copy_n(title.data(), std::min<std::size_t>(title.length(), 16), header.title);
+
+			header.size_kb = (uint8_t)(size / 1024);
+
+			return header;
+		}
+
+		std::pair<bool, std::string> check_header(const byte* data, std::string_view title, std::size_t size) {
+			save_header header{};
+
+			std::memcpy(&header, data, sizeof(header));
+
+			if (header.magic != save_magic) {
+				return std::pair(false, "Invalid signature");
+			}
+
+			save_header expected = make_header(title, size);
+
+			if (!std::equal(header.title, header.title + 16, expected.title)) {
+				return std::pair(false, "Invalid title name");
+			}
+
+			if (header.size_kb != expected.size_kb) {
+				return std::pair(false, "Invalid size");
+			}
+
+			return std::pair(true, "");
+		}
+
+		std::size_t page_size() {
+#ifdef _WIN32
+			SYSTEM_INFO info{};
+			GetSystemInfo(&info);
+			return info.dwAllocationGranularity;
+#else
+			return (std::size_t)sysconf(_SC_PAGESIZE);
+#endif
+		}
+	}
+
+	MappedSram::MappedSram() :
+		m_base(nullptr), m_file_size(0), m_data_offset(sizeof(save_header)),
+#ifdef _WIN32
+		m_file(nullptr), m_mapping(nullptr),
+#else
+		m_fd(-1),
+#endif
+		m_dirty(0), m_sync_thread(), m_sync_mutex(),
+		m_sync_cv(), m_stop(false)
+	{}
+
+	std::pair<bool, std::string> MappedSram::Open(std::string const& path,
+		std::string_view title, std::size_t size, const byte* initial) {
+		if (m_base != nullptr) {
+			return std::pair(false, "Already opened");
+		}
+
+		//The dirty mask has one bit per block
+		if ((m_data_offset + size) / block_size >= 64) {
+			return std::pair(false, "RAM is too big");
+		}
+
+		std::error_code ec{};
+
+		bool exists = std::filesystem::exists(path, ec);
+
+		m_file_size = m_data_offset + size;
+
+		if (exists && std::filesystem::file_size(path, ec) != m_file_size) {
+			return std::pair(false, "Invalid save file size");
+		}
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE) {
+			return std::pair(false, "Could not open file");
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+			0, (DWORD)m_file_size, nullptr);
+
+		if (mapping == nullptr) {
+			CloseHandle(file);
+			return std::pair(false, "Could not map file");
+		}
+
+		void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_file_size);
+
+		if (base == nullptr) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return std::pair(false, "Could not map file");
+		}
+
+		m_file = file;
+		m_mapping = mapping;
+#else
+		int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+
+		if (fd < 0) {
+			return std::pair(false, "Could not open file");
+		}
+
+		if (!exists && ftruncate(fd, (off_t)m_file_size) != 0) {
+			close(fd);
+			return std::pair(false, "Could not resize file");
+		}
+
+		void* base = mmap(nullptr, m_file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		if (base == MAP_FAILED) {
+			close(fd);
+			return std::pair(false, "Could not map file");
+		}
+
+		m_fd = fd;
+#endif
+
+		m_base = reinterpret_cast<byte*>(base);
+
+		std::string message = "Save loaded from " + path;
+
+		if (exists) {
+			auto check = check_header(m_base, title, size);
+
+			if (!check.first) {
+				Close();
+				return check;
+			}
+		}
+		else {
+			save_header header = make_header(title, size);
+
+			std::memcpy(m_base, &header, sizeof(header));
+			std::copy_n(initial, size, m_base + m_data_offset);
+
+			MarkAllDirty();
+
+			message = "Save created in " + path;
+		}
+
+		m_stop = false;
+
+		m_sync_thread = std::thread([this]() {
+			std::unique_lock<std::mutex> lock(m_sync_mutex);
+
+			while (!m_stop) {
+				m_sync_cv.wait_for(lock, std::chrono::milliseconds(sync_interval_ms),
+					[this]() { return m_stop; });
+
+				Sync();
+			}
+		});
+
+		return std::pair(true, message);
+	}
+
+	byte* MappedSram::Data() {
+		return m_base + m_data_offset;
+	}
+
+	std::size_t MappedSram::Size() const {
+		return m_file_size - m_data_offset;
+	}
+
+	void MappedSram::MarkAllDirty() {
+		m_dirty.store(~uint64_t(0));
+	}
+
+	void MappedSram::Sync() {
+		uint64_t dirty = m_dirty.exchange(0);
+
+		if (dirty == 0 || m_base == nullptr)
+			return;
+
+		std::size_t page = page_size();
+
+		for (std::size_t block = 0; block < 64 && (block * block_size) < m_file_size; block++) {
+			if ((dirty & (uint64_t(1) << block)) == 0)
+				continue;
+
+			//The flushed range must start on a page
+			std::size_t start = block * block_size;
+			std::size_t end = std::min(start + block_size, m_file_size);
+
+			start -= start % page;
+#ifdef _WIN32
+			FlushViewOfFile(m_base + start, end - start);
+#else
+			msync(m_base + start, end - start, MS_SYNC);
+#endif
+		}
+	}
+
+	void MappedSram::Close() {
+		if (m_sync_thread.joinable()) {
+			{
+				std::scoped_lock<std::mutex> lock(m_sync_mutex);
+				m_stop = true;
+			}
+
+			m_sync_cv.notify_one();
+			m_sync_thread.join();
+		}
+
+		if (m_base == nullptr)
+			return;
+
+		Sync();
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_base);
+		CloseHandle((HANDLE)m_mapping);
+		CloseHandle((HANDLE)m_file);
+
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		munmap(m_base, m_file_size);
+		close(m_fd);
+
+		m_fd = -1;
+#endif
+
+		m_base = nullptr;
+	}
+
+	MappedSram::~MappedSram() {
+		Close();
+	}
+}
@@ -0,0 +1,242 @@
+#include "../../include/save/Movie.h"
+#include "../../include/save/Savestate.h"
+#include "../../include/save/SaveWriter.h"
+#include "../../include/state/EmulatorState.h"
+#include "../../include/cartridge/MemoryCard.h"
+
+#include <fstream>
+#include <filesystem>
+
+/*
+* Movie file layout (version 1)
+*
+* Header : magic "LBMV" (4), version (2), flags (2),
+* global checksum of the ROM (2), clock start (8),
+* frame count (4), with the numbers in little endian
+*
+* If the state flag is set the savestate to start
+* from follows (see Savestate.cpp), then one byte
+* per frame with the pressed buttons
+*/
+
+namespace GameboyEmu::Saves {
+	namespace {
+		static constexpr char movie_magic[4] = { 'L', 'B', 'M', 'V' };
+
+		static constexpr uint16_t movie_version = 1;
+
+		static constexpr uint16_t movie_has_state = 0x1;
+
+		static constexpr std::size_t movie_header_size = 22;
+
+		struct MovieHeader {
+			uint16_t version;
+			uint16_t flags;
+			word checksum;
+			int64_t clock_start;
+			uint32_t count;
+		};
+
+		void write_movie_header(std::ofstream& file, MovieHeader const& header) {
+			byte data[movie_header_size] = {};
+
+			uint64_t clock = (uint64_t)header.clock_start;
+
+			std::copy_n(movie_magic, 4, data);
+
+			WriteWord(data, 4, header.version);
+			WriteWord(data, 6, header.flags);
+			WriteWord(data, 8, header.checksum);
+
+			for (std::size_t i = 0; i < 4; i++) {
+				WriteWord(data, 10 + i * 2, (word)(clock >> (i * 16)));
+			}
+
+			WriteWord(data, 18, (word)(header.count & 0xFFFF));
+			WriteWord(data, 20, (word)(header.count >> 16));
+
+			file.write(reinterpret_cast<const char*>(data), movie_header_size);
+		}
+
+		//False if the file is too short or not a movie
+		bool read_movie_header(std::ifstream& file, MovieHeader& header) {
+			byte data[movie_header_size] = {};
+
+			file.read(reinterpret_cast<char*>(data), movie_header_size);
+
+			if (!file.good() || !std::equal(data, data + 4, movie_magic)) {
+				return false;
+			}
+
+			uint64_t clock = 0;
+
+			for (std::size_t i = 0; i < 4; i++) {
+				clock |= (uint64_t)ReadWord(data, 10 + i * 2) << (i * 16);
+			}
+
+			header.version = ReadWord(data, 4);
+			header.flags = ReadWord(data, 6);
+			header.checksum = ReadWord(data, 8);
+			header.clock_start = (int64_t)clock;
+			header.count = ReadWord(data, 18) | ((uint32_t)ReadWord(data, 20) << 16);
+
+			return true;
+		}
+	}
+
+	Movie::Movie() :
+		m_checksum(0), m_clock_start(0),
+		m_has_state(false), m_start(),
+		m_frames(), m_position(0) {}
+
+	void Movie::Begin(word checksum, int64_t clock_start) {
+		m_checksum = checksum;
+		m_clock_start = clock_start;
+
+		m_has_state = false;
+		m_start.Clear();
+
+		m_frames.clear();
+		m_position = 0;
+	}
+
+	void Movie::Begin(word checksum, int64_t clock_start, Snapshot const& start) {
+		Begin(checksum, clock_start);
+
+		m_has_state = true;
+		m_start = start;
+	}
+
+	void Movie::Append(byte pressed) {
+		m_frames.push_back(pressed);
+	}
+
+	bool Movie::Next(byte& pressed) {
+		if (m_position >= m_frames.size()) {
+			return false;
+		}
+
+		pressed = m_frames[m_position++];
+
+		return true;
+	}
+
+	word Movie::GetChecksum() const {
+		return m_checksum;
+	}
+
+	int64_t Movie::GetClockStart() const {
+		return m_clock_start;
+	}
+
+	bool Movie::HasStartState() const {
+		return m_has_state;
+	}
+
+	Snapshot const& Movie::GetStartState() const {
+		return m_start;
+	}
+
+	std::size_t Movie::FrameCount() const {
+		return m_frames.size();
+	}
+
+	std::size_t Movie::Position() const {
+		return m_position;
+	}
+
+	std::pair<bool, std::string> Movie::Save(std::string const& path, std::string_view title) const {
+		return WriteAtomic(path, [this, title](std::ofstream& file) {
+			MovieHeader header{};
+
+			header.version = movie_version;
+			header.flags = m_has_state ? movie_has_state : 0;
+			header.checksum = m_checksum;
+			header.clock_start = m_clock_start;
+			header.count = (uint32_t)m_frames.size();
+
+			write_movie_header(file, header);
+
+			if (m_has_state) {
+				auto res = WriteState(file, m_start, title);
+
+				if (!res.first) {
+					return res;
+				}
+			}
+
+			file.write(reinterpret_cast<const char*>(m_frames.data()), m_frames.size());
+
+			if (!file.good()) {
+				return std::pair<bool, std::string>(false, "Could not write file");
+			}
+
+			return std::pair<bool, std::string>(true, "");
+		});
+	}
+
+	std::pair<bool, std::string> Movie::Load(std::string const& path, State::EmulatorState* state) {
+		if (!std::filesystem::is_regular_file(path)) {
+			return std::pair(false, "File does not exist");
+		}
+
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+
+		if (!file.is_open()) {
+			return std::pair(false, "Could not open file");
+		}
+
+		//Nothing is replaced before the
+		//whole movie has been read
+		MovieHeader header{};
+
+		if (!read_movie_header(file, header)) {
+			return std::pair(false, "Not a movie");
+		}
+
+		if (header.version > movie_version) {
+			return std::pair(false, "Unsupported movie version " + std::to_string(header.version));
+		}
+
+		if (header.checksum != state->GetCard()->GetGlobalChecksum()) {
+			return std::pair(false, "The movie was recorded with another game");
+		}
+
+		bool has_state = (header.flags & movie_has_state) != 0;
+		Snapshot start{};
+
+		if (has_state) {
+			auto res = ReadState(file, state, start);
+
+			if (!res.first) {
+				return std::pair(false, "Invalid start state : " + res.second);
+			}
+		}
+
+		//One byte per frame, the count is checked
+		//before allocating
+		std::size_t remaining = (std::size_t)std::filesystem::file_size(path) -
+			(std::size_t)file.tellg();
+
+		if (header.count > remaining) {
+			return std::pair(false, "Movie is truncated");
+		}
+
+		std::vector<byte> frames(header.count);
+
+		file.read(reinterpret_cast<char*>(frames.data()), header.count);
+
+		if (!file.good()) {
+			return std::pair(false, "Movie is truncated");
+		}
+
+		m_checksum = header.checksum;
+		m_clock_start = header.clock_start;
+		m_has_state = has_state;
+		m_start = std::move(start);
+		m_frames = std::move(frames);
+		m_position = 0;
+
+		return std::pair(true, "");
+	}
+}
@@ -0,0 +1,245 @@
+#include "../../include/save/Rewind.h"
+#include "../../include/state/EmulatorState.h"
+
+#include <cstring>
+
+namespace GameboyEmu::Saves {
+	namespace {
+		void write_varint(std::vector<byte>& out, std::size_t value) {
+			while (value >= 0x80) {
+				out.push_back((byte)(value & 0x7F) | 0x80);
+				value >>= 7;
+			}
+
+			out.push_back((byte)value);
+		}
+
+		std::size_t read_varint(std::vector<byte> const& in, std::size_t& pos) {
+			std::size_t value = 0;
+			unsigned shift = 0;
+
+			while (pos < in.size()) {
+				byte curr = in[pos++];
+
+				value |= (std::size_t)(curr & 0x7F) << shift;
+
+				if (!(curr & 0x80))
+					break;
+
+				shift += 7;
+			}
+
+			return value;
+		}
+
+		//Number of equal bytes starting from pos,
+		//compared 8 bytes at a time when possible
+		std::size_t equal_run(const byte* a, const byte* b,
+			std::size_t pos, std::size_t size) {
+			std::size_t start = pos;
+
+			while (pos + 8 <= size) {
+				uint64_t wa = 0;
+				uint64_t wb = 0;
+
+				std::memcpy(&wa, a + pos, 8);
+				std::memcpy(&wb, b + pos, 8);
+
+				if (wa != wb)
+					break;
+
+				pos += 8;
+			}
+
+			while (pos < size && a[pos] == b[pos]) {
+				pos++;
+			}
+
+			return pos - start;
+		}
+
+		/*
+		* The delta is a list of
+		* [equal bytes count][changed bytes count][changed bytes XOR]
+		* with the counts stored as LEB128
+		*/
+		void encode_delta(const byte* older, const byte* newer,
+			std::size_t size, std::vector<byte>& out) {
+			std::size_t pos = 0;
+
+			while (pos < size) {
+				std::size_t zeros = equal_run(older, newer, pos, size);
+
+				pos += zeros;
+
+				std::size_t start = pos;
+
+				//A single equal byte does not end the
+				//literal run, it would cost more than
+				//it saves
+				while (pos < size) {
+					if (older[pos] == newer[pos] &&
+						(pos + 1 >= size || older[pos + 1] == newer[pos + 1]))
+						break;
+
+					pos++;
+				}
+
+				write_varint(out, zeros);
+				write_varint(out, pos - start);
+
+				for (std::size_t index = start; index < pos; index++) {
+					out.push_back(older[index] ^ newer[index]);
+				}
+			}
+		}
+
+		void apply_delta(std::vector<byte> const& delta, byte* state, std::size_t size) {
+			std::size_t in = 0;
+			std::size_t pos = 0;
+
+			while (in < delta.size()) {
+				pos += read_varint(delta, in);
+
+				std::size_t literal = read_varint(delta, in);
+
+				while (literal > 0 && pos < size && in < delta.size()) {
+					state[pos++] ^= delta[in++];
+					literal--;
+				}
+			}
+		}
+	}
+
+	RewindBuffer::RewindBuffer(std::size_t budget, unsigned interval) :
+		m_budget(budget), m_interval(interval),
+		m_frames(0), m_head(), m_scratch(),
+		m_deltas(), m_used(0), m_count(0) {}
+
+	void RewindBuffer::OnFrame(State::EmulatorState* state) {
+		m_frames++;
+
+		if (m_frames < m_interval) {
+			return;
+		}
+
+		m_frames = 0;
+
+		Push(state);
+	}
+
+	void RewindBuffer::Push(State::EmulatorState* state) {
+		state->Capture(m_scratch);
+
+		if (m_head.Empty()) {
+			std::swap(m_head, m_scratch);
+
+			m_used = m_head.Size();
+			m_count = 1;
+
+			return;
+		}
+
+		std::vector<byte> delta{};
+
+		encode_delta(m_head.Data(), m_scratch.Data(),
+			m_head.Size(), delta);
+
+		delta.shrink_to_fit();
+
+		m_used += delta.size();
+
+		m_deltas.push_back(std::move(delta));
+
+		std::swap(m_head, m_scratch);
+
+		m_count = m_deltas.size() + 1;
+
+		evict();
+	}
+
+	unsigned RewindBuffer::StepBack(State::EmulatorState* state, unsigned count) {
+		if (m_head.Empty()) {
+			return 0;
+		}
+
+		unsigned done = 0;
+
+		while (done < count && !m_deltas.empty()) {
+			auto const& delta = m_deltas.back();
+
+			apply_delta(delta, m_head.Data(), m_head.Size());
+
+			m_used -= delta.size();
+
+			m_deltas.pop_back();
+
+			done++;
+		}
+
+		//Already at the oldest snapshot, reloading it
+		//every frame would freeze the game there
+		if (done == 0) {
+			return 0;
+		}
+
+		m_count = m_deltas.size() + 1;
+		m_frames = 0;
+
+		auto res = state->Restore(m_head);
+
+		//The deltas are gone, the buffer no longer
+		//leads back to the machine
+		if (!res.first) {
+			LOG_ERR(state->GetLogger(), "Rewind failed : {2}\n", res.second);
+
+			Clear();
+			return 0;
+		}
+
+		return done;
+	}
+
+	void RewindBuffer::Clear() {
+		m_head.Clear();
+		m_deltas.clear();
+
+		m_frames = 0;
+		m_used = 0;
+		m_count = 0;
+	}
+
+	void RewindBuffer::evict() {
+		while (m_used > m_budget && !m_deltas.empty()) {
+			m_used -= m_deltas.front().size();
+
+			m_deltas.pop_front();
+		}
+
+		m_count = m_deltas.size() + 1;
+	}
+
+	void RewindBuffer::SetBudget(std::size_t budget) {
+		m_budget = budget;
+	}
+
+	void RewindBuffer::SetInterval(unsigned interval) {
+		m_interval = interval == 0 ? 1 : interval;
+	}
+
+	std::size_t RewindBuffer::GetBudget() const {
+		return m_budget;
+	}
+
+	unsigned RewindBuffer::GetInterval() const {
+		return m_interval;
+	}
+
+	std::size_t RewindBuffer::GetUsedMemory() const {
+		return m_used;
+	}
+
+	std::size_t RewindBuffer::GetCount() const {
+		return m_count;
+	}
+}
@@ -0,0 +1,201 @@
+#include "../../include/save/SaveWriter.h"
+
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace GameboyEmu::Saves {
+	namespace {
+		//Waits until the data of the file is on the disk
+		bool sync_file(std::string const& path) {
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0,
+				nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			bool ok = FlushFileBuffers(file) != 0;
+
+			CloseHandle(file);
+
+			return ok;
+#else
+			int fd = ::open(path.c_str(), O_RDONLY);
+
+			if (fd < 0) {
+				return false;
+			}
+
+			bool ok = ::fsync(fd) == 0;
+
+			::close(fd);
+
+			return ok;
+#endif
+		}
+
+		//Makes the rename durable, NTFS journals it
+		//so there is nothing to do on Windows
+		void sync_directory(std::string const& path) {
+#ifndef _WIN32
+			std::string dir = std::filesystem::path(path).parent_path().string();
+
+			if (dir.empty()) {
+				dir = ".";
+			}
+
+			int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+
+			if (fd < 0) {
+				return;
+			}
+
+			::fsync(fd);
+			::close(fd);
+#else
+			(void)path;
+#endif
+		}
+	}
+
+	std::pair<bool, std::string> WriteAtomic(std::string const& path, write_function const& write) {
+		std::string temp = path + ".tmp";
+
+		std::ofstream file(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open()) {
+			return std::pair(false, "Could not create file");
+		}
+
+		auto res = write(file);
+
+		file.close();
+
+		if (res.first && file.fail()) {
+			res = std::pair(false, "Could not write file");
+		}
+
+		//Otherwise, after a power loss, the rename can
+		//be on the disk while the data is not
+		if (res.first && !sync_file(temp)) {
+			res = std::pair(false, "Could not flush file");
+		}
+
+		std::error_code ec{};
+
+		if (!res.first) {
+			std::filesystem::remove(temp, ec);
+			return res;
+		}
+
+		std::filesystem::rename(temp, path, ec);
+
+		if (ec) {
+			std::filesystem::remove(temp, ec);
+			return std::pair(false, "Could not replace " + path);
+		}
+
+		sync_directory(path);
+
+		return res;
+	}
+
+	SaveWriter::SaveWriter(Logger& log) :
+		m_logger(log), m_jobs(), m_mutex(),
+		m_job_cv(), m_idle_cv(), m_busy(false),
+		m_stop(false), m_last_result(true, ""),
+		m_thread() {
+		m_thread = std::thread([this]() {
+			this->worker();
+		});
+	}
+
+	void SaveWriter::Queue(std::string const& path, write_function write) {
+		{
+			std::scoped_lock<std::mutex> lock(m_mutex);
+
+			m_jobs.push_back(Job{ path, std::move(write) });
+		}
+
+		m_job_cv.notify_one();
+	}
+
+	void SaveWriter::Flush() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_idle_cv.wait(lock, [this]() {
+			return m_jobs.empty() && !m_busy;
+		});
+	}
+
+	std::size_t SaveWriter::Pending() {
+		std::scoped_lock<std::mutex> lock(m_mutex);
+
+		return m_jobs.size() + (m_busy ? 1 : 0);
+	}
+
+	std::pair<bool, std::string> SaveWriter::LastResult() {
+		std::scoped_lock<std::mutex> lock(m_mutex);
+
+		return m_last_result;
+	}
+
+	void SaveWriter::worker() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (true) {
+			m_job_cv.wait(lock, [this]() {
+				return m_stop || !m_jobs.empty();
+			});
+
+			//Pending jobs are written even when stopping
+			if (m_jobs.empty())
+				break;
+
+			Job job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+
+			m_busy = true;
+
+			lock.unlock();
+
+			auto res = WriteAtomic(job.path, job.write);
+
+			if (!res.first) {
+				m_logger.log_err("Could not save {0} : {1}\n",
+					job.path, res.second);
+			}
+
+			lock.lock();
+
+			m_busy = false;
+			m_last_result = res;
+
+			if (m_jobs.empty()) {
+				m_idle_cv.notify_all();
+			}
+		}
+	}
+
+	SaveWriter::~SaveWriter() {
+		{
+			std::scoped_lock<std::mutex> lock(m_mutex);
+
+			m_stop = true;
+		}
+
+		m_job_cv.notify_one();
+
+		if (m_thread.joinable()) {
+			m_thread.join();
+		}
+	}
+}
@@ -1,4 +1,7 @@
 #include "../../include/save/Savestate.h"
+#include "../../include/save/Snapshot.h"
+#include "../../include/save/Compression.h"
+#include "../../include/save/SaveWriter.h"
 #include "../../include/state/EmulatorState.h"
 
 #include "../../include/cartridge/MemoryCard.h"
@@ -12,26 +15,133 @@
 #include <fstream>
 #include <chrono>
 #include <filesystem>
+#include <array>
+#include <vector>
+
+/*
+* Savestate file layout (version 2.0)
+* 
+* Header : magic (1), timestamp (8), title (16), version (16)
+* 
+* Then one chunk per component :
+* [tag (4)][version (2)][flags (2)][raw size (4)][stored size (4)][data]
+* with the numbers in little endian
+* 
+* If the compressed flag is set the data is
+* compressed, otherwise it is stored as is (when
+* compression would not save anything).
+* The file ends with an "END " chunk with no data.
+* 
+* Chunks with an unknown tag are skipped, so new
+* components can be added without breaking old
+* versions. Version 1.0 files have no chunks, only
+* the raw state after the header. They are still
+* loaded, without the phase of the TIMA prescaler,
+* unless they were taken during an OAM DMA.
+*/
 
 namespace GameboyEmu::Saves {
-	std::pair<bool, std::string> SavestateSaveHeader(std::ofstream& file, State::EmulatorState* state) {
-		byte magic = 0b11001100;
+	namespace {
+		static constexpr byte savestate_magic = 0b11001100;
+
+		static constexpr uint16_t chunk_compressed = 0x1;
+
+		struct ChunkInfo {
+			char tag[4];
+			uint16_t version;
+		};
+
+		//Indexed by Section, the version must be bumped
+		//when a component changes its layout or the
+		//meaning of a field. There is no conversion,
+		//other versions are refused.
+		//MEM 2 : the DMA cycle count is in M-cycles since the write to 0xFF46
+		//PPU 2 : the object fetch bytes are unused, the objects of a line are selected at once
+		//TIMR 2 : the divider is saved as the 16 bit system counter
+		static constexpr std::array<ChunkInfo, section_count> chunk_infos = { {
+			{ { 'C', 'P', 'U', ' ' }, 1 },
+			{ { 'M', 'E', 'M', ' ' }, 2 },
+			{ { 'P', 'P', 'U', ' ' }, 2 },
+			{ { 'T', 'I', 'M', 'R' }, 2 },
+			{ { 'S', 'E', 'R', 'L' }, 1 },
+			{ { 'A', 'P', 'U', ' ' }, 1 },
+			{ { 'C', 'A', 'R', 'T' }, 1 }
+		} };
+
+		static constexpr char end_tag[4] = { 'E', 'N', 'D', ' ' };
+
+		struct ChunkHeader {
+			char tag[4];
+			uint16_t version;
+			uint16_t flags;
+			uint32_t raw_size;
+			uint32_t stored_size;
+		};
+
+		static constexpr std::size_t chunk_header_size = 16;
+
+		//The fields are little endian, like the
+		//words inside the states
+		void write_chunk_header(std::ofstream& file, ChunkHeader const& header) {
+			byte data[chunk_header_size] = {};
+
+			std::copy_n(header.tag, 4, data);
+
+			WriteWord(data, 4, header.version);
+			WriteWord(data, 6, header.flags);
+			WriteWord(data, 8, (word)(header.raw_size & 0xFFFF));
+			WriteWord(data, 10, (word)(header.raw_size >> 16));
+			WriteWord(data, 12, (word)(header.stored_size & 0xFFFF));
+			WriteWord(data, 14, (word)(header.stored_size >> 16));
+
+			file.write(reinterpret_cast<const char*>(data), chunk_header_size);
+		}
 
-		auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+		bool read_chunk_header(std::ifstream& file, ChunkHeader& header) {
+			byte data[chunk_header_size] = {};
 
-		auto title_view = state->GetCard()->GetTitle();
+			file.read(reinterpret_cast<char*>(data), chunk_header_size);
+
+			if (!file.good()) {
+				return false;
+			}
+
+			std::copy_n(data, 4, header.tag);
+
+			header.version = ReadWord(data, 4);
+			header.flags = ReadWord(data, 6);
+			header.raw_size = ReadWord(data, 8) | ((uint32_t)ReadWord(data, 10) << 16);
+			header.stored_size = ReadWord(data, 12) | ((uint32_t)ReadWord(data, 14) << 16);
+
+			return true;
+		}
+
+		int find_section(const char* tag) {
+			for (std::size_t index = 0; index < chunk_infos.size(); index++) {
+				if (std::equal(tag, tag + 4, chunk_infos[index].tag))
+					return (int)index;
+			}
+
+			return -1;
+		}
+	}
+
+	std::pair<bool, std::string> SavestateSaveHeader(std::ofstream& file, std::string_view title_view) {
+		byte magic = savestate_magic;
+
+		auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 
 		char title[16] = {};
 
 		std::fill_n(title, 16, '\0');
 
-		std::copy_n(title_view.data(), title_view.length(), title);
+		std::copy_n(title_view.data(), std::min<std::size_t>(title_view.length(), 16), title);
 
 		char version[16] = {};
 
 		std::fill_n(version, 16, '\0');
 
-		version[0] = '1';
+		version[0] = '2';
 		version[1] = '.';
 		version[2] = '0';
 
@@ -43,7 +153,7 @@ namespace GameboyEmu::Saves {
 		return std::pair(true, "");
 	}
 
-	std::pair<bool, std::string> SavestateLoadHeader(std::ifstream& file, State::EmulatorState* state) {
+	std::pair<bool, std::string> SavestateLoadHeader(std::ifstream& file, State::EmulatorState* state, std::string& version_out) {
 		byte magic = 0;
 		uint64_t now = 0;
 		char title_data[16] = {};
@@ -56,62 +166,207 @@ namespace GameboyEmu::Saves {
 		file.read(title_data, 16);
 		file.read(version, 16);
 
-		if (magic != 0b11001100) {
+		if (!file.good()) {
+			return std::pair(false, "Could not read header");
+		}
+
+		if (magic != savestate_magic) {
 			return std::pair(false, "Invalid magic");
 		}
 
 		std::string title_saved = std::string(title_data, 16);
 		std::string title_orig(16, '\0');
 
-		std::copy_n(title_view.data(), title_view.length(), title_orig.begin());
+		std::copy_n(title_view.data(), std::min<std::size_t>(title_view.length(), 16), title_orig.begin());
 
 		if (title_saved != title_orig) {
 			return std::pair(false, "Invalid game title");
 		}
 
+		version_out = std::string(version, std::find(version, version + 16, '\0'));
+
 		return std::pair(true, "");
 	}
 
-	std::pair<bool, std::string> SaveState(std::string const& to, State::EmulatorState* state) {
-		std::ofstream save(to, std::ios::out);
+	std::pair<bool, std::string> SavestateWriteChunks(std::ofstream& file, Snapshot const& snap) {
+		//Reused by every chunk
+		std::vector<byte> compressed{};
 
-		if (!save.is_open()) {
-			return std::pair(false, "Could not create file");
+		for (std::size_t index = 0; index < section_count; index++) {
+			Section section = (Section)index;
+
+			const byte* data = snap.Data() + snap.SectionOffset(section);
+			std::size_t size = snap.SectionSize(section);
+
+			compressed.clear();
+
+			Compression::Compress(data, size, compressed);
+
+			ChunkHeader header{};
+
+			std::copy_n(chunk_infos[index].tag, 4, header.tag);
+
+			header.version = chunk_infos[index].version;
+			header.raw_size = (uint32_t)size;
+
+			if (compressed.size() < size) {
+				header.flags = chunk_compressed;
+				header.stored_size = (uint32_t)compressed.size();
+				data = compressed.data();
+			}
+			else {
+				header.flags = 0;
+				header.stored_size = (uint32_t)size;
+			}
+
+			//Every chunk goes straight to the file,
+			//the whole compressed state is never
+			//held in memory
+			write_chunk_header(file, header);
+			file.write(reinterpret_cast<const char*>(data), header.stored_size);
+
+			if (!file.good()) {
+				return std::pair(false, "Could not write file");
+			}
+		}
+
+		ChunkHeader end{};
+
+		std::copy_n(end_tag, 4, end.tag);
+
+		write_chunk_header(file, end);
+
+		if (!file.good()) {
+			return std::pair(false, "Could not write file");
 		}
 
-		save.close();
+		return std::pair(true, "");
+	}
+
+	std::pair<bool, std::string> SavestateReadChunks(std::ifstream& file, Snapshot& snap) {
+		std::vector<byte> stored{};
+
+		std::array<bool, section_count> found{};
+
+		while (true) {
+			ChunkHeader header{};
+
+			if (!read_chunk_header(file, header)) {
+				return std::pair(false, "Savestate is truncated");
+			}
+
+			if (std::equal(header.tag, header.tag + 4, end_tag))
+				break;
+
+			int index = find_section(header.tag);
+
+			//Written by a newer version
+			if (index < 0) {
+				file.ignore(header.stored_size);
+
+				if (file.gcount() != (std::streamsize)header.stored_size) {
+					return std::pair(false, "Savestate is truncated");
+				}
+
+				continue;
+			}
 
-		save.open(to, std::ios::out | std::ios::binary);
+			Section section = (Section)index;
 
-		SavestateSaveHeader(save, state);
+			std::string tag(header.tag, 4);
 
-		auto cpu = state->GetCPU();
-		auto mem = state->GetMemory();
-		auto ppu = state->GetPPU();
-		auto tim = state->GetTimer();
-		auto ser = state->GetSerial();
-		auto apu = state->GetAPU();
-		auto car = state->GetCard();
+			if (header.version != chunk_infos[index].version) {
+				return std::pair(false, "Unsupported version for chunk " + tag);
+			}
 
-		byte* megabuffer = new byte[256 * 1024];
+			if (header.raw_size != snap.SectionSize(section)) {
+				return std::pair(false, "Invalid size for chunk " + tag);
+			}
 
-		std::size_t offset = 0;
+			//The sizes are checked before allocating,
+			//a corrupted file must not ask for gigabytes
+			std::size_t max_stored = (header.flags & chunk_compressed) ?
+				Compression::CompressBound(header.raw_size) : header.raw_size;
 
-		offset = cpu->DumpState(megabuffer, offset);
-		offset = mem->DumpState(megabuffer, offset);
-		offset = ppu->DumpState(megabuffer, offset);
-		offset = tim->DumpState(megabuffer, offset);
-		offset = ser->DumpState(megabuffer, offset);
-		offset = apu->DumpState(megabuffer, offset);
-		offset = car->DumpState(megabuffer, offset);
+			if (header.stored_size > max_stored) {
+				return std::pair(false, "Invalid size for chunk " + tag);
+			}
 
-		save.write(reinterpret_cast<char*>(megabuffer), 256 * 1024);
+			stored.resize(header.stored_size);
 
-		delete[] megabuffer;
+			file.read(reinterpret_cast<char*>(stored.data()), header.stored_size);
+
+			if (!file.good()) {
+				return std::pair(false, "Savestate is truncated");
+			}
+
+			byte* dest = snap.Data() + snap.SectionOffset(section);
+
+			if (header.flags & chunk_compressed) {
+				if (!Compression::Decompress(stored.data(), stored.size(), dest, header.raw_size)) {
+					return std::pair(false, "Corrupted chunk " + tag);
+				}
+			}
+			else {
+				if (header.stored_size != header.raw_size) {
+					return std::pair(false, "Invalid size for chunk " + tag);
+				}
+
+				std::copy_n(stored.data(), header.raw_size, dest);
+			}
+
+			found[index] = true;
+		}
+
+		for (std::size_t index = 0; index < section_count; index++) {
+			if (!found[index]) {
+				return std::pair(false, "Missing chunk " + 
+					std::string(chunk_infos[index].tag, 4));
+			}
+		}
 
 		return std::pair(true, "");
 	}
 
+	std::pair<bool, std::string> WriteState(std::ofstream& file, Snapshot const& snap, std::string_view title) {
+		SavestateSaveHeader(file, title);
+
+		return SavestateWriteChunks(file, snap);
+	}
+
+	std::pair<bool, std::string> ReadState(std::ifstream& file, State::EmulatorState* state, Snapshot& snap) {
+		std::string version{};
+
+		auto check = SavestateLoadHeader(file, state, version);
+
+		if (!check.first) {
+			return check;
+		}
+
+		if (version != "2.0") {
+			return std::pair(false, "Unsupported savestate version " + version);
+		}
+
+		//The current state gives the layout of
+		//the sections, every chunk then replaces
+		//its own section
+		state->Capture(snap);
+
+		return SavestateReadChunks(file, snap);
+	}
+
+	std::pair<bool, std::string> SaveState(std::string const& to, State::EmulatorState* state) {
+		Snapshot snap{};
+
+		state->Capture(snap);
+
+		auto title = state->GetCard()->GetTitle();
+
+		return WriteAtomic(to, [&snap, title](std::ofstream& file) {
+			return WriteState(file, snap, title);
+		});
+	}
+
 	std::pair<bool, std::string> LoadState(std::string const& from, State::EmulatorState* state) {
 		std::ifstream save;
 
@@ -129,36 +384,68 @@ namespace GameboyEmu::Saves {
 			return std::pair(false, "Could not open file");
 		}
 
-		auto check = SavestateLoadHeader(save, state);
+		std::string version{};
+
+		auto check = SavestateLoadHeader(save, state, version);
 
 		if (!check.first) {
 			return check;
 		}
 
-		auto cpu = state->GetCPU();
-		auto mem = state->GetMemory();
-		auto ppu = state->GetPPU();
-		auto tim = state->GetTimer();
-		auto ser = state->GetSerial();
-		auto apu = state->GetAPU();
-		auto car = state->GetCard();
+		if (version == "2.0") {
+			Snapshot snap{};
 
-		byte* megabuffer = new byte[256 * 1024];
+			//ReadState reads the header again
+			save.seekg(0);
 
-		save.read(reinterpret_cast<char*>(megabuffer), 256 * 1024);
+			check = ReadState(save, state, snap);
 
-		std::size_t offset = 0;
+			if (!check.first) {
+				return check;
+			}
 
-		offset = cpu->LoadState(megabuffer, offset);
-		offset = mem->LoadState(megabuffer, offset);
-		offset = ppu->LoadState(megabuffer, offset);
-		offset = tim->LoadState(megabuffer, offset);
-		offset = ser->LoadState(megabuffer, offset);
-		offset = apu->LoadState(megabuffer, offset);
-		offset = car->LoadState(megabuffer, offset);
+			return state->Restore(snap);
+		}
 
-		delete[] megabuffer;
+		if (version != "1.0") {
+			return std::pair(false, "Unsupported savestate version " + version);
+		}
 
-		return std::pair(true, "");
+		//Old savestates always contain 256 KiB of
+		//payload, new ones only the exact state size,
+		//so everything after the header is read
+		std::size_t header_end = (std::size_t)save.tellg();
+		std::size_t file_size = (std::size_t)std::filesystem::file_size(from);
+
+		if (file_size <= header_end) {
+			return std::pair(false, "Savestate is empty");
+		}
+
+		Snapshot snap(file_size - header_end);
+
+		snap.Resize(file_size - header_end);
+
+		save.read(reinterpret_cast<char*>(snap.Data()), snap.Size());
+
+		if (!save.good()) {
+			return std::pair(false, "Could not read enough bytes");
+		}
+
+		//The layout is the same, not the meaning of
+		//every field. The timer bytes still give the
+		//system counter, only the phase of the TIMA
+		//prescaler is lost. A running OAM DMA counted
+		//T-states and cannot be resumed
+		Snapshot current{};
+
+		state->Capture(current);
+
+		std::size_t dma_running = current.SectionOffset(Section::memory);
+
+		if (snap.Size() > dma_running && snap.Data()[dma_running] != 0) {
+			return std::pair(false, "Savestate 1.0 was taken during an OAM DMA");
+		}
+
+		return state->Restore(snap);
 	}
 }
\ No newline at end of file
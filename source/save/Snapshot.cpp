@@ -0,0 +1,62 @@
+#include "../../include/save/Snapshot.h"
+
+namespace GameboyEmu::Saves {
+	Snapshot::Snapshot() :
+		m_buffer(), m_size(0), m_sections{} {}
+
+	Snapshot::Snapshot(std::size_t capacity) :
+		m_buffer(capacity), m_size(0), m_sections{} {}
+
+	void Snapshot::Reserve(std::size_t capacity) {
+		if (m_buffer.size() < capacity) {
+			m_buffer.resize(capacity);
+		}
+	}
+
+	void Snapshot::Resize(std::size_t size) {
+		Reserve(size);
+
+		m_size = size;
+	}
+
+	void Snapshot::Clear() {
+		m_size = 0;
+	}
+
+	byte* Snapshot::Data() {
+		return m_buffer.data();
+	}
+
+	const byte* Snapshot::Data() const {
+		return m_buffer.data();
+	}
+
+	std::size_t Snapshot::Size() const {
+		return m_size;
+	}
+
+	std::size_t Snapshot::Capacity() const {
+		return m_buffer.size();
+	}
+
+	bool Snapshot::Empty() const {
+		return m_size == 0;
+	}
+
+	void Snapshot::SetSectionStart(Section section, std::size_t offset) {
+		m_sections[(std::size_t)section] = offset;
+	}
+
+	std::size_t Snapshot::SectionOffset(Section section) const {
+		return m_sections[(std::size_t)section];
+	}
+
+	std::size_t Snapshot::SectionSize(Section section) const {
+		std::size_t index = (std::size_t)section;
+
+		std::size_t end = index + 1 < section_count ?
+			m_sections[index + 1] : m_size;
+
+		return end - m_sections[index];
+	}
+}
\ No newline at end of file
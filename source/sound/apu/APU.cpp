@@ -6,242 +6,183 @@
 #include "../../../include/sound/apu/NoiseChannel.h"
 #include "../../../include/sound/apu/WaveChannel.h"
 
-#define CAST(tp, ch)  dynamic_cast<tp*>(ch)
-
 namespace GameboyEmu::Sound {
 	APU::APU(State::EmulatorState* state, OutputDevice* outdev) 
 	: m_state(state), m_dev(outdev), 
-	m_ch1(nullptr), m_ch2(nullptr), m_ch3(nullptr), 
-	m_ch4(nullptr), m_left_vol(), m_right_vol(),
-	m_enabled(false), m_panning{}, m_samples(nullptr), 
+	m_ch1(true), m_ch2(false), m_ch3(),
+	m_ch4(), m_left_vol(), m_right_vol(),
+	m_enabled(false), m_panning{}, m_samples{},
 		m_num_samples(), m_curr_cycles(), m_capacitor(0)
-	{
-		m_ch1 = new PulseChannel(true);
-		m_ch2 = new PulseChannel(false);
-		m_ch3 = new WaveChannel();
-		m_ch4 = new NoiseChannel();
+	{}
+
+	constexpr std::array<APU::register_access, APU::num_registers> APU::make_registers() {
+		std::array<register_access, num_registers> regs{};
+
+		//Unused registers read 0xFF and ignore the writes
+		for (auto& reg : regs) {
+			reg.read = [](APU&, word) -> byte { return 0xFF; };
+			reg.write = [](APU&, word, byte) {};
+		}
+
+		auto at = [&regs](word address) -> register_access& {
+			return regs[address - first_register];
+		};
+
+		//Channel 1
+		at(0xFF10) = {
+			[](APU& apu, word) { return apu.m_ch1.ReadSweep(); },
+			[](APU& apu, word, byte value) { apu.m_ch1.WriteSweep(value); }
+		};
 
-		m_samples = new byte[num_samples];
+		at(0xFF11) = {
+			[](APU& apu, word) { return apu.m_ch1.ReadDuty(); },
+			[](APU& apu, word, byte value) { apu.m_ch1.WriteDuty(value); }
+		};
+
+		at(0xFF12) = {
+			[](APU& apu, word) { return apu.m_ch1.ReadEnvelope(); },
+			[](APU& apu, word, byte value) { apu.m_ch1.WriteEnvelope(value); }
+		};
+
+		at(0xFF13) = {
+			[](APU& apu, word) { return apu.m_ch1.ReadFreq(); },
+			[](APU& apu, word, byte value) { apu.m_ch1.WriteFreq(value); }
+		};
+
+		at(0xFF14) = {
+			[](APU& apu, word) { return apu.m_ch1.ReadControl(); },
+			[](APU& apu, word, byte value) { apu.m_ch1.WriteControl(value); }
+		};
+
+		//Channel 2
+		at(0xFF16) = {
+			[](APU& apu, word) { return apu.m_ch2.ReadDuty(); },
+			[](APU& apu, word, byte value) { apu.m_ch2.WriteDuty(value); }
+		};
+
+		at(0xFF17) = {
+			[](APU& apu, word) { return apu.m_ch2.ReadEnvelope(); },
+			[](APU& apu, word, byte value) { apu.m_ch2.WriteEnvelope(value); }
+		};
+
+		at(0xFF18) = {
+			[](APU& apu, word) { return apu.m_ch2.ReadFreq(); },
+			[](APU& apu, word, byte value) { apu.m_ch2.WriteFreq(value); }
+		};
+
+		at(0xFF19) = {
+			[](APU& apu, word) { return apu.m_ch2.ReadControl(); },
+			[](APU& apu, word, byte value) { apu.m_ch2.WriteControl(value); }
+		};
+
+		//Channel 3, the length and the frequency are write only
+		at(0xFF1A) = {
+			[](APU& apu, word) { return (byte)(apu.m_ch3.Enabled() << 7); },
+			[](APU& apu, word, byte value) { apu.m_ch3.SetEnabled(value); }
+		};
+
+		at(0xFF1B).write = [](APU& apu, word, byte value) {
+			apu.m_ch3.WriteLen(value);
+		};
+
+		at(0xFF1C) = {
+			[](APU& apu, word) { return apu.m_ch3.ReadOutLevel(); },
+			[](APU& apu, word, byte value) { apu.m_ch3.WriteOutLevel(value); }
+		};
+
+		at(0xFF1D).write = [](APU& apu, word, byte value) {
+			apu.m_ch3.WriteFreq(value);
+		};
+
+		at(0xFF1E) = {
+			[](APU& apu, word) { return apu.m_ch3.ReadControl(); },
+			[](APU& apu, word, byte value) { apu.m_ch3.WriteControl(value); }
+		};
+
+		//Channel 4
+		at(0xFF20) = {
+			[](APU& apu, word) { return apu.m_ch4.ReadLen(); },
+			[](APU& apu, word, byte value) { apu.m_ch4.WriteLen(value); }
+		};
+
+		at(0xFF21) = {
+			[](APU& apu, word) { return apu.m_ch4.ReadEnvelope(); },
+			[](APU& apu, word, byte value) { apu.m_ch4.WriteEnvelope(value); }
+		};
+
+		at(0xFF22) = {
+			[](APU& apu, word) { return apu.m_ch4.ReadPolynomialCounter(); },
+			[](APU& apu, word, byte value) { apu.m_ch4.WritePolynomialCounter(value); }
+		};
+
+		at(0xFF23) = {
+			[](APU& apu, word) { return apu.m_ch4.ReadControl(); },
+			[](APU& apu, word, byte value) { apu.m_ch4.WriteControl(value); }
+		};
+
+		//Control, panning is write only
+		at(0xFF24) = {
+			[](APU& apu, word) {
+				return (byte)((apu.m_left_vol << 4) | apu.m_right_vol);
+			},
+			[](APU& apu, word, byte value) {
+				apu.m_left_vol = (value >> 4) & 0b111;
+				apu.m_right_vol = value & 0b111;
+			}
+		};
+
+		at(0xFF25).write = [](APU& apu, word, byte value) {
+			//Right in the low nibble, left in the high one
+			for (byte ch = 0; ch < 4; ch++) {
+				byte left = GET_BIT(value, ch + 4);
+				byte right = GET_BIT(value, ch);
+
+				apu.m_panning[ch] = (Panning)((right << 1) | left);
+			}
+		};
+
+		at(0xFF26) = {
+			[](APU& apu, word) {
+				return (byte)((!!(apu.m_enabled) << 7) |
+					(!!(apu.m_ch4.Enabled()) << 3) |
+					(!!(apu.m_ch3.Enabled()) << 2) |
+					(!!(apu.m_ch2.Enabled()) << 1) |
+					(!!(apu.m_ch1.Enabled())));
+			},
+			[](APU& apu, word, byte value) { apu.m_enabled = GET_BIT(value, 7); }
+		};
+
+		//Wave RAM
+		for (word wave = 0xFF30; wave < 0xFF40; wave++) {
+			at(wave) = {
+				[](APU& apu, word address) {
+					return apu.m_ch3.ReadWaveRam(address - 0xFF30);
+				},
+				[](APU& apu, word address, byte value) {
+					apu.m_ch3.WriteWaveRam(address - 0xFF30, value);
+				}
+			};
+		}
+
+		return regs;
 	}
 
+	constinit const std::array<APU::register_access, APU::num_registers>
+		APU::s_registers = APU::make_registers();
+
 	void APU::WriteReg(word address, byte value) {
-		if (address >= 0xFF30 && address < 0xFF40) {
-			CAST(WaveChannel, m_ch3)->WriteWaveRam(
-				address - 0xFF30, value
-			);
+		word reg = (word)(address - first_register);
 
-			return;
-		}
-		
-		switch (address)
-		{
-		case 0xFF10: {
-			CAST(PulseChannel, m_ch1)->WriteSweep(value);
-		} break;
-
-		case 0xFF11: {
-			CAST(PulseChannel, m_ch1)->WriteDuty(value);
-		} break;
-
-		case 0xFF12: {
-			CAST(PulseChannel, m_ch1)->WriteEnvelope(value);
-		} break;
-
-		case 0xFF13: {
-			CAST(PulseChannel, m_ch1)->WriteFreq(value);
-		} break;
-
-		case 0xFF14: {
-			CAST(PulseChannel, m_ch1)->WriteControl(value);
-		} break;
-
-		case 0xFF16: {
-			CAST(PulseChannel, m_ch2)->WriteDuty(value);
-		} break;
-
-		case 0xFF17: {
-			CAST(PulseChannel, m_ch2)->WriteEnvelope(value);
-		} break;
-
-		case 0xFF18: {
-			CAST(PulseChannel, m_ch2)->WriteFreq(value);
-		} break;
-
-		case 0xFF19: {
-			CAST(PulseChannel, m_ch2)->WriteControl(value);
-		} break;
-
-		case 0xFF1A: {
-			CAST(WaveChannel, m_ch3)->SetEnabled(value);
-		} break;
-
-		case 0xFF1B: {
-			CAST(WaveChannel, m_ch3)->WriteLen(value);
-		} break;
-
-		case 0xFF1C: {
-			CAST(WaveChannel, m_ch3)->WriteOutLevel(value);
-		} break;
-
-		case 0xFF1D: {
-			CAST(WaveChannel, m_ch3)->WriteFreq(value);
-		} break;
-
-		case 0xFF1E: {
-			CAST(WaveChannel, m_ch3)->WriteControl(value);
-		} break;
-
-		case 0xFF20: {
-			CAST(NoiseChannel, m_ch4)->WriteLen(value);
-		} break;
-
-		case 0xFF21: {
-			CAST(NoiseChannel, m_ch4)->WriteEnvelope(value);
-		} break;
-
-		case 0xFF22: {
-			CAST(NoiseChannel, m_ch4)->WritePolynomialCounter(value);
-		} break;
-
-		case 0xFF23: {
-			CAST(NoiseChannel, m_ch4)->WriteControl(value);
-		} break;
-
-		case 0xFF24: {
-			m_left_vol = (value >> 4) & 0b111;
-			m_right_vol = value & 0b111;
-		} break;
-
-		case 0xFF25: {
-			byte ch4_l = GET_BIT(value, 7);
-			byte ch3_l = GET_BIT(value, 6);
-			byte ch2_l = GET_BIT(value, 5);
-			byte ch1_l = GET_BIT(value, 4);
-
-			byte ch4_r = GET_BIT(value, 3);
-			byte ch3_r = GET_BIT(value, 2);
-			byte ch2_r = GET_BIT(value, 1);
-			byte ch1_r = value & 1;
-
-			m_panning[0] = (Panning) ((ch1_r << 1) | ch1_l);
-			m_panning[1] = (Panning) ((ch2_r << 1) | ch2_l);
-			m_panning[2] = (Panning) ((ch3_r << 1) | ch3_l);
-			m_panning[3] = (Panning) ((ch4_r << 1) | ch4_l);
-		} break;
-
-		case 0xFF26: {
-			m_enabled = GET_BIT(value, 7);
-		} break;
-
-		default:
-			//LOG_WARN(m_state->GetLogger(), "Invalid audio register\n");
-			break;
+		if (reg < num_registers) {
+			s_registers[reg].write(*this, address, value);
 		}
 	}
 
 	byte APU::ReadReg(word address) {
-		if (address >= 0xFF30 && address < 0xFF40) {
-			return CAST(WaveChannel, m_ch3)->ReadWaveRam(
-				address - 0xFF30
-			);
-		}
+		word reg = (word)(address - first_register);
 
-		switch (address)
-		{
-		case 0xFF10: {
-			return CAST(PulseChannel, m_ch1)->ReadSweep();
-		} break;
-
-		case 0xFF11: {
-			return CAST(PulseChannel, m_ch1)->ReadDuty();
-		} break;
-
-		case 0xFF12: {
-			return CAST(PulseChannel, m_ch1)->ReadEnvelope();
-		} break;
-
-		case 0xFF13: {
-			return CAST(PulseChannel, m_ch1)->ReadFreq();
-		} break;
-
-		case 0xFF14: {
-			return CAST(PulseChannel, m_ch1)->ReadControl();
-		} break;
-
-		case 0xFF16: {
-			return CAST(PulseChannel, m_ch2)->ReadDuty();
-		} break;
-
-		case 0xFF17: {
-			return CAST(PulseChannel, m_ch2)->ReadEnvelope();
-		} break;
-
-		case 0xFF18: {
-			return CAST(PulseChannel, m_ch2)->ReadFreq();
-		} break;
-
-		case 0xFF19: {
-			return CAST(PulseChannel, m_ch2)->ReadControl();
-		} break;
-
-		case 0xFF1A: {
-			byte en = CAST(WaveChannel, m_ch3)->Enabled();
-			
-			return (en << 7);
-		} break;
-
-		case 0xFF1B: {
-			return 0xFF;
-		} break;
-
-		case 0xFF1C: {
-			return CAST(WaveChannel, m_ch3)->ReadOutLevel();
-		} break;
-
-		case 0xFF1D: {
-			return 0xFF;
-		} break;
-
-		case 0xFF1E: {
-			return CAST(WaveChannel, m_ch3)->ReadControl();
-		} break;
-
-		case 0xFF20: {
-			return CAST(NoiseChannel, m_ch4)->ReadLen();
-		} break;
-
-		case 0xFF21: {
-			return CAST(NoiseChannel, m_ch4)->ReadEnvelope();
-		} break;
-
-		case 0xFF22: {
-			return CAST(NoiseChannel, m_ch4)->ReadPolynomialCounter();
-		} break;
-
-		case 0xFF23: {
-			return CAST(NoiseChannel, m_ch4)->ReadControl();
-		} break;
-
-		case 0xFF24: {
-			return (m_left_vol << 4) |
-				(m_right_vol);
-		} break;
-
-		case 0xFF25: {
-			return 0xFF;
-		} break;
-
-		case 0xFF26: {
-			return (!!(m_enabled) << 7) |
-				(!!(m_ch4->Enabled()) << 3) |
-				(!!(m_ch3->Enabled()) << 2) |
-				(!!(m_ch2->Enabled()) << 1) |
-				(!!(m_ch1->Enabled()));
-		} break;
-
-		default:
-			//LOG_WARN(m_state->GetLogger(), "Invalid audio register\n");
-			break;
+		if (reg < num_registers) {
+			return s_registers[reg].read(*this, address);
 		}
 
 		return 0xFF;
@@ -254,17 +195,17 @@ namespace GameboyEmu::Sound {
 			if (m_enabled) {
 				m_curr_cycles++;
 
-				m_ch1->Clock();
-				m_ch2->Clock();
-				m_ch3->Clock();
-				m_ch4->Clock();
+				m_ch1.Clock();
+				m_ch2.Clock();
+				m_ch3.Clock();
+				m_ch4.Clock();
 
 				if (m_curr_cycles >= sample_clocks) {
 					std::array<short, 4> samples{
-						m_ch1->GetOutput(),
-						m_ch2->GetOutput(),
-						m_ch3->GetOutput(),
-						m_ch4->GetOutput()
+						m_ch1.GetOutput(),
+						m_ch2.GetOutput(),
+						m_ch3.GetOutput(),
+						m_ch4.GetOutput()
 					};
 
 					m_curr_cycles = 0;
@@ -351,7 +292,7 @@ namespace GameboyEmu::Sound {
 
 		if (m_num_samples == num_samples) {
 			if (m_dev) {
-				m_dev->SendSamples(m_samples);
+				m_dev->SendSamples(m_samples.data());
 			}
 
 			m_num_samples = 0;
@@ -370,7 +311,7 @@ namespace GameboyEmu::Sound {
 
 		offset += 7;
 
-		std::copy_n(m_samples, num_samples, buffer + offset);
+		std::copy_n(m_samples.begin(), num_samples, buffer + offset);
 
 		offset += num_samples;
 
@@ -380,7 +321,7 @@ namespace GameboyEmu::Sound {
 		return offset + 4;
 	}
 
-	std::size_t APU::LoadState(byte* buffer, std::size_t offset) {
+	std::size_t APU::LoadState(const byte* buffer, std::size_t offset) {
 		m_left_vol = buffer[offset];
 		m_right_vol = buffer[offset + 1];
 		m_enabled = buffer[offset + 2];
@@ -392,7 +333,7 @@ namespace GameboyEmu::Sound {
 
 		offset += 7;
 
-		std::copy_n(buffer + offset, num_samples, m_samples);
+		std::copy_n(buffer + offset, num_samples, m_samples.begin());
 
 		offset += num_samples;
 
@@ -403,9 +344,6 @@ namespace GameboyEmu::Sound {
 	}
 
 	APU::~APU() {
-		delete m_ch1;
-		delete m_ch2;
-		delete m_ch4;
-		delete m_samples;
+		delete m_dev;
 	}
 }
\ No newline at end of file
@@ -5,13 +5,9 @@ namespace GameboyEmu::Sound {
 		m_duty_offset(), m_duty_id(),
 		m_dac(false),
 		m_envelope(), m_counter(64),
-		m_sweep(nullptr), m_seq(),
+		m_sweep(), m_use_sweep(use_sweep), m_seq(),
 		m_output(), m_len()
-	{
-		if (use_sweep) {
-			m_sweep = new Sweep();
-		}
-	}
+	{}
 
 	void PulseChannel::WriteFreq(byte value) {
 		m_freq = (m_freq & 0b11100000000) | value;
@@ -67,17 +63,17 @@ namespace GameboyEmu::Sound {
 	}
 
 	byte PulseChannel::ReadSweep() const {
-		if (!m_sweep)
+		if (!m_use_sweep)
 			return 0xFF;
 
-		return m_sweep->Read();
+		return m_sweep.Read();
 	}
 
 	void PulseChannel::WriteSweep(byte value) {
-		if (!m_sweep)
+		if (!m_use_sweep)
 			return;
 
-		m_sweep->Write(value);
+		m_sweep.Write(value);
 	}
 
 	bool PulseChannel::Clock() {
@@ -106,8 +102,8 @@ namespace GameboyEmu::Sound {
 	void PulseChannel::Restart() {
 		m_envelope.Reload(this);
 
-		if (m_sweep)
-			m_sweep->Reload(this);
+		if (m_use_sweep)
+			m_sweep.Reload(this);
 
 		m_timer.Reload(this);
 		
@@ -123,7 +119,7 @@ namespace GameboyEmu::Sound {
 	}
 
 	Sweep* PulseChannel::GetSweep() {
-		return m_sweep;
+		return m_use_sweep ? &m_sweep : nullptr;
 	}
 
 	Envelope* PulseChannel::GetEnvelope() {
@@ -134,10 +130,7 @@ namespace GameboyEmu::Sound {
 		return m_enabled ? m_output : 0;
 	}
 
-	PulseChannel::~PulseChannel() {
-		if (m_sweep)
-			delete m_sweep;
-	}
+	PulseChannel::~PulseChannel() {}
 
 	word PulseChannel::GetCalculatedPeriod() const {
 		return (2048 - m_freq) * 4;
@@ -0,0 +1,25 @@
+#include "../../../include/sound/output/NullOutput.h"
+
+namespace GameboyEmu::Sound {
+	std::string NullOutputDevice::GetDeviceName() const {
+		return "NullOutputDevice";
+	}
+
+	int NullOutputDevice::GetFrequency() const {
+		return 0;
+	}
+
+	byte NullOutputDevice::GetSilence() const {
+		return 0;
+	}
+
+	unsigned NullOutputDevice::GetBufferSize() const {
+		return 0;
+	}
+
+	void NullOutputDevice::SendSamples(byte* buffer) {
+		(void)buffer;
+	}
+
+	void NullOutputDevice::Init() {}
+}
@@ -31,6 +31,7 @@ namespace GameboyEmu::Sound {
 		if (SDL_InitSubSystem(SDL_INIT_AUDIO)) {
 			LOG_ERR(m_logger, "Fatal error, could not init audio\n");
 			LOG_ERR(m_logger, "{2}\n", SDL_GetError());
+			m_logger.flush();
 			std::exit(0);
 		}
 		
@@ -1,31 +1,63 @@
 #include "../../include/state/EmulatorState.h"
+#include "../../include/state/Machine.h"
 #include "../../include/cartridge/CartridgeCreator.h"
 #include "../../include/cartridge/MemoryCard.h"
 #include "../../include/memory/Memory.h"
 #include "../../include/cpu/Cpu.h"
 #include "../../include/graphics/ppu/PPU.h"
-#include "../../include/graphics/display/Display.h"
+#include "../../include/graphics/display/Screen.h"
+#include "../../include/state/Frontend.h"
 #include "../../include/timing/Timer.h"
 #include "../../include/input/Joypad.h"
 #include "../../include/sound/apu/APU.h"
 #include "../../include/sound/output/OutputDevice.h"
-#include "../../include/sound/output/SdlOutput.h"
+#include "../../include/sound/output/NullOutput.h"
 #include "../../include/datatransfer/Serial.h"
-#include "../../include/datatransfer/out/UdpSerial.h"
+#include "../../include/datatransfer/out/NullSerial.h"
+#include "../../include/save/Snapshot.h"
+#include "../../include/save/Rewind.h"
+#include "../../include/save/SaveWriter.h"
+#include "../../include/save/Savestate.h"
+#include "../../include/save/GameSave.h"
+#include "../../include/save/Movie.h"
+#include "../../include/debugger/Profiler.h"
+#include "../../include/debugger/GuestProfiler.h"
+#include "../../include/debugger/Tracer.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace GameboyEmu {
 	namespace State {
 
 		EmulatorState::EmulatorState(
-			std::string_view const& filename, Logger& log) :
-			m_file(filename), m_logger(log), m_cpu(nullptr),
+			std::string_view const& filename, Logger& log, Frontend* frontend) :
+			m_file(filename), m_logger(log), m_machine(nullptr), m_cpu(nullptr),
 			m_memory(nullptr), m_card(nullptr), m_ppu(nullptr), m_timer(nullptr),
 			m_joypad(nullptr), m_apu(nullptr), m_serial(nullptr),
 			m_fatal(false),
-			m_fatal_message(), m_display(nullptr), m_stop_check_cycles(0),
+			m_fatal_message(), m_display(nullptr),
+			m_headless(frontend == nullptr), m_frame_count(0), m_framebuffer(nullptr),
+			m_stop_check_cycles(0),
 			m_stopped(false), m_debugging(true), m_watchpoints(), m_break(false),
 			m_enable_watchpoints(true), m_enable_stacktrace(false),
-			m_stacktrace(), m_genies(), m_sharks() {
+			m_stacktrace(), m_genies(), m_sharks(),
+			m_state_size(0), m_card_offset(0), m_frame_ready(false),
+			m_rewind(nullptr), m_rewind_enabled(false),
+			m_rewind_pending(0), m_writer(nullptr),
+			m_save_requests(), m_save_mutex(),
+			m_save_pending(false), m_profiler(nullptr),
+			m_guest_profiler(nullptr), m_guest_sampling(false),
+			m_guest_restart(false), m_tracer(nullptr),
+			m_cycle_count(0), m_idle_skip(true),
+			m_movie(nullptr), m_movie_recording(false),
+			m_movie_finished(false), m_movie_pressed(0),
+			m_fixed_clock(false), m_clock_start(0),
+			m_clock_origin(0) {
+			m_profiler = new Debugger::Profiler();
+			m_guest_profiler = new Debugger::GuestProfiler();
+			m_tracer = new Debugger::Tracer();
+
 			m_logger.log_info("Trying to read from rom file {0}\n", m_file);
 			//try to read file and create cartridge
 			auto cart_or_error = Cartridge::CreateCartridge(m_file, this);
@@ -42,31 +74,49 @@ namespace GameboyEmu {
 
 			m_logger.log_info("{}\n\n", cart_or_error.first->Dump());
 
-			Sound::SdlOutputDevice* out_dev = new Sound::SdlOutputDevice(m_logger);
+			Sound::OutputDevice* out_dev = nullptr;
+			DataTransfer::SerialDevice* serial_dev = nullptr;
+
+			if (m_headless) {
+				out_dev = new Sound::NullOutputDevice();
+				serial_dev = new DataTransfer::NullSerial();
+			}
+			else {
+				out_dev = frontend->CreateAudio(m_logger);
+				serial_dev = frontend->CreateSerial();
+			}
+
+			m_machine = new Machine(this, cart_or_error.first, out_dev, serial_dev);
 
-			m_serial = new DataTransfer::Serial(new DataTransfer::UdpSerial());
-			m_apu = new Sound::APU(this, out_dev);
-			m_ppu = new Graphics::PPU(this);
-			m_timer = new Timing::Timer();
-			m_joypad = new Input::Joypad();
-			m_memory = new Mem::Memory(this, cart_or_error.first, m_ppu, m_timer, m_joypad, m_apu, m_serial);
-			m_cpu = new CPU::Cpu(this, m_memory);
+			m_serial = &m_machine->serial;
+			m_apu = &m_machine->apu;
+			m_ppu = &m_machine->ppu;
+			m_timer = &m_machine->timer;
+			m_joypad = &m_machine->joypad;
+			m_memory = &m_machine->memory;
+			m_cpu = &m_machine->cpu;
 			m_card = cart_or_error.first;
 
-			m_display = new Graphics::Display(m_logger, [this]() {
-				this->SetStopped(true);
-			});
+			if (!m_headless) {
+				m_display = frontend->CreateScreen(m_logger, [this]() {
+					this->SetStopped(true);
+				});
+			}
 
-			m_ppu->SetMemory(m_memory);
-			m_timer->SetMemory(m_memory);
-			m_joypad->SetMemory(m_memory);
-			m_serial->SetMemory(m_memory);
+			if (m_display != nullptr) {
+				m_display->Init(160, 144, 3);
+			}
 
-			m_display->Init(160, 144, 3);
+			m_stacktrace.reserve(max_stacktrace_depth);
 
-			m_stacktrace.reserve(500);
+			m_rewind = new Saves::RewindBuffer(
+				Saves::RewindBuffer::default_budget,
+				Saves::RewindBuffer::default_interval
+			);
 
-			m_display->SetJoypad(m_joypad);
+			if (m_display != nullptr) {
+				m_display->SetJoypad(m_joypad);
+			}
 
 			out_dev->Init();
 
@@ -85,6 +135,17 @@ namespace GameboyEmu {
 			if (m_stopped)
 				return;
 
+			m_frame_count++;
+			m_framebuffer = framebuffer;
+
+			if (m_headless) {
+				ApplySharks();
+
+				m_frame_ready = true;
+
+				return;
+			}
+
 			if (m_display->IsStop()) {
 				m_stopped = true;
 				return;
@@ -108,14 +169,96 @@ namespace GameboyEmu {
 
 			ApplySharks();
 
+			m_frame_ready = true;
+
 			m_last_frame = std::chrono::steady_clock::now();
 		}
 
+		unsigned EmulatorState::Step() {
+			unsigned cycles = m_cpu->Step();
+
+			if (m_frame_ready) {
+				frame_tasks();
+			}
+
+			if (m_save_pending.load(std::memory_order_relaxed)) {
+				save_tasks();
+			}
+
+			if (m_guest_sampling.load(std::memory_order_relaxed)) {
+				guest_sample(cycles);
+			}
+
+			return cycles;
+		}
+
+		unsigned EmulatorState::RunFrame() {
+			static constexpr unsigned frame_cycles = 70224;
+
+			uint64_t frame = m_frame_count;
+
+			unsigned cycles = 0;
+
+			while (m_frame_count == frame && cycles < frame_cycles && !m_stopped) {
+				cycles += Step();
+			}
+
+			return cycles;
+		}
+
+		bool EmulatorState::IsHeadless() const {
+			return m_headless;
+		}
+
+		uint64_t EmulatorState::GetFrameCount() const {
+			return m_frame_count;
+		}
+
+		const byte* EmulatorState::GetFramebuffer() const {
+			return m_framebuffer;
+		}
+
+		void EmulatorState::frame_tasks() {
+			m_frame_ready = false;
+
+			//Rewinding would change the inputs
+			//recorded or played
+			if (m_movie != nullptr) {
+				movie_frame();
+				return;
+			}
+
+			if (!m_rewind_enabled) {
+				if (m_rewind->GetCount() != 0) {
+					m_rewind->Clear();
+				}
+
+				return;
+			}
+
+			unsigned steps = m_rewind_pending.exchange(0);
+
+			//While the hotkey is held, one snapshot
+			//is rewound every frame
+			if (m_display != nullptr && m_display->RewindHeld()) {
+				steps++;
+			}
+
+			if (steps != 0) {
+				m_rewind->StepBack(this, steps);
+				return;
+			}
+
+			m_rewind->OnFrame(this);
+		}
+
 		void EmulatorState::Sync(byte cycles) {
+			m_cycle_count += cycles * 4;
+
 			m_stop_check_cycles++;
 
 			if (m_stop_check_cycles == 500) {
-				if (m_display->IsStop()) {
+				if (m_display != nullptr && m_display->IsStop()) {
 					m_stopped = true;
 					return;
 				}
@@ -123,11 +266,67 @@ namespace GameboyEmu {
 				m_stop_check_cycles = 0;
 			}
 
-			m_memory->DmaAdvance(cycles);
-			m_ppu->Tick(cycles);
-			m_timer->Tick(cycles);
-			m_apu->Tick(cycles);
-			m_serial->Clock(cycles);
+			//Buttons pressed by the frontend thread
+			if (m_joypad->EdgesPending()) [[unlikely]] {
+				m_joypad->Update();
+			}
+
+			//The OAM gets the bytes of the DMA when the
+			//PPU looks at it, the transfer only has an end
+			if (m_cycle_count >= m_memory->DmaEnd()) [[unlikely]] {
+				PROFILED(m_profiler, Debugger::Component::dma, m_memory->DmaFinish());
+			}
+
+			PROFILED(m_profiler, Debugger::PpuComponent(m_ppu->GetMode()), m_ppu->Tick(cycles));
+
+			if (m_cycle_count >= m_timer->NextEvent()) {
+				PROFILED(m_profiler, Debugger::Component::timer, m_timer->Update());
+			}
+
+			PROFILED(m_profiler, Debugger::Component::apu, m_apu->Tick(cycles));
+			PROFILED(m_profiler, Debugger::Component::serial, m_serial->Clock(cycles));
+		}
+
+		uint64_t EmulatorState::CyclesToEvent() {
+			if (m_memory->GetDma().running || m_serial->Transferring()) {
+				return 0;
+			}
+
+			//The inputs are polled at least once a line,
+			//even with the LCD off
+			uint64_t cycles = std::min(m_ppu->CyclesToEvent(), 456u);
+
+			uint64_t timer = m_timer->NextEvent();
+
+			if (timer != std::numeric_limits<uint64_t>::max()) {
+				cycles = std::min(cycles, timer > m_cycle_count ? timer - m_cycle_count : 0);
+			}
+
+			return cycles;
+		}
+
+		void EmulatorState::Skip(uint64_t cycles) {
+			uint64_t mcycles = cycles / 4;
+
+			while (mcycles > 0 && !m_stopped) {
+				byte chunk = (byte)std::min<uint64_t>(mcycles, 0xFF);
+
+				Sync(chunk);
+
+				mcycles -= chunk;
+			}
+		}
+
+		void EmulatorState::SetIdleSkip(bool enable) {
+			m_idle_skip.store(enable, std::memory_order_relaxed);
+		}
+
+		bool EmulatorState::IdleSkipEnabled() const {
+			return m_idle_skip.load(std::memory_order_relaxed);
+		}
+
+		bool EmulatorState::IdleLoopSkip() const {
+			return IdleSkipEnabled() && !m_tracer->Enabled() && !m_memory->Watching();
 		}
 
 		CPU::Cpu* EmulatorState::GetCPU() {
@@ -161,7 +360,9 @@ namespace GameboyEmu {
 		}
 
 		void EmulatorState::Stop() {
-			m_display->Stop();
+			if (m_display != nullptr) {
+				m_display->Stop();
+			}
 
 			m_stopped = true;
 		}
@@ -173,15 +374,22 @@ namespace GameboyEmu {
 		EmulatorState::~EmulatorState() {
 			m_logger.log_info("Stopping emulation and destroying objects\n");
 
-			delete m_cpu;
-			delete m_memory;
+			//Saves requested after the last instruction
+			//and the ones still being written
+			if (m_save_pending) {
+				save_tasks();
+			}
+
+			delete m_writer;
+			delete m_profiler;
+			delete m_guest_profiler;
+			delete m_tracer;
+
+			delete m_machine;
 			delete m_card;
-			delete m_ppu;
 			delete m_display;
-			delete m_timer;
-			delete m_joypad;
-			delete m_apu;
-			delete m_serial;
+			delete m_rewind;
+			delete m_movie;
 		}
 
 		Logger& EmulatorState::GetLogger() {
@@ -218,6 +426,14 @@ namespace GameboyEmu {
 
 		void EmulatorState::EnableWatchpoints(bool value) {
 			m_enable_watchpoints = value;
+
+			UpdateWatchpoints();
+		}
+
+		void EmulatorState::UpdateWatchpoints() {
+			if (m_memory != nullptr) {
+				m_memory->UpdateWatchpoints(m_watchpoints, m_enable_watchpoints);
+			}
 		}
 
 		/*bool EmulatorState::StacktraceEnabled() const {
@@ -240,7 +456,7 @@ namespace GameboyEmu {
 
 			m_stacktrace.swap(new_stack);
 
-			m_stacktrace.reserve(500);
+			m_stacktrace.reserve(max_stacktrace_depth);
 		}
 
 		word EmulatorState::StacktraceGetSize() const {
@@ -259,6 +475,18 @@ namespace GameboyEmu {
 			entry.dest_address = dest;
 			entry.ret_address = ret;
 			entry.page = page;
+			entry.dest_page = 0;
+
+			if (dest <= 0x7FFF) {
+				entry.dest_page = m_card->GetCurrentBank(dest);
+			}
+
+			//Calls left without a return (jump tables,
+			//popped return addresses) are forgotten
+			//first, the sampling may run for hours
+			if (m_stacktrace.size() == max_stacktrace_depth) {
+				m_stacktrace.erase(m_stacktrace.begin());
+			}
 
 			m_stacktrace.push_back(
 				entry
@@ -266,13 +494,13 @@ namespace GameboyEmu {
 		}
 
 		void EmulatorState::remove_stacktrace_entry(word ret_address) {
-			if (m_stacktrace.empty())
-				return;
-
-			auto const& entry = m_stacktrace.back();
-
-			if (entry.ret_address == ret_address) {
-				m_stacktrace.pop_back();
+			//Returns to an outer call drop the calls
+			//above it, their own return never came
+			for (std::size_t i = m_stacktrace.size(); i > 0; i--) {
+				if (m_stacktrace[i - 1].ret_address == ret_address) {
+					m_stacktrace.resize(i - 1);
+					return;
+				}
 			}
 		}
 
@@ -539,9 +767,400 @@ namespace GameboyEmu {
 			return list;
 		}
 
+		std::pair<bool, std::string> EmulatorState::RecordMovie(bool from_state) {
+			if (m_movie != nullptr) {
+				return std::pair(false, "A movie is already running");
+			}
+
+			//Power on is only the same for the
+			//player when nothing has run yet
+			if (!from_state && (m_cycle_count != 0 || m_memory->IsBootEnabled())) {
+				return std::pair(false, "Movies without a state start at power on, without the boot ROM");
+			}
+
+			int64_t start = std::chrono::duration_cast<std::chrono::seconds>(
+				std::chrono::system_clock::now().time_since_epoch()
+			).count();
+
+			Saves::Movie* movie = new Saves::Movie();
+
+			if (from_state) {
+				Saves::Snapshot snap{};
+
+				Capture(snap);
+
+				//What the player restores, the parts
+				//of the components that are not
+				//saved are the same for both
+				auto res = Restore(snap);
+
+				if (!res.first) {
+					delete movie;
+					return res;
+				}
+
+				movie->Begin(m_card->GetGlobalChecksum(), start, snap);
+			}
+			else {
+				movie->Begin(m_card->GetGlobalChecksum(), start);
+			}
+
+			m_movie = movie;
+			m_movie_recording = true;
+			m_movie_finished = false;
+
+			start_clock(start);
+
+			m_joypad->SetLatched(true);
+			m_movie_pressed = m_joypad->HostPressed();
+			m_joypad->Latch(m_movie_pressed);
+
+			return std::pair(true, "");
+		}
+
+		std::pair<bool, std::string> EmulatorState::SaveMovie(std::string const& path) {
+			if (m_movie == nullptr || !m_movie_recording) {
+				return std::pair(false, "No movie is being recorded");
+			}
+
+			auto res = m_movie->Save(path, m_card->GetTitle());
+
+			StopMovie();
+
+			return res;
+		}
+
+		std::pair<bool, std::string> EmulatorState::PlayMovie(std::string const& path) {
+			if (m_movie != nullptr) {
+				return std::pair(false, "A movie is already running");
+			}
+
+			Saves::Movie* movie = new Saves::Movie();
+
+			auto res = movie->Load(path, this);
+
+			if (!res.first) {
+				delete movie;
+				return res;
+			}
+
+			if (movie->HasStartState()) {
+				res = Restore(movie->GetStartState());
+
+				if (!res.first) {
+					delete movie;
+					return res;
+				}
+			}
+			else if (m_cycle_count != 0 || m_memory->IsBootEnabled()) {
+				delete movie;
+				return std::pair(false, "The movie starts at power on, without the boot ROM");
+			}
+
+			m_movie = movie;
+			m_movie_recording = false;
+			m_movie_finished = false;
+
+			start_clock(movie->GetClockStart());
+
+			m_joypad->SetLatched(true);
+
+			byte pressed = 0;
+
+			if (!m_movie->Next(pressed)) {
+				m_movie_finished = true;
+				StopMovie();
+				return std::pair(true, "");
+			}
+
+			m_joypad->Latch(pressed);
+
+			return std::pair(true, "");
+		}
+
+		void EmulatorState::StopMovie() {
+			if (m_movie == nullptr)
+				return;
+
+			delete m_movie;
+
+			m_movie = nullptr;
+			m_movie_recording = false;
+			m_fixed_clock = false;
+
+			m_joypad->SetLatched(false);
+		}
+
+		bool EmulatorState::MovieFinished() const {
+			return m_movie_finished;
+		}
+
+		std::optional<int64_t> EmulatorState::FixedClock() const {
+			static constexpr uint64_t cpu_clock = 4194304;
+
+			if (!m_fixed_clock)
+				return std::nullopt;
+
+			return m_clock_start + (int64_t)((m_cycle_count - m_clock_origin) / cpu_clock);
+		}
+
+		void EmulatorState::movie_frame() {
+			if (m_movie_recording) {
+				m_movie->Append(m_movie_pressed);
+
+				m_movie_pressed = m_joypad->HostPressed();
+				m_joypad->Latch(m_movie_pressed);
+
+				return;
+			}
+
+			byte pressed = 0;
+
+			if (!m_movie->Next(pressed)) {
+				m_movie_finished = true;
+				StopMovie();
+				return;
+			}
+
+			m_joypad->Latch(pressed);
+		}
+
+		void EmulatorState::start_clock(int64_t start) {
+			m_fixed_clock = true;
+			m_clock_start = start;
+			m_clock_origin = m_cycle_count;
+		}
+
 		void EmulatorState::UseBootrom(std::string const& path) {
 			m_memory->ReadBootrom(path);
 			m_cpu->ResetIP();
 		}
+
+		std::size_t EmulatorState::StateSize() {
+			//The size never changes during emulation,
+			//so it is calculated only once
+			if (m_state_size == 0) {
+				Saves::Snapshot measure(StaticData::max_state_size);
+
+				Capture(measure);
+			}
+
+			return m_state_size;
+		}
+
+		void EmulatorState::Capture(Saves::Snapshot& snap) {
+			snap.Reserve(m_state_size == 0 ?
+				StaticData::max_state_size : m_state_size);
+
+			byte* buffer = snap.Data();
+
+			std::size_t offset = 0;
+
+			using Saves::Section;
+
+			snap.SetSectionStart(Section::cpu, offset);
+			offset = m_cpu->DumpState(buffer, offset);
+			snap.SetSectionStart(Section::memory, offset);
+			offset = m_memory->DumpState(buffer, offset);
+			snap.SetSectionStart(Section::ppu, offset);
+			offset = m_ppu->DumpState(buffer, offset);
+			snap.SetSectionStart(Section::timer, offset);
+			offset = m_timer->DumpState(buffer, offset);
+			snap.SetSectionStart(Section::serial, offset);
+			offset = m_serial->DumpState(buffer, offset);
+			snap.SetSectionStart(Section::apu, offset);
+			offset = m_apu->DumpState(buffer, offset);
+			snap.SetSectionStart(Section::cartridge, offset);
+			m_card_offset = offset;
+			offset = m_card->DumpState(buffer, offset);
+
+			m_state_size = offset;
+
+			snap.Resize(offset);
+		}
+
+		std::pair<bool, std::string> EmulatorState::Restore(Saves::Snapshot const& snap) {
+			if (snap.Size() < StateSize()) {
+				return std::pair(false, "Snapshot is too small");
+			}
+
+			const byte* buffer = snap.Data();
+
+			std::size_t offset = 0;
+
+			//Only the cartridge can refuse a state, it
+			//is loaded first so a state of another
+			//game does not overwrite half the machine
+			try {
+				m_card->LoadState(buffer, m_card_offset);
+			}
+			catch (std::runtime_error const& err) {
+				return std::pair(false, std::string(err.what()));
+			}
+
+			offset = m_cpu->LoadState(buffer, offset);
+			offset = m_memory->LoadState(buffer, offset);
+			offset = m_ppu->LoadState(buffer, offset);
+			offset = m_timer->LoadState(buffer, offset);
+			offset = m_serial->LoadState(buffer, offset);
+			offset = m_apu->LoadState(buffer, offset);
+
+			return std::pair(true, "");
+		}
+	
+		void EmulatorState::EnableRewind(bool value) {
+			m_rewind_enabled = value;
+		}
+
+		bool EmulatorState::RewindEnabled() const {
+			return m_rewind_enabled;
+		}
+
+		Saves::RewindBuffer* EmulatorState::GetRewind() {
+			return m_rewind;
+		}
+
+		void EmulatorState::Rewind(unsigned count) {
+			if (!m_rewind_enabled)
+				return;
+
+			//No emulation thread is running,
+			//it is safe to restore now
+			if (m_debugging) {
+				m_rewind->StepBack(this, count);
+				return;
+			}
+
+			m_rewind_pending += count;
+		}
+
+		void EmulatorState::SaveStateAsync(std::string const& path) {
+			//No emulation thread is running,
+			//it is safe to capture now
+			if (m_debugging) {
+				queue_save(SaveKind::state, path);
+				return;
+			}
+
+			std::scoped_lock<std::mutex> lock(m_save_mutex);
+
+			m_save_requests.push_back(std::pair(SaveKind::state, path));
+			m_save_pending = true;
+		}
+
+		std::pair<bool, std::string> EmulatorState::SaveGameAsync(std::string const& path) {
+			if (!m_card->SupportsSaves()) {
+				return std::pair(false, "Cartridge does not support saves");
+			}
+
+			if (m_debugging) {
+				queue_save(SaveKind::game, path);
+				return std::pair(true, "");
+			}
+
+			std::scoped_lock<std::mutex> lock(m_save_mutex);
+
+			m_save_requests.push_back(std::pair(SaveKind::game, path));
+			m_save_pending = true;
+
+			return std::pair(true, "");
+		}
+
+		Saves::SaveWriter* EmulatorState::GetSaveWriter() {
+			return m_writer;
+		}
+
+		Debugger::Profiler* EmulatorState::GetProfiler() {
+			return m_profiler;
+		}
+
+		void EmulatorState::ProfileGuest(bool enable) {
+			if (enable && !m_guest_sampling) {
+				m_guest_restart = true;
+			}
+
+			m_guest_sampling = enable;
+		}
+
+		bool EmulatorState::GuestProfiling() const {
+			return m_guest_sampling;
+		}
+
+		Debugger::GuestProfiler* EmulatorState::GetGuestProfiler() {
+			return m_guest_profiler;
+		}
+
+		Debugger::Tracer* EmulatorState::GetTracer() {
+			return m_tracer;
+		}
+
+		void EmulatorState::guest_sample(unsigned cycles) {
+			//The calls made while nothing was tracking
+			//them left the stack out of date
+			if (m_guest_restart.load(std::memory_order_relaxed) &&
+				m_guest_restart.exchange(false)) {
+				StacktraceClear();
+			}
+
+			if (!m_guest_profiler->Advance(cycles)) {
+				return;
+			}
+
+			word pc = m_cpu->GetIP();
+			byte bank = 0;
+
+			if (pc <= 0x7FFF) {
+				bank = m_card->GetCurrentBank(pc);
+			}
+
+			m_guest_profiler->Sample(bank, pc, m_stacktrace);
+		}
+
+		void EmulatorState::save_tasks() {
+			decltype(m_save_requests) requests;
+
+			{
+				std::scoped_lock<std::mutex> lock(m_save_mutex);
+
+				requests.swap(m_save_requests);
+				m_save_pending = false;
+			}
+
+			for (auto const& request : requests) {
+				queue_save(request.first, request.second);
+			}
+		}
+
+		void EmulatorState::queue_save(SaveKind kind, std::string const& path) {
+			if (m_writer == nullptr) {
+				m_writer = new Saves::SaveWriter(m_logger);
+			}
+
+			std::string title(m_card->GetTitle());
+
+			//Only the copy in memory is done here,
+			//the writer owns it from now on
+			if (kind == SaveKind::state) {
+				Saves::Snapshot snap{};
+
+				Capture(snap);
+
+				m_writer->Queue(path, [snap = std::move(snap), title](std::ofstream& file) {
+					return Saves::WriteState(file, snap, title);
+				});
+
+				return;
+			}
+
+			std::size_t size_kb = Cartridge::getRamKb(m_card->GetRamSize());
+
+			const byte* ram = m_card->GetRamBuffer();
+
+			std::vector<byte> copy(ram, ram + size_kb * 1024);
+
+			m_writer->Queue(path, [copy = std::move(copy), size_kb, title](std::ofstream& file) {
+				return Saves::WriteGame(file, copy.data(), size_kb, title);
+			});
+		}
 	}
 }
\ No newline at end of file
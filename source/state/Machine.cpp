@@ -0,0 +1,18 @@
+#include "../../include/state/Machine.h"
+
+namespace GameboyEmu {
+	namespace State {
+
+		Machine::Machine(EmulatorState* state, Cartridge::MemoryCard* card,
+			Sound::OutputDevice* out_dev, DataTransfer::SerialDevice* serial_dev) :
+			serial(serial_dev), apu(state, out_dev),
+			ppu(state), timer(state), joypad(),
+			memory(state, card, &ppu, &timer, &joypad, &apu, &serial),
+			cpu(state, &memory) {
+			ppu.SetMemory(&memory);
+			timer.SetMemory(&memory);
+			joypad.SetMemory(&memory);
+			serial.SetMemory(&memory);
+		}
+	}
+}
@@ -1,29 +1,42 @@
 #include "../../include/timing/RealTimeClock.h"
+#include "../../include/state/EmulatorState.h"
 
 #include <chrono>
 
 namespace GameboyEmu::Timing {
-	RealTimeClock::RealTimeClock() :
-		m_last_written(0xFF), m_seconds(0),
+	RealTimeClock::RealTimeClock(State::EmulatorState* state) :
+		m_state(state), m_last_written(0xFF), m_seconds(0),
 		m_minutes(), m_hours(), m_days(),
 		m_halt(), m_carry()
 	{}
 
 	std::tm RealTimeClock::GetTimePoint() const {
+		std::tm time_point{};
+
+		//Movies need the same time on every
+		//host, the fixed clock is in UTC
+		if (auto fixed = m_state->FixedClock()) {
+			std::time_t time = (std::time_t)*fixed;
+
+#ifdef _MSC_VER
+			gmtime_s(&time_point, &time);
+#else 
+			gmtime_r(&time, &time_point);
+#endif // _MSC_VER
+
+			return time_point;
+		}
+
 		auto now = std::chrono::system_clock::now();
 
 		std::time_t time = std::chrono::system_clock::to_time_t(now);
 
-		std::tm time_point{};
-
 #ifdef _MSC_VER
 		localtime_s(&time_point, &time);
 #else 
 		time_point = *localtime(&time);
 #endif // _MSC_VER
 
-		
-
 		return time_point;
 	}
 
@@ -1,40 +1,114 @@
 #include "../../include/timing/Timer.h"
 #include "../../include/memory/Memory.h"
+#include "../../include/state/EmulatorState.h"
+
+#include <limits>
 
 namespace GameboyEmu {
 	namespace Timing {
 
-		Timer::Timer() : m_divider(0),
-			m_tima(0), m_tma(0), m_enable(0), m_clock_select(0),
-			m_real_clock_cycle(0), m_current_cycles(0),
-			m_divider_cycles(0), m_mem(nullptr) {}
+		Timer::Timer(State::EmulatorState* state) : m_state(state),
+			m_counter_base(0), m_tima(0), m_tima_time(0),
+			m_tma(0), m_enable(0), m_clock_select(0),
+			m_real_clock_cycle(1024),
+			m_next_event(std::numeric_limits<uint64_t>::max()),
+			m_mem(nullptr) {}
 
 		void Timer::SetMemory(Mem::Memory* mmu) {
 			m_mem = mmu;
 		}
 
+		uint64_t Timer::now() const {
+			return m_state->GetCycleCount();
+		}
+
+		bool Timer::signal(uint64_t time) const {
+			return m_enable && (counter(time) & (m_real_clock_cycle >> 1));
+		}
+
+		uint64_t Timer::edges(uint64_t from, uint64_t to) const {
+			if (!m_enable)
+				return 0;
+
+			//TIMA is incremented each time the counter
+			//reaches a multiple of the period
+			return counter(to) / m_real_clock_cycle -
+				counter(from) / m_real_clock_cycle;
+		}
+
+		void Timer::increment(uint64_t count) {
+			while (count > 0) {
+				unsigned room = 0x100 - m_tima;
+
+				if (count < room) {
+					m_tima += (byte)count;
+					return;
+				}
+
+				count -= room;
+
+				m_tima = m_tma;
+
+				m_mem->GetInterrupts().Raise(Mem::Interrupt::timer);
+			}
+		}
+
+		void Timer::sync(uint64_t time) {
+			increment(edges(m_tima_time, time));
+
+			m_tima_time = time;
+		}
+
+		void Timer::schedule() {
+			if (!m_enable) {
+				m_next_event = std::numeric_limits<uint64_t>::max();
+				return;
+			}
+
+			uint64_t periods = counter(m_tima_time) / m_real_clock_cycle;
+
+			m_next_event = m_counter_base +
+				(periods + (0x100 - m_tima)) * m_real_clock_cycle;
+		}
+
+		void Timer::Update() {
+			sync(now());
+			schedule();
+		}
+
 		void Timer::SetDiv(byte) {
-			m_divider = 0;
-			m_divider_cycles = 0;
+			uint64_t time = now();
+
+			sync(time);
+
+			//The selected bit falls if it was set
+			if (signal(time)) {
+				increment(1);
+			}
+
+			m_counter_base = time;
+
+			schedule();
 		}
 
 		void Timer::SetTima(byte value) {
+			sync(now());
+
 			m_tima = value;
-			//current_cycles = 0;
+
+			schedule();
 		}
 
 		void Timer::SetTma(byte value) {
-			m_tma = value;
-		}
+			sync(now());
 
-		void Timer::SetTAC(byte options) {
-			//bit 2 is timer enable
-			m_enable = (options >> 2) & 1;
+			m_tma = value;
 
-			//bit 0-1 is clock cycle
-			m_clock_select = (options & 0b11);
+			schedule();
+		}
 
-			m_current_cycles = 0;
+		void Timer::set_clock_select(byte select) {
+			m_clock_select = select;
 
 			switch (m_clock_select)
 			{
@@ -53,89 +127,99 @@ namespace GameboyEmu {
 			}
 		}
 
-		byte Timer::GetDiv() const {
-			return m_divider;
-		}
-
-		byte Timer::GetTima() const {
-			return m_tima;
-		}
+		void Timer::SetTAC(byte options) {
+			uint64_t time = now();
 
-		byte Timer::GetTma() const {
-			return m_tma;
-		}
+			sync(time);
 
-		byte Timer::GetTAC() const {
-			return (m_enable << 2) | m_clock_select;
-		}
+			bool was_high = signal(time);
 
-		void Timer::Tick(byte mcycles) {
-			unsigned tstates = mcycles * 4;
+			//bit 2 is timer enable
+			m_enable = (options >> 2) & 1;
 
-			m_divider_cycles += tstates;
+			//bit 0-1 is clock cycle
+			set_clock_select(options & 0b11);
 
-			if (m_divider_cycles >= 256) {
-				m_divider++;
-				m_divider_cycles -= 256;
+			//Disabling the timer or selecting a bit
+			//that is not set is a falling edge
+			if (was_high && !signal(time)) {
+				increment(1);
 			}
 
-			if (!m_enable)
-				return;
-
-			m_current_cycles += tstates;
+			schedule();
+		}
 
-			if (m_current_cycles >=
-				m_real_clock_cycle) {
-				m_tima++;
+		byte Timer::GetDiv() const {
+			return (byte)(counter(now()) >> 8);
+		}
 
-				m_current_cycles -= m_real_clock_cycle;
+		byte Timer::GetTima() const {
+			//The overflows have been served by Update
+			uint64_t value = m_tima + edges(m_tima_time, now());
 
-				if (m_tima == 0) {
-					m_tima = m_tma;
+			if (value <= 0xFF) {
+				return (byte)value;
+			}
 
-					byte ir = m_mem->Read(0xFF0F);
+			return (byte)(m_tma + (value - 0x100) % (0x100 - m_tma));
+		}
 
-					TIMER_BIT_SET(ir);
+		byte Timer::GetTma() const {
+			return m_tma;
+		}
 
-					m_mem->Write(0xFF0F, ir);
-				}
-			}
+		byte Timer::GetTAC() const {
+			return (m_enable << 2) | m_clock_select;
 		}
 
+		/*
+		* The layout is the one of the cycle counting timer :
+		* DIV, TIMA, TMA, enable, clock select, period,
+		* position in the period and in the DIV increment
+		*/
 		std::size_t Timer::DumpState(byte* buffer, std::size_t offset) {
-			buffer[offset] = m_divider;
-			buffer[offset + 1] = m_tima;
+			uint64_t time = now();
+			uint64_t system = counter(time) & 0xFFFF;
+
+			buffer[offset] = (byte)(system >> 8);
+			buffer[offset + 1] = GetTima();
 			buffer[offset + 2] = m_tma;
 			buffer[offset + 3] = m_enable;
 			buffer[offset + 4] = m_clock_select;
 
+			unsigned position = (unsigned)(system % m_real_clock_cycle);
+
 			WriteWord(buffer, offset + 5, (word)(m_real_clock_cycle & 0xFFFF));
 			WriteWord(buffer, offset + 7, (word)((m_real_clock_cycle >> 16) & 0xFFFF));
-			WriteWord(buffer, offset + 9, (word)(m_current_cycles & 0xFFFF));
-			WriteWord(buffer, offset + 11, (word)((m_current_cycles >> 16) & 0xFFFF));
-			WriteWord(buffer, offset + 13, (word)(m_divider_cycles & 0xFFFF));
-			WriteWord(buffer, offset + 15, (word)((m_divider_cycles >> 16) & 0xFFFF));
+			WriteWord(buffer, offset + 9, (word)(position & 0xFFFF));
+			WriteWord(buffer, offset + 11, (word)((position >> 16) & 0xFFFF));
+			WriteWord(buffer, offset + 13, (word)(system & 0xFF));
+			WriteWord(buffer, offset + 15, 0);
 
 			return offset + 17;
 		}
 
-		std::size_t Timer::LoadState(byte* buffer, std::size_t offset) {
-			m_divider = buffer[offset];
+		std::size_t Timer::LoadState(const byte* buffer, std::size_t offset) {
+			uint64_t time = now();
+
+			word system = (word)((buffer[offset] << 8) |
+				(ReadWord(buffer, offset + 13) & 0xFF));
+
+			//The clock is not saved, the counter is
+			//rebased on the current cycle
+			m_counter_base = time - system;
+
 			m_tima = buffer[offset + 1];
+			m_tima_time = time;
+
 			m_tma = buffer[offset + 2];
 			m_enable = buffer[offset + 3];
-			m_clock_select = buffer[offset + 4];
-
-			m_real_clock_cycle =  ReadWord(buffer, offset + 5);
-			m_real_clock_cycle |= (ReadWord(buffer, offset + 7) << 16);
 
-			m_current_cycles = ReadWord(buffer, offset + 9);
-			m_current_cycles |= (ReadWord(buffer, offset + 11) << 16);
+			set_clock_select(buffer[offset + 4] & 0b11);
 
-			m_divider_cycles = ReadWord(buffer, offset + 13);
-			m_divider_cycles |= (ReadWord(buffer, offset + 15) << 16);
+			schedule();
 
 			return offset + 17;
 		}
 	}
-}
\ No newline at end of file
+}
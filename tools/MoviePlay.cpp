@@ -0,0 +1,138 @@
+#include "../include/state/EmulatorState.h"
+#include "../include/save/Snapshot.h"
+#include "../include/logging/Logger.h"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+using GameboyEmu::State::EmulatorState;
+using GameboyEmu::Saves::Snapshot;
+
+namespace {
+	//FNV-1a, 64 bits
+	uint64_t hash_bytes(const byte* data, std::size_t size,
+		uint64_t hash = 0xCBF29CE484222325ull) {
+		for (std::size_t i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 0x100000001B3ull;
+		}
+
+		return hash;
+	}
+}
+
+/*
+* Plays a movie headless, as fast as possible, and
+* prints the hash of the final state : the same movie
+* must always give the same hash, whatever the host
+* or the idle loop skipping
+*/
+int main(int argc, char** argv) {
+	std::string rom{};
+	std::string movie{};
+	std::string expect{};
+	std::string log_file{};
+	bool idle_skip = true;
+	bool usage = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg{ argv[i] };
+
+		if (arg.starts_with("--expect=")) {
+			expect = arg.substr(9);
+		}
+		else if (arg.starts_with("--log-file=")) {
+			log_file = arg.substr(11);
+		}
+		else if (arg == "--no-idle-skip") {
+			idle_skip = false;
+		}
+		else if (rom.empty() && !arg.starts_with("--")) {
+			rom = arg;
+		}
+		else if (movie.empty() && !arg.starts_with("--")) {
+			movie = arg;
+		}
+		else {
+			usage = true;
+			break;
+		}
+	}
+
+	if (usage || rom.empty() || movie.empty()) {
+		fmt::print(stderr, "Usage : {} rom movie [--expect=hash] "
+			"[--no-idle-skip] [--log-file=path]\n", argv[0]);
+		return 1;
+	}
+
+	Logger log{};
+
+	if (!log_file.empty()) {
+		if (auto res = log.set_file(log_file); !res.first) {
+			fmt::print(stderr, "Cannot open the log file : {}\n", res.second);
+			return 1;
+		}
+	}
+
+	EmulatorState emu{ rom, log };
+
+	if (!emu.Ok()) {
+		log.flush();
+		fmt::print(stderr, "{}\n", emu.GetMessage());
+		return 1;
+	}
+
+	emu.SetIdleSkip(idle_skip);
+
+	auto res = emu.PlayMovie(movie);
+
+	if (!res.first) {
+		log.flush();
+		fmt::print(stderr, "Cannot play the movie : {}\n", res.second);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	uint64_t frames = emu.GetFrameCount();
+
+	while (!emu.MovieFinished() && emu.Ok()) {
+		emu.RunFrame();
+	}
+
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start
+	).count();
+
+	frames = emu.GetFrameCount() - frames;
+
+	Snapshot snap{};
+
+	emu.Capture(snap);
+
+	uint64_t state_hash = hash_bytes(snap.Data(), snap.Size());
+
+	const byte* frame = emu.GetFramebuffer();
+	uint64_t frame_hash = frame != nullptr ?
+		hash_bytes(frame, 160 * 144) : 0;
+
+	log.flush();
+
+	std::string hash = fmt::format("{:016x}", state_hash);
+
+	fmt::print("frames {} in {:.3f} s, {:.0f} fps\n", frames, seconds,
+		seconds > 0 ? frames / seconds : 0.0);
+	fmt::print("frame {:016x}\n", frame_hash);
+	fmt::print("state {}\n", hash);
+
+	if (!expect.empty() && expect != hash) {
+		fmt::print(stderr, "Mismatch : expected {}\n", expect);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include "../include/debugger/Tracer.h"
+
+#include <fmt/format.h>
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+using GameboyEmu::Debugger::Tracer;
+using GameboyEmu::Debugger::TraceRecord;
+
+/*
+* Prints the instructions of a trace written by
+* "trace dump" or "trace stream", oldest first
+*/
+int main(int argc, char** argv) {
+	std::string path{};
+	std::size_t last = 0;
+	bool usage = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg{ argv[i] };
+
+		if (arg.starts_with("--last=")) {
+			auto value = arg.substr(7);
+			auto res = std::from_chars(value.data(), value.data() + value.size(), last);
+
+			//The whole value must be a count
+			if (value.empty() || res.ec != std::errc{} ||
+				res.ptr != value.data() + value.size()) {
+				usage = true;
+				break;
+			}
+		}
+		else if (path.empty() && !arg.starts_with("--")) {
+			path = arg;
+		}
+		else {
+			usage = true;
+			break;
+		}
+	}
+
+	if (usage || path.empty()) {
+		fmt::print(stderr, "Usage : {} trace_file [--last=count]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<TraceRecord> records{};
+
+	auto res = Tracer::ReadFile(path, records);
+
+	if (!res.first) {
+		fmt::print(stderr, "{}\n", res.second);
+		return 1;
+	}
+
+	std::size_t first = 0;
+
+	if (last != 0 && records.size() > last) {
+		first = records.size() - last;
+	}
+
+	for (std::size_t i = first; i < records.size(); i++) {
+		fmt::print("{}\n", Tracer::Format(records[i]));
+	}
+
+	fmt::print(stderr, "{} records\n", records.size());
+
+	return 0;
+}